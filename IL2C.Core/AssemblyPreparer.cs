@@ -141,12 +141,23 @@ namespace IL2C
             var leaveContinuations = decodeContext.
                 ExtractLeaveContinuations();
 
+            // Analyze objref lifetimes, it makes the execution frame smaller (or elides it.)
+            var (objRefSlots, objRefSpills, residentObjRefs, requiresExecutionFrame) = ExecutionFrameAnalyzer.Analyze(
+                method,
+                stacks,
+                catchVariables,
+                decodeContext.ExtractCodeAccesses());
+
             return new PreparedMethodInformation(
                 method,
                 stacks,
                 labelNames,
                 catchVariables,
                 leaveContinuations,
+                objRefSlots,
+                objRefSpills,
+                residentObjRefs,
+                requiresExecutionFrame,
                 emitters);
         }
 
@@ -228,6 +239,10 @@ namespace IL2C
                     null,
                     null,
                     null,
+                    null,
+                    null,
+                    null,
+                    false,
                     null);
             }
 
@@ -45,6 +45,7 @@ namespace IL2C
             TranslateContext translateContext,
             PreparedInformations prepared,
             bool enableBundler,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOption)
         {
             var sourceFilePaths = new List<string>();
@@ -56,7 +57,8 @@ namespace IL2C
                 storage,
                 translateContext,
                 prepared,
-                assemblyName);
+                assemblyName,
+                enableConservativeStackScanning);
 
             // Write assembly level common internal source code.
             sourceFilePaths.Add(
@@ -83,6 +85,7 @@ namespace IL2C
                         storage,
                         translateContext,
                         prepared,
+                        enableConservativeStackScanning,
                         debugInformationOption));
             }
 
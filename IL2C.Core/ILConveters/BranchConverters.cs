@@ -16,9 +16,11 @@ namespace IL2C.ILConverters
         public override ExpressionEmitter Prepare(
             ICodeInformation operand, DecodeContext decodeContext)
         {
+            var poll = BranchExpressionUtilities.IsBackwardBranch(operand, decodeContext);
             var labelName = decodeContext.EnqueueNewPath(operand.Offset);
 
-            return (_, __) => new[] { string.Format("goto {0}", labelName) };
+            return (_, emitContext) => BranchExpressionUtilities.WithSafepointPoll(
+                poll, string.Format("goto {0}", labelName), emitContext);
         }
     }
 
@@ -31,45 +33,62 @@ namespace IL2C.ILConverters
         public override ExpressionEmitter Prepare(
             ICodeInformation operand, DecodeContext decodeContext)
         {
+            var poll = BranchExpressionUtilities.IsBackwardBranch(operand, decodeContext);
             var labelName = decodeContext.EnqueueNewPath(operand.Offset);
 
-            return (_, __) => new[] { string.Format("goto {0}", labelName) };
+            return (_, emitContext) => BranchExpressionUtilities.WithSafepointPoll(
+                poll, string.Format("goto {0}", labelName), emitContext);
         }
     }
 
     internal static class BranchExpressionUtilities
     {
+        // The loop back-edge (branch to same or lower offset) is the safepoint,
+        // so the thread running the loop without calls and allocations can stop for the GC.
+        public static bool IsBackwardBranch(
+            ICodeInformation operand, DecodeContext decodeContext) =>
+            operand.Offset <= decodeContext.CurrentCode.Offset;
+
+        // The objrefs kept in the C local variables are spilled to the execution frame only if GC is requested.
+        public static string[] WithSafepointPoll(bool poll, string expression, ExpressionEmitContext emitContext) =>
+            poll ?
+                ((emitContext.SafepointSpills.Length >= 1) ?
+                    new[] { string.Format("il2c_poll_safepoint_with_spill({0})", string.Join(", ", emitContext.SafepointSpills)), expression } :
+                    new[] { "il2c_poll_safepoint()", expression }) :
+                new[] { expression };
+
         public static ExpressionEmitter ApplyFalse(
             ICodeInformation operand, string oper, DecodeContext decodeContext)
         {
             var si = decodeContext.PopStack();
 
+            var poll = IsBackwardBranch(operand, decodeContext);
             var labelName = decodeContext.EnqueueNewPath(operand.Offset);
 
             if (si.TargetType.IsBooleanType)
             {
-                return (extractContext, _) => new[] { string.Format(
+                return (extractContext, emitContext) => WithSafepointPoll(poll, string.Format(
                     "if ({0} {1} false) goto {2}",
                     extractContext.GetSymbolName(si),
                     oper,
-                    labelName) };
+                    labelName), emitContext);
             }
             else if (si.TargetType.IsNumericPrimitive ||
                 si.TargetType.IsEnum)
             {
-                return (extractContext, _) => new[] { string.Format(
+                return (extractContext, emitContext) => WithSafepointPoll(poll, string.Format(
                     "if ({0} {1} 0) goto {2}",
                     extractContext.GetSymbolName(si),
                     oper,
-                    labelName) };
+                    labelName), emitContext);
             }
             else
             {
-                return (extractContext, _) => new[] { string.Format(
+                return (extractContext, emitContext) => WithSafepointPoll(poll, string.Format(
                     "if ({0} {1} NULL) goto {2}",
                     extractContext.GetSymbolName(si),
                     oper,
-                    labelName) };
+                    labelName), emitContext);
             }
         }
 
@@ -79,14 +98,15 @@ namespace IL2C.ILConverters
             var si1 = decodeContext.PopStack();
             var si0 = decodeContext.PopStack();
 
+            var poll = IsBackwardBranch(operand, decodeContext);
             var labelName = decodeContext.EnqueueNewPath(operand.Offset);
 
-            return (extractContext, _) => new[] { string.Format(
+            return (extractContext, emitContext) => WithSafepointPoll(poll, string.Format(
                 "if ({0} {1} {2}) goto {3}",
                 extractContext.GetSymbolName(si0),
                 oper,
                 extractContext.GetSymbolName(si1),
-                labelName) };
+                labelName), emitContext);
         }
     }
 
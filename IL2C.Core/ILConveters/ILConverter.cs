@@ -10,11 +10,14 @@ namespace IL2C.ILConverters
     internal sealed class ExpressionEmitContext
     {
         public readonly bool ExecutionFrameEmitted;
+        public readonly string[] SafepointSpills;
 
         public ExpressionEmitContext(
-            bool executionFrameEmitted)
+            bool executionFrameEmitted,
+            string[] safepointSpills)
         {
             this.ExecutionFrameEmitted = executionFrameEmitted;
+            this.SafepointSpills = safepointSpills;
         }
     }
 
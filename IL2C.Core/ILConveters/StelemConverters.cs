@@ -94,7 +94,9 @@ namespace IL2C.ILConverters
                     extractContext.GetSymbolName(siArray),
                     siArray.TargetType.ElementType.CLanguageTypeName,
                     extractContext.GetSymbolName(siIndex),
-                    extractContext.GetRightExpression(siArray.TargetType.ElementType, siValue)) };
+                    extractContext.GetRightExpression(siArray.TargetType.ElementType, siValue)),
+                string.Format("il2c_write_barrier({0})",
+                    extractContext.GetSymbolName(siArray)) };
         }
     }
 
@@ -138,12 +140,27 @@ namespace IL2C.ILConverters
                     siValue.TargetType.FriendlyName);
             }
 
-            return (extractContext, _) => new[] {
-                string.Format("il2c_array_item({0}, {1}, {2}) = {3}",
+            return (extractContext, _) =>
+            {
+                var storeExpression = string.Format("il2c_array_item({0}, {1}, {2}) = {3}",
                     extractContext.GetSymbolName(siArray),
                     operand.CLanguageTypeName,
                     extractContext.GetSymbolName(siIndex),
-                    extractContext.GetRightExpression(siArray.TargetType.ElementType, siValue)) };
+                    extractContext.GetRightExpression(siArray.TargetType.ElementType, siValue));
+
+                // The generational GC requires the write barrier if stored value contains objref.
+                if (operand.IsRequiredTraverse)
+                {
+                    return new[] {
+                        storeExpression,
+                        string.Format("il2c_write_barrier({0})",
+                            extractContext.GetSymbolName(siArray)) };
+                }
+                else
+                {
+                    return new[] { storeExpression };
+                }
+            };
         }
     }
 }
@@ -65,11 +65,34 @@ namespace IL2C.ILConverters
                         field.FieldType.FriendlyName);
                 }
 
-                return new[] { string.Format(
+                var storeExpression = string.Format(
                     "{0}->{1} = {2}",
                     extractContext.GetSymbolName(siReference),
                     field.MangledName,
-                    rightExpression) };
+                    rightExpression);
+
+                // The generational GC requires the write barrier if stored value contains objref.
+                if (!field.FieldType.IsRequiredTraverse)
+                {
+                    return new[] { storeExpression };
+                }
+                else if (siReference.TargetType.IsByReference)
+                {
+                    return new[] {
+                        storeExpression,
+                        string.Format(
+                            "il2c_write_barrier_for_address(&{0}->{1})",
+                            extractContext.GetSymbolName(siReference),
+                            field.MangledName) };
+                }
+                else
+                {
+                    return new[] {
+                        storeExpression,
+                        string.Format(
+                            "il2c_write_barrier({0})",
+                            extractContext.GetSymbolName(siReference)) };
+                }
             };
         }
     }
@@ -94,6 +117,9 @@ namespace IL2C.ILConverters
         {
             Debug.Assert(field.IsStatic);
 
+            // NOTE: The static fields don't need the write barrier,
+            //   because the GC traverses them at every collection (as roots.)
+
             var targetType = field.FieldType;
             var symbol = decodeContext.PopStack();
 
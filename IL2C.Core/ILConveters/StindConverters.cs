@@ -54,10 +54,25 @@ namespace IL2C.ILConverters
                     siValue.TargetType.FriendlyName);
                 }
 
-                return new[] { string.Format(
+                var storeExpression = string.Format(
                     "*{0} = {1}",
                     extractContext.GetSymbolName(siReference),
-                    rightExpression) };
+                    rightExpression);
+
+                // The generational GC requires the write barrier if stored value contains objref.
+                //   The managed reference may point to the stack, static field or inside of the instance.
+                if (siReference.TargetType.ElementType.IsRequiredTraverse)
+                {
+                    return new[] {
+                        storeExpression,
+                        string.Format(
+                            "il2c_write_barrier_for_address({0})",
+                            extractContext.GetSymbolName(siReference)) };
+                }
+                else
+                {
+                    return new[] { storeExpression };
+                }
             };
         }
     }
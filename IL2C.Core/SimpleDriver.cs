@@ -10,6 +10,7 @@ namespace IL2C
             CodeTextStorage storage,
             bool readSymbols,
             bool enableBundler,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOptions,
             string assemblyPath)
         {
@@ -35,6 +36,7 @@ namespace IL2C
                     translateContext,
                     preparedFunctions,
                     enableBundler,
+                    enableConservativeStackScanning,
                     debugInformationOptions);
             }
         }
@@ -44,6 +46,7 @@ namespace IL2C
             CodeTextStorage storage,
             bool readSymbols,
             bool enableBundler,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOptions,
             IEnumerable<string> assemblyPaths)
         {
@@ -54,6 +57,7 @@ namespace IL2C
                     storage,
                     readSymbols,
                     enableBundler,
+                    enableConservativeStackScanning,
                     debugInformationOptions,
                     aseemblyPath);
             }
@@ -64,6 +68,7 @@ namespace IL2C
             CodeTextStorage storage,
             bool readSymbols,
             bool enableBundler,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOptions,
             params string[] assemblyPaths)
         {
@@ -72,6 +77,7 @@ namespace IL2C
                 storage,
                 readSymbols,
                 enableBundler,
+                enableConservativeStackScanning,
                 debugInformationOptions,
                 (IEnumerable<string>)assemblyPaths);
         }
@@ -82,6 +88,7 @@ namespace IL2C
             bool readSymbols,
             bool enableCpp,
             bool enableBundler,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOptions,
             IEnumerable<string> assemblyPaths)
         {
@@ -98,6 +105,7 @@ namespace IL2C
                     storage,
                     readSymbols,
                     enableBundler,
+                    enableConservativeStackScanning,
                     debugInformationOptions,
                     aseemblyPath);
             }
@@ -109,6 +117,7 @@ namespace IL2C
             bool readSymbols,
             bool enableCpp,
             bool enableBundler,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOptions,
             params string[] assemblyPaths)
         {
@@ -118,6 +127,7 @@ namespace IL2C
                 readSymbols,
                 enableCpp,
                 enableBundler,
+                enableConservativeStackScanning,
                 debugInformationOptions,
                 (IEnumerable<string>)assemblyPaths);
         }
@@ -88,6 +88,14 @@ namespace IL2C.Translators
                     ToArray();
             }
         }
+
+        // The evaluation stacks accessed by the code, and the successors of the code.
+        private sealed class CodeAccessHolder
+        {
+            public readonly List<ILocalVariableInformation> Uses = new List<ILocalVariableInformation>();
+            public readonly List<ILocalVariableInformation> Defs = new List<ILocalVariableInformation>();
+            public readonly List<int> Successors = new List<int>();
+        }
         #endregion
 
         #region Fields
@@ -113,6 +121,9 @@ namespace IL2C.Translators
             new Dictionary<int, (HashSet<int> fromOffsets, int continuationIndex)>();
         private readonly Queue<StackSnapshot> pathRemains =
             new Queue<StackSnapshot>();
+        private readonly Dictionary<int, CodeAccessHolder> codeAccessesAtOffset =
+            new Dictionary<int, CodeAccessHolder>();
+        private CodeAccessHolder currentCodeAccess;
         #endregion
 
         public DecodeContext(
@@ -164,17 +175,24 @@ namespace IL2C.Translators
         #region Instruction
         public bool MoveNext()
         {
+            // The previous code (isn't end of path) continues to next code.
+            currentCodeAccess?.Successors.Add(nextOffset);
+
             // Finish if current position already decoded.
             if (stackSnapshortsAtOffset.TryGetValue(nextOffset, out var stackSnapshot))
             {
                 currentCode = null;
                 prefixCode = null;
+                currentCodeAccess = null;
                 return false;
             }
 
             stackSnapshot = new StackSnapshot(nextOffset, stackPointer, stackList);
             stackSnapshortsAtOffset.Add(nextOffset, stackSnapshot);
 
+            currentCodeAccess = new CodeAccessHolder();
+            codeAccessesAtOffset.Add(nextOffset, currentCodeAccess);
+
             if (this.Method.CodeStream.TryGetValue(nextOffset, out var codeInformation) == false)
             {
                 throw new InvalidProgramSequenceException(
@@ -252,7 +270,10 @@ namespace IL2C.Translators
 
             stackPointer++;
 
-            return stackInformationHolder.GetOrAdd(targetType, method, hintInformation);
+            var stackInformation = stackInformationHolder.GetOrAdd(targetType, method, hintInformation);
+            currentCodeAccess.Defs.Add(stackInformation);
+
+            return stackInformation;
         }
 
         public ILocalVariableInformation PushStack(ITypeInformation targetType, object hintInformation = null)
@@ -279,7 +300,11 @@ namespace IL2C.Translators
             }
 
             stackPointer--;
-            return stackList[stackPointer].GetCurrent();
+
+            var stackInformation = stackList[stackPointer].GetCurrent();
+            currentCodeAccess.Uses.Add(stackInformation);
+
+            return stackInformation;
         }
         #endregion
 
@@ -296,6 +321,7 @@ namespace IL2C.Translators
 
             pathRemains.Enqueue(new StackSnapshot(
                 targetOffset, stackPointer, stackList));
+            currentCodeAccess.Successors.Add(targetOffset);
 
             if (labelNames.TryGetValue(
                 targetOffset, out var labelName) == false)
@@ -360,6 +386,7 @@ namespace IL2C.Translators
                 // Start next path.
                 decodingPathNumber++;
                 prefixCode = null;
+                currentCodeAccess = null;
                 nextOffset = beforeBranchStackSnapshot.Offset;
 
                 // Retreive stack informations.
@@ -379,6 +406,7 @@ namespace IL2C.Translators
 
             nextOffset = -1;
             prefixCode = null;
+            currentCodeAccess = null;
             return false;
         }
         #endregion
@@ -393,6 +421,10 @@ namespace IL2C.Translators
         public IReadOnlyDictionary<int, ILocalVariableInformation> ExtractCatchVariables() =>
             catchVariables;
 
+        public IReadOnlyDictionary<int, (ILocalVariableInformation[] uses, ILocalVariableInformation[] defs, int[] successors)> ExtractCodeAccesses() =>
+            codeAccessesAtOffset.
+                ToDictionary(entry => entry.Key, entry => (entry.Value.Uses.ToArray(), entry.Value.Defs.ToArray(), entry.Value.Successors.ToArray()));
+
         public IReadOnlyDictionary<int, (ISet<int> fromOffsets, int targetOffset)> ExtractLeaveContinuations() =>
             leaveContinuationsByTarget.
                 ToDictionary(entry => entry.Value.continuationIndex, entry => ((ISet<int>)entry.Value.fromOffsets, entry.Key));
@@ -0,0 +1,525 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+
+using Mono.Cecil.Cil;
+
+using IL2C.Metadata;
+
+namespace IL2C.Translators
+{
+    // The liveness analysis for the objref local variables, evaluation stacks and arguments.
+    //   1. Calculates the live variables at each IL offset (backward data flow.)
+    //   2. Assigns the frame slots by coloring the interference graph,
+    //      the variables not live at same time will share the frame slot.
+    //   3. Calculates the slots have to clear at the GC points (forward data flow),
+    //      the slot holds the dead reference will be nulled before GC can reach it.
+    //   4. Decides the execution frame is required,
+    //      it isn't required if all objrefs are dead at every GC point.
+    //   5. Decides the objrefs kept in the C local variables,
+    //      these are spilled to the slots only at the GC points.
+    //      The overwritten arguments are always the C parameters, so they're spilled too.
+    internal static class ExecutionFrameAnalyzer
+    {
+        private struct CodeAccess
+        {
+            public readonly ICodeInformation Code;
+            public readonly int[] Uses;
+            public readonly int[] Defs;
+            public readonly int[] Successors;
+            public readonly bool IsGCPoint;
+
+            public CodeAccess(ICodeInformation code, int[] uses, int[] defs, int[] successors, bool isGCPoint)
+            {
+                this.Code = code;
+                this.Uses = uses;
+                this.Defs = defs;
+                this.Successors = successors;
+                this.IsGCPoint = isGCPoint;
+            }
+        }
+
+        private static int? GetLocalIndex(ICodeInformation code, out bool isUse, out bool isAddress)
+        {
+            isUse = false;
+            isAddress = false;
+
+            switch (code.OpCode.Code)
+            {
+                case Code.Ldloc_0: isUse = true; return 0;
+                case Code.Ldloc_1: isUse = true; return 1;
+                case Code.Ldloc_2: isUse = true; return 2;
+                case Code.Ldloc_3: isUse = true; return 3;
+                case Code.Stloc_0: return 0;
+                case Code.Stloc_1: return 1;
+                case Code.Stloc_2: return 2;
+                case Code.Stloc_3: return 3;
+                case Code.Ldloc_S:
+                case Code.Ldloc:
+                    isUse = true;
+                    return ((IVariableInformation)code.Operand).Index;
+                case Code.Stloc_S:
+                case Code.Stloc:
+                    return ((IVariableInformation)code.Operand).Index;
+                case Code.Ldloca_S:
+                case Code.Ldloca:
+                    isAddress = true;
+                    return ((IVariableInformation)code.Operand).Index;
+                default:
+                    return null;
+            }
+        }
+
+        private static int? GetArgumentIndex(ICodeInformation code, out bool isUse, out bool isAddress)
+        {
+            isUse = false;
+            isAddress = false;
+
+            switch (code.OpCode.Code)
+            {
+                case Code.Ldarg_0: isUse = true; return 0;
+                case Code.Ldarg_1: isUse = true; return 1;
+                case Code.Ldarg_2: isUse = true; return 2;
+                case Code.Ldarg_3: isUse = true; return 3;
+                case Code.Ldarg_S:
+                case Code.Ldarg:
+                    isUse = true;
+                    return ((IVariableInformation)code.Operand).Index;
+                case Code.Starg_S:
+                case Code.Starg:
+                    return ((IVariableInformation)code.Operand).Index;
+                case Code.Ldarga_S:
+                case Code.Ldarga:
+                    isAddress = true;
+                    return ((IVariableInformation)code.Operand).Index;
+                default:
+                    return null;
+            }
+        }
+
+        // The GC will run at the calls (include the allocations and the type initializers)
+        // and the safepoint polls at the backward branches.
+        // The throw is too, because the exception handler (or the unhandled exception event) may run the managed code.
+        private static bool IsGCPoint(ICodeInformation code)
+        {
+            switch (code.OpCode.FlowControl)
+            {
+                case FlowControl.Call:
+                    return true;
+                case FlowControl.Branch:
+                case FlowControl.Cond_Branch:
+                    return (code.Operand is ICodeInformation target) && (target.Offset <= code.Offset);
+            }
+
+            switch (code.OpCode.Code)
+            {
+                case Code.Newarr:
+                case Code.Box:
+                case Code.Ldsfld:
+                case Code.Ldsflda:
+                case Code.Stsfld:
+                case Code.Throw:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // The branch converters poll the safepoint at the backward branches (except leave.)
+        private static bool IsSafepointPoll(ICodeInformation code)
+        {
+            switch (code.OpCode.Code)
+            {
+                case Code.Leave:
+                case Code.Leave_S:
+                    return false;
+            }
+
+            switch (code.OpCode.FlowControl)
+            {
+                case FlowControl.Branch:
+                case FlowControl.Cond_Branch:
+                    return (code.Operand is ICodeInformation target) && (target.Offset <= code.Offset);
+                default:
+                    return false;
+            }
+        }
+
+        private static bool Interferes(HashSet<int>[] interferences, IEnumerable<int> members, int variableIndex) =>
+            members.Any(memberIndex => interferences[memberIndex].Contains(variableIndex));
+
+        public static (ExecutionFrameSlot[] slots, IReadOnlyDictionary<int, ExecutionFrameSpill> spills, ISet<ILocalVariableInformation> residents, bool requiresExecutionFrame) Analyze(
+            IMethodInformation method,
+            ILocalVariableInformation[] stacks,
+            IReadOnlyDictionary<int, ILocalVariableInformation> catchVariables,
+            IReadOnlyDictionary<int, (ILocalVariableInformation[] uses, ILocalVariableInformation[] defs, int[] successors)> codeAccesses)
+        {
+            var locals = method.LocalVariables;
+            var codeStream = method.CodeStream;
+            var hasExceptionHandlers = codeStream.ExceptionHandlers.Length >= 1;
+
+            // The objref arguments are the caller's values and the caller holds them while the method runs
+            // (the managed caller spills them at the call, the delegate invoker and the thread entry point hold them in its frame.)
+            // But the overwritten arguments (starg or took the address) hold the values the caller doesn't know,
+            // so these are treated as the variables defined at the entry point.
+            var writtenArgumentIndexes = new HashSet<int>();
+            foreach (var offset in codeAccesses.Keys)
+            {
+                if (codeStream.TryGetValue(offset, out var code) &&
+                    (GetArgumentIndex(code, out var isUse, out var _) is int index) &&
+                    !isUse)
+                {
+                    writtenArgumentIndexes.Add(index);
+                }
+            }
+            var arguments = method.Parameters.
+                Where(p => p.TargetType.IsReferenceType && !p.TargetType.IsByReference).  // Only objref
+                Where(p => writtenArgumentIndexes.Contains(p.Index)).
+                ToDictionary(
+                    p => p.Index,
+                    p => (ILocalVariableInformation)new LocalVariableInformation(
+                        method, p.Index, p.ParameterName, p.TargetType));
+
+            var variables = locals.
+                Concat(stacks).
+                Where(v => v.TargetType.IsReferenceType).  // Only objref
+                Concat(arguments.Values).
+                ToArray();
+            var variableIndexes = variables.
+                Select((variable, index) => (variable, index)).
+                ToDictionary(entry => entry.variable, entry => entry.index);
+            var argumentIndexes = new HashSet<int>(
+                arguments.Values.Select(argument => variableIndexes[argument]));
+
+            // The pinned variables don't share the slot and aren't nulled:
+            //   * The local variables in the method has exception handlers,
+            //     because the control flows by the exceptions aren't traced.
+            //   * The local variables took the address.
+            //   * The catch variables, these are assigned by the exception handler.
+            var pinned = new bool[variables.Length];
+            if (hasExceptionHandlers)
+            {
+                foreach (var local in locals)
+                {
+                    if (variableIndexes.TryGetValue(local, out var index))
+                    {
+                        pinned[index] = true;
+                    }
+                }
+            }
+            foreach (var catchVariable in catchVariables.Values)
+            {
+                if (variableIndexes.TryGetValue(catchVariable, out var index))
+                {
+                    pinned[index] = true;
+                }
+            }
+
+            // The pinned arguments are live at every GC point:
+            //   * The arguments in the method has exception handlers, same as the local variables.
+            //   * The arguments took the address, the callee can read it at anytime.
+            var pinnedArguments = new HashSet<int>();
+            if (hasExceptionHandlers)
+            {
+                pinnedArguments.UnionWith(argumentIndexes);
+            }
+
+            //////////////////////////////////////////////////////////////////////////////
+            // Collect the variable accesses at each IL offset.
+
+            var accesses = new SortedDictionary<int, CodeAccess>();
+            foreach (var entry in codeAccesses)
+            {
+                codeStream.TryGetValue(entry.Key, out var code);
+
+                var uses = new List<ILocalVariableInformation>(entry.Value.uses);
+                var defs = new List<ILocalVariableInformation>(entry.Value.defs);
+
+                var localIndex = GetLocalIndex(code, out var isUse, out var isAddress);
+                if (localIndex is int li)
+                {
+                    var local = locals[li];
+                    if (isAddress)
+                    {
+                        if (variableIndexes.TryGetValue(local, out var index))
+                        {
+                            pinned[index] = true;
+                        }
+                    }
+                    else if (isUse)
+                    {
+                        uses.Add(local);
+                    }
+                    else
+                    {
+                        defs.Add(local);
+                    }
+                }
+
+                var argumentIndex = GetArgumentIndex(code, out var isArgumentUse, out var isArgumentAddress);
+                if ((argumentIndex is int ai) &&
+                    arguments.TryGetValue(ai, out var argument))
+                {
+                    if (isArgumentAddress)
+                    {
+                        pinnedArguments.Add(variableIndexes[argument]);
+                    }
+                    else if (isArgumentUse)
+                    {
+                        uses.Add(argument);
+                    }
+                    else
+                    {
+                        defs.Add(argument);
+                    }
+                }
+
+                accesses.Add(entry.Key, new CodeAccess(
+                    code,
+                    uses.Where(variableIndexes.ContainsKey).Select(v => variableIndexes[v]).Distinct().ToArray(),
+                    defs.Where(variableIndexes.ContainsKey).Select(v => variableIndexes[v]).Distinct().ToArray(),
+                    entry.Value.successors.Where(codeAccesses.ContainsKey).Distinct().ToArray(),
+                    IsGCPoint(code)));
+            }
+
+            foreach (var pinnedArgument in pinnedArguments)
+            {
+                pinned[pinnedArgument] = true;
+            }
+            if (pinnedArguments.Count >= 1)
+            {
+                foreach (var offset in accesses.Keys.ToArray())
+                {
+                    var access = accesses[offset];
+                    accesses[offset] = new CodeAccess(
+                        access.Code,
+                        access.Uses.Concat(pinnedArguments).Distinct().ToArray(),
+                        access.Defs,
+                        access.Successors,
+                        access.IsGCPoint);
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////////
+            // The resident variables are always accessed at the slot, others are the C local variables.
+            //   * The pinned variables.
+            //   * The local variables in the method has exception handlers,
+            //     because these have to be volatile if they're the C local variables (sjlj.)
+            //   * The newobj results, the slot holds the new instance while the constructor runs.
+            //   The arguments aren't resident, they're the C parameters.
+
+            var resident = pinned.
+                Select((p, variableIndex) => (p || hasExceptionHandlers) &&
+                    !argumentIndexes.Contains(variableIndex)).
+                ToArray();
+            foreach (var access in accesses.Values.
+                Where(access => access.Code.OpCode.Code == Code.Newobj))
+            {
+                foreach (var def in access.Defs)
+                {
+                    resident[def] = true;
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////////
+            // Liveness (backward): live-in = uses + (live-out - defs)
+
+            var liveIns = accesses.Keys.ToDictionary(offset => offset, _ => new HashSet<int>());
+            var liveOuts = accesses.Keys.ToDictionary(offset => offset, _ => new HashSet<int>());
+            var reversedOffsets = accesses.Keys.Reverse().ToArray();
+
+            var changed = true;
+            while (changed)
+            {
+                changed = false;
+                foreach (var offset in reversedOffsets)
+                {
+                    var access = accesses[offset];
+                    var liveOut = liveOuts[offset];
+                    foreach (var successor in access.Successors)
+                    {
+                        liveOut.UnionWith(liveIns[successor]);
+                    }
+
+                    var liveIn = liveIns[offset];
+                    var count = liveIn.Count;
+                    liveIn.UnionWith(liveOut.Except(access.Defs));
+                    liveIn.UnionWith(access.Uses);
+                    changed |= liveIn.Count != count;
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////////
+            // Interference graph:
+            //   The defined variable interferes with the variables live after the code.
+            //   The used and defined variables at same code interfere with each other,
+            //   because the code can write the result before reading the operands (ex: newobj.)
+
+            var interferences = variables.
+                Select(_ => new HashSet<int>()).
+                ToArray();
+            void AddInterference(int variableIndex0, int variableIndex1)
+            {
+                if (variableIndex0 != variableIndex1)
+                {
+                    interferences[variableIndex0].Add(variableIndex1);
+                    interferences[variableIndex1].Add(variableIndex0);
+                }
+            }
+
+            foreach (var entry in accesses)
+            {
+                foreach (var def in entry.Value.Defs)
+                {
+                    foreach (var live in liveOuts[entry.Key])
+                    {
+                        AddInterference(def, live);
+                    }
+                    foreach (var other in entry.Value.Uses.Concat(entry.Value.Defs))
+                    {
+                        AddInterference(def, other);
+                    }
+                }
+            }
+
+            //   The arguments are defined at the entry point,
+            //   so the variables live at the entry point interfere with each other.
+            if (accesses.Count >= 1)
+            {
+                var entryLiveIn = liveIns[accesses.Keys.First()].ToArray();
+                foreach (var live0 in entryLiveIn)
+                {
+                    foreach (var live1 in entryLiveIn)
+                    {
+                        AddInterference(live0, live1);
+                    }
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////////
+            // Assign the slots (greedy coloring by the declared order.)
+
+            var slotMembers = new List<List<int>>();
+            var sharable = new List<bool>();
+            var slotIndexes = new int[variables.Length];
+            for (var variableIndex = 0; variableIndex < variables.Length; variableIndex++)
+            {
+                var slotIndex = -1;
+                if (!pinned[variableIndex])
+                {
+                    for (var index = 0; index < slotMembers.Count; index++)
+                    {
+                        if (sharable[index] &&
+                            !Interferes(interferences, slotMembers[index], variableIndex))
+                        {
+                            slotIndex = index;
+                            break;
+                        }
+                    }
+                }
+                if (slotIndex < 0)
+                {
+                    slotIndex = slotMembers.Count;
+                    slotMembers.Add(new List<int>());
+                    sharable.Add(!pinned[variableIndex]);
+                }
+
+                slotMembers[slotIndex].Add(variableIndex);
+                slotIndexes[variableIndex] = slotIndex;
+            }
+
+            var slots = slotMembers.
+                Select((members, index) => new ExecutionFrameSlot(
+                    index,
+                    members.Select(variableIndex => variables[variableIndex]).ToArray())).
+                ToArray();
+
+            //////////////////////////////////////////////////////////////////////////////
+            // Dirty slots (forward): The slot may hold the reference (written after cleared.)
+            //   Entry point: All slots are initialized by NULL.
+            //   Exception handler: Unknown, may be all slots hold the references.
+            //   Written: The resident variable is defined or the live variable is spilled at the GC point.
+            //   Cleared: At the GC point except the safepoint poll (it clears only when GC is requested.)
+
+            var dirtyIns = accesses.Keys.ToDictionary(offset => offset, _ => new HashSet<int>());
+            foreach (var catchHandler in codeStream.ExceptionHandlers.
+                SelectMany(handler => handler.CatchHandlers))
+            {
+                if (dirtyIns.TryGetValue(catchHandler.CatchStart, out var dirtyIn))
+                {
+                    dirtyIn.UnionWith(Enumerable.Range(0, slots.Length));
+                }
+            }
+
+            var liveSlotIns = accesses.Keys.ToDictionary(
+                offset => offset,
+                offset => new HashSet<int>(liveIns[offset].Select(variableIndex => slotIndexes[variableIndex])));
+
+            changed = true;
+            while (changed)
+            {
+                changed = false;
+                foreach (var entry in accesses)
+                {
+                    var dirtyOut = new HashSet<int>(dirtyIns[entry.Key]);
+                    if (entry.Value.IsGCPoint)
+                    {
+                        if (!IsSafepointPoll(entry.Value.Code))
+                        {
+                            dirtyOut.RemoveWhere(slotIndex =>
+                                sharable[slotIndex] && !liveSlotIns[entry.Key].Contains(slotIndex));
+                        }
+                        dirtyOut.UnionWith(liveIns[entry.Key].
+                            Where(variableIndex => !resident[variableIndex]).
+                            Select(variableIndex => slotIndexes[variableIndex]));
+                    }
+                    dirtyOut.UnionWith(entry.Value.Defs.
+                        Where(variableIndex => resident[variableIndex]).
+                        Select(variableIndex => slotIndexes[variableIndex]));
+
+                    foreach (var successor in entry.Value.Successors)
+                    {
+                        var dirtyIn = dirtyIns[successor];
+                        var count = dirtyIn.Count;
+                        dirtyIn.UnionWith(dirtyOut);
+                        changed |= dirtyIn.Count != count;
+                    }
+                }
+            }
+
+            var spills = accesses.
+                Where(entry => entry.Value.IsGCPoint).
+                Select(entry => (offset: entry.Key, spill: new ExecutionFrameSpill(
+                    liveIns[entry.Key].
+                        Where(variableIndex => !resident[variableIndex]).
+                        OrderBy(variableIndex => variableIndex).
+                        Select(variableIndex => variables[variableIndex]).
+                        ToArray(),
+                    dirtyIns[entry.Key].
+                        Where(slotIndex => sharable[slotIndex] && !liveSlotIns[entry.Key].Contains(slotIndex)).
+                        OrderBy(slotIndex => slotIndex).
+                        Select(slotIndex => slots[slotIndex]).
+                        ToArray(),
+                    IsSafepointPoll(entry.Value.Code)))).
+                Where(entry => (entry.spill.Variables.Length >= 1) || (entry.spill.DeadSlots.Length >= 1)).
+                ToDictionary(entry => entry.offset, entry => entry.spill);
+
+            var residents = new HashSet<ILocalVariableInformation>(
+                variables.Where((_, variableIndex) => resident[variableIndex]));
+
+            //////////////////////////////////////////////////////////////////////////////
+            // The execution frame is required if an objref survives across the GC point.
+            //   The newobj stores the new instance before calls the constructor,
+            //   the constructor doesn't hold the "this" argument in its own frame.
+
+            var requiresExecutionFrame =
+                hasExceptionHandlers ||
+                pinned.Any(p => p) ||
+                accesses.Any(entry => entry.Value.IsGCPoint &&
+                    ((liveIns[entry.Key].Count >= 1) ||
+                     ((entry.Value.Code.OpCode.Code == Code.Newobj) && (entry.Value.Defs.Length >= 1))));
+
+            return (slots, spills, residents, requiresExecutionFrame);
+        }
+    }
+}
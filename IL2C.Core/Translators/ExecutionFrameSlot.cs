@@ -0,0 +1,33 @@
+﻿using System;
+using System.Linq;
+
+using IL2C.Metadata;
+
+namespace IL2C.Translators
+{
+    // The objref slot in the execution frame.
+    // The variables have disjoint lifetimes, so they share the slot by the union if contains two or more variables.
+    public sealed class ExecutionFrameSlot
+    {
+        public readonly int Index;
+        public readonly ILocalVariableInformation[] Variables;
+
+        internal ExecutionFrameSlot(int index, ILocalVariableInformation[] variables)
+        {
+            this.Index = index;
+            this.Variables = variables;
+        }
+
+        public bool IsShared =>
+            this.Variables.Length >= 2;
+
+        public string Name =>
+            string.Format("slot{0}__", this.Index);
+
+        public override string ToString() =>
+            string.Format(
+                "{0}: {1}",
+                this.Name,
+                string.Join(", ", this.Variables.Select(variable => variable.UnsafeCLanguageSymbolName)));
+    }
+}
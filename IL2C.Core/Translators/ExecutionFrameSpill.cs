@@ -0,0 +1,32 @@
+﻿using System;
+using System.Linq;
+
+using IL2C.Metadata;
+
+namespace IL2C.Translators
+{
+    // The execution frame stores before the GC point.
+    // The live objrefs kept in the C local variables are written to the slots and the dead slots are cleared.
+    // If the GC point is the safepoint poll (loop back-edge), these are done only when GC is requested.
+    public sealed class ExecutionFrameSpill
+    {
+        public readonly ILocalVariableInformation[] Variables;
+        public readonly ExecutionFrameSlot[] DeadSlots;
+        public readonly bool IsSafepointPoll;
+
+        internal ExecutionFrameSpill(
+            ILocalVariableInformation[] variables, ExecutionFrameSlot[] deadSlots, bool isSafepointPoll)
+        {
+            this.Variables = variables;
+            this.DeadSlots = deadSlots;
+            this.IsSafepointPoll = isSafepointPoll;
+        }
+
+        public override string ToString() =>
+            string.Format(
+                "{0}spill: [{1}], clear: [{2}]",
+                this.IsSafepointPoll ? "poll: " : string.Empty,
+                string.Join(", ", this.Variables.Select(variable => variable.UnsafeCLanguageSymbolName)),
+                string.Join(", ", this.DeadSlots.Select(slot => slot.Name)));
+    }
+}
@@ -13,6 +13,10 @@ namespace IL2C.Translators
         public readonly IReadOnlyDictionary<int, string> LabelNames;
         public readonly IReadOnlyDictionary<int, ILocalVariableInformation> CatchVariables;
         public readonly IReadOnlyDictionary<int, (ISet<int> fromOffsets, int targetOffset)> LeaveContinuations;
+        public readonly ExecutionFrameSlot[] ObjRefSlots;
+        public readonly IReadOnlyDictionary<int, ExecutionFrameSpill> ObjRefSpills;
+        public readonly ISet<ILocalVariableInformation> ResidentObjRefs;
+        public readonly bool RequiresExecutionFrame;
         internal readonly IReadOnlyDictionary<int, ExpressionEmitter> Emitters;
 
         internal PreparedMethodInformation(
@@ -21,6 +25,10 @@ namespace IL2C.Translators
             IReadOnlyDictionary<int, string> labelNames,
             IReadOnlyDictionary<int, ILocalVariableInformation> catchVariables,
             IReadOnlyDictionary<int, (ISet<int> fromOffsets, int targetOffset)> leaveContinuations,
+            ExecutionFrameSlot[] objRefSlots,
+            IReadOnlyDictionary<int, ExecutionFrameSpill> objRefSpills,
+            ISet<ILocalVariableInformation> residentObjRefs,
+            bool requiresExecutionFrame,
             IReadOnlyDictionary<int, ExpressionEmitter> emitters)
         {
             this.Method = method;
@@ -28,6 +36,10 @@ namespace IL2C.Translators
             this.LabelNames = labelNames;
             this.CatchVariables = catchVariables;
             this.LeaveContinuations = leaveContinuations;
+            this.ObjRefSlots = objRefSlots;
+            this.ObjRefSpills = objRefSpills;
+            this.ResidentObjRefs = residentObjRefs;
+            this.RequiresExecutionFrame = requiresExecutionFrame;
             this.Emitters = emitters;
         }
     }
@@ -13,7 +13,7 @@ namespace IL2C.Writers
             CodeTextWriter tw,
             IExtractContextHost extractContext,
             PreparedMethodInformation preparedMethod,
-            ILocalVariableInformation[] objRefEntries,
+            ExecutionFrameSlot[] objRefSlots,
             ILocalVariableInformation[] valueEntries)
         {
             tw.WriteLine("//-------------------");
@@ -31,15 +31,36 @@ namespace IL2C.Writers
                 tw.WriteLine("const uint16_t objRefCount__;");
                 tw.WriteLine("const uint16_t valueCount__;");
 
-                if (objRefEntries.Length >= 1)
+                if (objRefSlots.Length >= 1)
                 {
                     tw.WriteLine("//-------------------- objref");
-                    foreach (var objRefEntry in objRefEntries)
+                    foreach (var objRefSlot in objRefSlots)
                     {
-                        tw.WriteLine(
-                            "{0} {1};",
-                            objRefEntry.TargetType.CLanguageTypeName,
-                            extractContext.GetSymbolName(objRefEntry));
+                        // The variables have disjoint lifetimes, they share the slot.
+                        if (objRefSlot.IsShared)
+                        {
+                            tw.WriteLine("union");
+                            tw.WriteLine("{");
+                            using (var __ = tw.Shift())
+                            {
+                                foreach (var objRefEntry in objRefSlot.Variables)
+                                {
+                                    tw.WriteLine(
+                                        "{0} {1};",
+                                        objRefEntry.TargetType.CLanguageTypeName,
+                                        extractContext.GetSymbolName(objRefEntry));
+                                }
+                            }
+                            tw.WriteLine("}} {0};", objRefSlot.Name);
+                        }
+                        else
+                        {
+                            var objRefEntry = objRefSlot.Variables[0];
+                            tw.WriteLine(
+                                "{0} {1};",
+                                objRefEntry.TargetType.CLanguageTypeName,
+                                extractContext.GetSymbolName(objRefEntry));
+                        }
                     }
                 }
 
@@ -70,7 +91,7 @@ namespace IL2C.Writers
             CodeTextWriter tw,
             IExtractContextHost extractContext,
             PreparedMethodInformation preparedMethod,
-            ILocalVariableInformation[] objRefEntries,
+            ExecutionFrameSlot[] objRefSlots,
             ILocalVariableInformation[] valueEntries,
             DebugInformationWriteController debugInformationController)
         {
@@ -91,11 +112,11 @@ namespace IL2C.Writers
                 {
                     tw.WriteLine(
                         "{{ NULL, {0}, {1}, {2} }};",
-                        objRefEntries.Length,
+                        objRefSlots.Length,
                         valueEntries.Length,
                         string.Join(
                             ", ",
-                            objRefEntries.Select(___ => "NULL").
+                            objRefSlots.Select(___ => "NULL").
                             Concat(valueEntries.
                                 Select(valueEntry =>
                                     string.Format(
@@ -108,7 +129,7 @@ namespace IL2C.Writers
                     // maybe C compiler makes better code.
                     tw.WriteLine(
                         "{{ NULL, {0} }};",
-                        objRefEntries.Length);
+                        objRefSlots.Length);
                 }
             }
 
@@ -125,6 +146,47 @@ namespace IL2C.Writers
             tw.SplitLine();
         }
 
+        private static void InternalConvertObjRefLocals(
+            CodeTextWriter tw,
+            IExtractContextHost extractContext,
+            ILocalVariableInformation[] objRefEntries,
+            bool hasExceptionHandlers,
+            bool pollSafepoint,
+            DebugInformationWriteController debugInformationController)
+        {
+            if (objRefEntries.Length >= 1)
+            {
+                tw.WriteLine("//-------------------");
+                tw.WriteLine("// [3-5] Local variables and evaluation stacks (objref):");
+                tw.SplitLine();
+
+                // Important NULL assigner (p = NULL):
+                //   GC finds these variables from the native stack (or the registers) conservatively,
+                //   the garbage value may keep the unreachable instance alive.
+                //   (If the execution frame is elided, GC never sees these variables.)
+                foreach (var objRefEntry in objRefEntries)
+                {
+                    // The variables have to be "volatile" if the method has exception handlers (sjlj.)
+                    debugInformationController.WriteInformationBeforeCode(tw);
+                    tw.WriteLine(
+                        "{0}{1} {2} = NULL;",
+                        objRefEntry.TargetType.CLanguageTypeName,
+                        hasExceptionHandlers ? " volatile" : string.Empty,
+                        extractContext.GetSymbolName(objRefEntry));
+                }
+
+                tw.SplitLine();
+            }
+
+            // The method entry is the safepoint, because the execution frame linker doesn't poll.
+            if (pollSafepoint)
+            {
+                debugInformationController.WriteInformationBeforeCode(tw);
+                tw.WriteLine("il2c_poll_safepoint();");
+                tw.SplitLine();
+            }
+        }
+
         private static void InternalConvertExceptionFilter(
             CodeTextWriter tw,
             IExtractContextHost extractContext,
@@ -191,6 +253,7 @@ namespace IL2C.Writers
             CodeTextWriter tw,
             IExtractContextHost extractContext,
             PreparedMethodInformation preparedMethod,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOption)
         {
             var locals = preparedMethod.Method.LocalVariables;
@@ -223,13 +286,21 @@ namespace IL2C.Writers
             }
 
             // Write declaring execution frame
-            if ((objRefEntries.Length >= 1) || (valueEntries.Length >= 1))
+            //   (The conservative stack scanning finds the objrefs from the native stack.)
+            //   The execution frame is elided if all objrefs are dead at every GC point
+            //   (ex: the leaf method or the method not allocating.)
+            //   The slots contain the overwritten objref arguments, they're spilled same as the C local variables.
+            var requiresExecutionFrame =
+                !enableConservativeStackScanning &&
+                (((preparedMethod.ObjRefSlots.Length >= 1) && preparedMethod.RequiresExecutionFrame) ||
+                 (valueEntries.Length >= 1));
+            if (requiresExecutionFrame)
             {
                 InternalConvertExecutionFrame(
                     tw,
                     extractContext,
                     preparedMethod,
-                    objRefEntries,
+                    preparedMethod.ObjRefSlots,
                     valueEntries);
             }
 
@@ -345,26 +416,66 @@ namespace IL2C.Writers
 
                 // Write doing setup execution frame
                 var executionFrameEmitted = false;
-                if ((objRefEntries.Length >= 1) || (valueEntries.Length >= 1))
+                if (requiresExecutionFrame)
                 {
+                    // The objrefs not resident in the execution frame are the C local variables,
+                    // these are spilled to the execution frame only at the GC points.
+                    InternalConvertObjRefLocals(
+                        tw,
+                        extractContext,
+                        objRefEntries.
+                            Where(objRefEntry => !preparedMethod.ResidentObjRefs.Contains(objRefEntry)).
+                            ToArray(),
+                        codeStream.ExceptionHandlers.Length >= 1,
+                        false,
+                        debugInformationController);
+
                     InternalConvertSetupExecutionFrame(
                         tw,
                         extractContext,
                         preparedMethod, 
-                        objRefEntries,
+                        preparedMethod.ObjRefSlots,
                         valueEntries,
                         debugInformationController);
                     executionFrameEmitted = true;
                 }
+                else
+                {
+                    // The objrefs are the C local variables if the execution frame is elided.
+                    InternalConvertObjRefLocals(
+                        tw,
+                        extractContext,
+                        objRefEntries,
+                        codeStream.ExceptionHandlers.Length >= 1,
+                        enableConservativeStackScanning,
+                        debugInformationController);
+                }
 
                 tw.WriteLine("//-------------------");
                 tw.WriteLine("// [3-6] IL body:");
                 tw.SplitLine();
 
                 // Set symbol prefix to make valid access variables.
+                //   The variable in the shared slot is the union member.
+                //   The variable not resident in the execution frame is the C local variable.
+                var objRefPrefixes = preparedMethod.ObjRefSlots.
+                    SelectMany(objRefSlot => objRefSlot.Variables.
+                        Select(variable => (variable, prefix: objRefSlot.IsShared ?
+                            string.Format("frame__.{0}.", objRefSlot.Name) :
+                            "frame__."))).
+                    ToDictionary(entry => entry.variable, entry => entry.prefix);
                 using (var __ = extractContext.BeginLocalVariablePrefix(
-                    local => local.TargetType.IsReferenceType ? "frame__." : null))
+                    local => (local.TargetType.IsReferenceType && executionFrameEmitted) ?
+                        (objRefPrefixes.TryGetValue(local, out var prefix) ?
+                            (preparedMethod.ResidentObjRefs.Contains(local) ? prefix : null) :
+                            "frame__.") :
+                        null))
                 {
+                    string GetFrameSymbolName(ILocalVariableInformation variable) =>
+                        preparedMethod.ResidentObjRefs.Contains(variable) ?
+                            extractContext.GetSymbolName(variable) :
+                            objRefPrefixes[variable] + extractContext.GetSymbolName(variable);
+
                     // Construct exception handler controller.
                     var exceptionHandlerController = new ExceptionHandlerController(
                         codeStream.ExceptionHandlers,
@@ -490,7 +601,7 @@ namespace IL2C.Writers
                         });
 
                     // Traverse code fragments.
-                    var emitContext = new ExpressionEmitContext(executionFrameEmitted);
+                    var emptySpills = new string[0];
                     foreach (var ci in codeStream)
                     {
                         debugInformationController.SetNextCode(ci);
@@ -511,7 +622,40 @@ namespace IL2C.Writers
                         // 3: Write source code comment.
                         debugInformationController.WriteCodeComment(tw);
 
-                        // 4: Generate source code fragments and write.
+                        // 4: Spill the live objrefs and clear the dead objref slots before GC can reach.
+                        //    (The safepoint poll does it only when GC is requested.)
+                        var safepointSpills = emptySpills;
+                        if (executionFrameEmitted &&
+                            preparedMethod.ObjRefSpills.TryGetValue(ci.Offset, out var objRefSpill))
+                        {
+                            var spills = objRefSpill.Variables.
+                                Select(variable => string.Format(
+                                    "{0} = {1}",
+                                    GetFrameSymbolName(variable),
+                                    extractContext.GetSymbolName(variable))).
+                                Concat(objRefSpill.DeadSlots.
+                                    Select(deadSlot => string.Format(
+                                        "{0} = NULL",
+                                        GetFrameSymbolName(deadSlot.Variables[0])))).
+                                ToArray();
+                            if (objRefSpill.IsSafepointPoll)
+                            {
+                                safepointSpills = spills;
+                            }
+                            else
+                            {
+                                foreach (var spill in spills)
+                                {
+                                    debugInformationController.WriteInformationBeforeCode(tw);
+                                    tw.WriteLine(
+                                        "{0};",
+                                        spill);
+                                }
+                            }
+                        }
+
+                        // 5: Generate source code fragments and write.
+                        var emitContext = new ExpressionEmitContext(executionFrameEmitted, safepointSpills);
                         var sourceCodes = preparedMethod.Emitters[ci.Offset](extractContext, emitContext);
                         foreach (var sourceCode in sourceCodes)
                         {
@@ -673,7 +817,8 @@ namespace IL2C.Writers
         private static void InternalConvertFromDelegateInvoker(
             CodeTextWriter tw,
             IExtractContext extractContext,
-            IMethodInformation invokeMethod)
+            IMethodInformation invokeMethod,
+            bool enableConservativeStackScanning)
         {
             if (invokeMethod.Parameters.Length == 0)
             {
@@ -709,32 +854,60 @@ namespace IL2C.Writers
                     thisName);
                 tw.SplitLine();
 
-                if (!invokeMethod.ReturnType.IsVoidType)
+                // The invoker is the entry point from the native code too (ex: the thread entry point.)
+                // The execution frame makes the thread RUNNING, and holds the delegate, the current target,
+                // the objref arguments and the objref result while the targets run,
+                // because the frame elided targets don't hold their arguments.
+                //   (The conservative stack scanning finds them from the native stack.)
+                var requiresExecutionFrame = !enableConservativeStackScanning;
+                var objRefParameters = delegateParameters.
+                    Where(p => p.TargetType.IsReferenceType && !p.TargetType.IsByReference).  // Only objref
+                    ToArray();
+                var resultInFrame = invokeMethod.ReturnType.IsReferenceType && requiresExecutionFrame;
+
+                if (requiresExecutionFrame)
                 {
-                    if (invokeMethod.ReturnType.IsReferenceType)
+                    tw.WriteLine(
+                        "volatile struct {0}_EXECUTION_FRAME_DECL",
+                        invokeMethod.CLanguageFunctionFullName);
+                    tw.WriteLine("{");
+                    using (var __ = tw.Shift())
                     {
+                        tw.WriteLine("IL2C_EXECUTION_FRAME* pNext__;");
+                        tw.WriteLine("uint16_t objRefCount__;");
+                        tw.WriteLine("uint16_t valueCount__;");
                         tw.WriteLine(
-                            "volatile struct {0}_EXECUTION_FRAME_DECL",
-                            invokeMethod.CLanguageFunctionFullName);
-                        tw.WriteLine("{");
-                        using (var __ = tw.Shift())
+                            "{0} {1};",
+                            invokeMethod.Parameters[0].TargetType.CLanguageTypeName,
+                            thisName);
+                        tw.WriteLine("System_Object* target;");
+                        foreach (var p in objRefParameters)
+                        {
+                            tw.WriteLine(
+                                "{0} {1};",
+                                p.TargetType.CLanguageTypeName,
+                                p.ParameterName);
+                        }
+                        if (resultInFrame)
                         {
-                            tw.WriteLine("IL2C_EXECUTION_FRAME* pNext__;");
-                            tw.WriteLine("uint16_t objRefCount__;");
-                            tw.WriteLine("uint16_t valueCount__;");
                             tw.WriteLine(
                                 "{0} result;",
                                 invokeMethod.ReturnType.CLanguageTypeName);
                         }
-                        tw.WriteLine("} frame__ = { NULL, 1, 0 };");
-                        tw.WriteLine("il2c_link_execution_frame(&frame__);");
-                    }
-                    else
-                    {
-                        tw.WriteLine(
-                            "{0} result;",
-                            invokeMethod.ReturnType.CLanguageTypeName);
                     }
+                    tw.WriteLine(
+                        "}} frame__ = {{ NULL, {0}, 0, {1}, NULL{2} }};",
+                        2 + objRefParameters.Length + (resultInFrame ? 1 : 0),
+                        thisName,
+                        string.Join(string.Empty, objRefParameters.
+                            Select(p => string.Format(", {0}", p.ParameterName))));
+                    tw.WriteLine("il2c_link_execution_frame(&frame__);");
+                }
+                if (!invokeMethod.ReturnType.IsVoidType && !resultInFrame)
+                {
+                    tw.WriteLine(
+                        "{0} result;",
+                        invokeMethod.ReturnType.CLanguageTypeName);
                 }
 
                 tw.SplitLine();
@@ -751,6 +924,10 @@ namespace IL2C.Writers
                     tw.WriteLine(
                         "IL2C_METHOD_TABLE* pMethodtbl = &{0}->methodtbl__[index];",
                         thisName);
+                    if (requiresExecutionFrame)
+                    {
+                        tw.WriteLine("frame__.target = pMethodtbl->target;");
+                    }
 
                     if (invokeMethod.ReturnType.IsVoidType)
                     {
@@ -784,7 +961,7 @@ namespace IL2C.Writers
                         {
                             tw.WriteLine(
                                 "{0}result = (({1} (*)(System_Object*{2}))(pMethodtbl->methodPtr))(pMethodtbl->target{3});",
-                                invokeMethod.ReturnType.IsReferenceType ? "frame__." : string.Empty,
+                                resultInFrame ? "frame__." : string.Empty,
                                 invokeMethod.ReturnType.CLanguageTypeName,
                                 string.Join(string.Empty, delegateParameters.
                                     Select(p => string.Format(", {0}", p.TargetType.CLanguageTypeName))),
@@ -796,7 +973,7 @@ namespace IL2C.Writers
                         {
                             tw.WriteLine(
                                 "{0}result = (({1} (*)({2}))(pMethodtbl->methodPtr))({3});",
-                                invokeMethod.ReturnType.IsReferenceType ? "frame__." : string.Empty,
+                                resultInFrame ? "frame__." : string.Empty,
                                 invokeMethod.ReturnType.CLanguageTypeName,
                                 (delegateParameters.Length >= 1) ?
                                     string.Join(", ", delegateParameters.
@@ -815,14 +992,29 @@ namespace IL2C.Writers
 
                 if (invokeMethod.ReturnType.IsVoidType)
                 {
-                    tw.WriteLine("il2c_return();");
+                    if (requiresExecutionFrame)
+                    {
+                        tw.WriteLine("il2c_return_unlink(&frame__);");
+                    }
+                    else
+                    {
+                        tw.WriteLine("il2c_return();");
+                    }
                 }
                 else
                 {
-                    if (invokeMethod.ReturnType.IsReferenceType)
+                    if (resultInFrame)
                     {
                         tw.WriteLine("il2c_return_unlink_with_objref(&frame__, frame__.result);");
                     }
+                    else if (requiresExecutionFrame)
+                    {
+                        tw.WriteLine("il2c_return_unlink_with_value(&frame__, result);");
+                    }
+                    else if (invokeMethod.ReturnType.IsReferenceType)
+                    {
+                        tw.WriteLine("il2c_return_with_objref(result);");
+                    }
                     else
                     {
                         tw.WriteLine("il2c_return_with_value(result);");
@@ -839,6 +1031,7 @@ namespace IL2C.Writers
             IExtractContextHost extractContext,
             PreparedInformations preparedFunctions,
             IMethodInformation method,
+            bool enableConservativeStackScanning = false,
             DebugInformationOptions debugInformationOption = DebugInformationOptions.None)
         {
             if (method.IsVirtual)
@@ -874,7 +1067,8 @@ namespace IL2C.Writers
                         InternalConvertFromDelegateInvoker(
                             tw,
                             extractContext,
-                            method);
+                            method,
+                            enableConservativeStackScanning);
                         return;
                     }
                 }
@@ -895,6 +1089,7 @@ namespace IL2C.Writers
                 tw,
                 extractContext,
                 preparedMethod,
+                enableConservativeStackScanning,
                 debugInformationOption);
         }
     }
@@ -247,7 +247,8 @@ namespace IL2C.Writers
             CodeTextStorage storage,
             TranslateContext translateContext,
             PreparedInformations prepared,
-            string assemblyName)
+            string assemblyName,
+            bool enableConservativeStackScanning)
         {
             IExtractContext extractContext = translateContext;
             var annotatedAssemblyName = assemblyName + "_internal";
@@ -273,6 +274,15 @@ namespace IL2C.Writers
                 twHeader.WriteLine("#include <{0}.h>", assemblyName);
                 twHeader.SplitLine();
 
+                // The translated code doesn't link the execution frames, the runtime has to scan the native stacks.
+                if (enableConservativeStackScanning)
+                {
+                    twHeader.WriteLine("#if !defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)");
+                    twHeader.WriteLine("#error \"{0} is translated for the conservative stack scanning, have to define IL2C_USE_CONSERVATIVE_STACK_SCAN.\"", assemblyName);
+                    twHeader.WriteLine("#endif");
+                    twHeader.SplitLine();
+                }
+
                 var constStrings = extractContext.
                     ExtractConstStrings().
                     ToArray();
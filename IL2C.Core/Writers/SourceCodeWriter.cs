@@ -125,6 +125,7 @@ namespace IL2C.Writers
             IExtractContextHost extractContext,
             PreparedInformations prepared,
             ITypeInformation targetType,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOption,
             IReadOnlyDictionary<ITypeInformation, ITypeInformation[]> typesByDeclaring)
         {
@@ -141,6 +142,7 @@ namespace IL2C.Writers
                             extractContext,
                             prepared,
                             type,
+                            enableConservativeStackScanning,
                             debugInformationOption,
                             typesByDeclaring);
                     }
@@ -311,6 +313,7 @@ namespace IL2C.Writers
                             extractContext,
                             prepared,
                             method,
+                            enableConservativeStackScanning,
                             debugInformationOption);
                     }
 
@@ -336,6 +339,7 @@ namespace IL2C.Writers
             CodeTextStorage storage,
             TranslateContext translateContext,
             PreparedInformations prepared,
+            bool enableConservativeStackScanning,
             DebugInformationOptions debugInformationOption)
         {
             IExtractContextHost extractContext = translateContext;
@@ -386,6 +390,7 @@ namespace IL2C.Writers
                             extractContext,
                             prepared,
                             targetType,
+                            enableConservativeStackScanning,
                             debugInformationOption,
                             typesByDeclaring);
 
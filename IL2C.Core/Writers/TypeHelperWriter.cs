@@ -1,4 +1,5 @@
 ﻿using System;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.Linq;
 
@@ -301,12 +302,11 @@ namespace IL2C.Writers
             tw.WriteLine("// [7-8] Runtime type information");
 
             // Aggregate mark target fields (except the enum type and the delegate type)
+            // The objref fields inside the value type fields are flattened to the member designators,
+            // so the GC marker can scan the objref offsets without traversing the value types.
             var markTargetFields =
                 declaredFields.
-                Where(field =>
-                    field.FieldType.IsReferenceType ||
-                    (field.FieldType.IsValueType && !field.FieldType.IsPrimitive &&
-                    field.FieldType.Fields.Length >= 1)).
+                SelectMany(field => GetMarkTargetFields(field.FieldType, field.MangledName)).
                 ToArray();
 
             // All virtual methods are implemented.
@@ -318,10 +318,12 @@ namespace IL2C.Writers
                     declaredType.MangledUniqueName,
                     declaredType.FriendlyName, // Type name (UTF-8 string, C compiler embeds into .rdata)
                     declaredType.IsEnum ?      // Type attribute flags
-                        (declaredType.ElementType.IsUnsigned ? "IL2C_TYPE_UNSIGNED_INTEGER" : "IL2C_TYPE_INTEGER") :
+                        (declaredType.ElementType.IsUnsigned ? "IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE" : "IL2C_TYPE_INTEGER | IL2C_TYPE_POINTER_FREE") :
                         declaredType.IsDelegate ? "IL2C_TYPE_VARIABLE | IL2C_TYPE_WITH_MARK_HANDLER" :
-                        declaredType.IsReferenceType ? "IL2C_TYPE_REFERENCE" :
-                        "IL2C_TYPE_VALUE",
+                        declaredType.IsReferenceType ?
+                            (IsPointerFreeReferenceType(declaredType) ? "IL2C_TYPE_REFERENCE | IL2C_TYPE_POINTER_FREE" : "IL2C_TYPE_REFERENCE") :
+                        declaredType.IsRequiredTraverse ? "IL2C_TYPE_VALUE" :
+                        "IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE",
                     declaredType.CLanguageStaticSizeOfExpression,
                     declaredType.BaseType.MangledUniqueName,
                     declaredType.IsDelegate ? "System_Delegate_MarkHandler__" : markTargetFields.Length.ToString(),
@@ -343,25 +345,14 @@ namespace IL2C.Writers
             using (var _ = tw.Shift())
             {
                 // Mark target offsets.
-                foreach (var field in markTargetFields)
+                foreach (var memberDesignator in markTargetFields)
                 {
-                    if (field.FieldType.IsReferenceType)
-                    {
-                        // ex: IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_REFERENCE(System_Exception, message__)
-                        tw.WriteLine(
-                            "IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_REFERENCE({0}, {1})",
-                            declaredType.MangledUniqueName,
-                            field.MangledName);
-                    }
-                    else
-                    {
-                        // ex: IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_VALUE(System_Exception, System_Int32 , result__)
-                        tw.WriteLine(
-                            "IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_VALUE({0}, {1}, {2})",
-                            declaredType.MangledUniqueName,
-                            field.FieldType.MangledUniqueName,
-                            field.MangledName);
-                    }
+                    // ex: IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_REFERENCE(System_Exception, message__)
+                    // ex: IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_REFERENCE(Foo_Bar, value__.message__)
+                    tw.WriteLine(
+                        "IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_REFERENCE({0}, {1})",
+                        declaredType.MangledUniqueName,
+                        memberDesignator);
                 }
 
                 // Write implemented interfaces (IL2C_IMPLEMENTED_INTERFACE)
@@ -379,6 +370,38 @@ namespace IL2C.Writers
             tw.SplitLine();
         }
 
+        // The pointer-free instance is allocated at the pointer-free space, and the GC never scans it.
+        private static bool IsPointerFreeReferenceType(ITypeInformation declaredType) =>
+            // The runtime implemented base type (ex: System.Exception) has the objref fields hidden from the metadata.
+            !declaredType.IsException &&
+            declaredType.
+                Traverse(type => type.BaseType).
+                All(type => type.Fields.
+                    Where(field => !field.IsStatic).
+                    All(field => !field.FieldType.IsRequiredTraverse));
+
+        private static IEnumerable<string> GetMarkTargetFields(
+            ITypeInformation fieldType,
+            string memberDesignator)
+        {
+            if (fieldType.IsReferenceType)
+            {
+                return new[] { memberDesignator };
+            }
+
+            if (!fieldType.IsRequiredTraverse)
+            {
+                return Enumerable.Empty<string>();
+            }
+
+            // ex: "value__.message__"
+            return fieldType.Fields.
+                Where(field => !field.IsStatic).
+                SelectMany(field => GetMarkTargetFields(
+                    field.FieldType,
+                    memberDesignator + "." + field.MangledName));
+        }
+
         public static void InternalConvertTypeHelperForInterface(
             CodeTextWriter tw,
             ITypeInformation declaredType)
@@ -0,0 +1,191 @@
+﻿using System;
+
+namespace IL2C.HeapAnalyzer
+{
+    // The dominator tree of the reachable instances from the virtual root (connected to all roots.)
+    // It uses the iterative algorithm by Cooper, Harvey and Kennedy ("A Simple, Fast Dominance Algorithm".)
+    public sealed class DominatorTree
+    {
+        public const int Unreachable = -1;
+
+        private readonly HeapSnapshot snapshot;
+        private readonly int virtualRoot;
+
+        // The immediate dominator, the virtual root (= snapshot.Count) or Unreachable.
+        public readonly int[] ImmediateDominators;
+        public readonly long[] RetainedSizes;
+        // Reachable instances in the reverse postorder (the dominator is placed before the dominated.)
+        public readonly int[] ReversePostorder;
+
+        public DominatorTree(HeapSnapshot snapshot)
+        {
+            this.snapshot = snapshot;
+            this.virtualRoot = snapshot.Count;
+
+            var postorderNumbers = new int[snapshot.Count + 1];
+            this.ReversePostorder = this.ComputeReversePostorder(postorderNumbers);
+            var predecessors = this.ComputePredecessors(out var predecessorOffsets);
+
+            this.ImmediateDominators = ComputeImmediateDominators(
+                this.ReversePostorder, postorderNumbers, predecessorOffsets, predecessors, this.virtualRoot);
+
+            // The dominated instance has the smaller postorder number, so accumulate by the postorder.
+            this.RetainedSizes = new long[snapshot.Count + 1];
+            for (var index = this.ReversePostorder.Length - 1; index >= 0; index--)
+            {
+                var instance = this.ReversePostorder[index];
+                this.RetainedSizes[instance] += snapshot.Sizes[instance];
+                this.RetainedSizes[this.ImmediateDominators[instance]] += this.RetainedSizes[instance];
+            }
+        }
+
+        public bool IsReachable(int instance) =>
+            this.ImmediateDominators[instance] != Unreachable;
+
+        public bool IsDominatedByRoot(int instance) =>
+            this.ImmediateDominators[instance] == this.virtualRoot;
+
+        private int GetSuccessorCount(int node) =>
+            (node == this.virtualRoot) ?
+                this.snapshot.Roots.Length :
+                this.snapshot.ReferenceOffsets[node + 1] - this.snapshot.ReferenceOffsets[node];
+
+        private int GetSuccessor(int node, int index) =>
+            (node == this.virtualRoot) ?
+                this.snapshot.Roots[index].Instance :
+                this.snapshot.References[this.snapshot.ReferenceOffsets[node] + index];
+
+        // Iterative depth first search (the heap may have the long chains.)
+        // Excludes the virtual root, the postorder number of the virtual root is the largest.
+        private int[] ComputeReversePostorder(int[] postorderNumbers)
+        {
+            var visited = new bool[this.snapshot.Count + 1];
+            var nodeStack = new int[this.snapshot.Count + 1];
+            var indexStack = new int[this.snapshot.Count + 1];
+            var postorder = new int[this.snapshot.Count + 1];
+            var postorderCount = 0;
+
+            var depth = 0;
+            nodeStack[0] = this.virtualRoot;
+            indexStack[0] = 0;
+            visited[this.virtualRoot] = true;
+            while (depth >= 0)
+            {
+                var node = nodeStack[depth];
+                var index = indexStack[depth];
+                if (index < this.GetSuccessorCount(node))
+                {
+                    indexStack[depth] = index + 1;
+                    var successor = this.GetSuccessor(node, index);
+                    if (!visited[successor])
+                    {
+                        visited[successor] = true;
+                        depth++;
+                        nodeStack[depth] = successor;
+                        indexStack[depth] = 0;
+                    }
+                }
+                else
+                {
+                    postorderNumbers[node] = postorderCount;
+                    postorder[postorderCount++] = node;
+                    depth--;
+                }
+            }
+
+            var reversePostorder = new int[postorderCount - 1];
+            for (var index = 0; index < reversePostorder.Length; index++)
+            {
+                reversePostorder[index] = postorder[postorderCount - 2 - index];
+            }
+            return reversePostorder;
+        }
+
+        private int[] ComputePredecessors(out int[] offsets)
+        {
+            offsets = new int[this.snapshot.Count + 2];
+            for (var node = 0; node <= this.virtualRoot; node++)
+            {
+                var count = this.GetSuccessorCount(node);
+                for (var index = 0; index < count; index++)
+                {
+                    offsets[this.GetSuccessor(node, index) + 1]++;
+                }
+            }
+            for (var node = 0; node <= this.virtualRoot; node++)
+            {
+                offsets[node + 1] += offsets[node];
+            }
+
+            var predecessors = new int[offsets[this.virtualRoot + 1]];
+            var positions = new int[this.snapshot.Count + 1];
+            Array.Copy(offsets, positions, positions.Length);
+            for (var node = 0; node <= this.virtualRoot; node++)
+            {
+                var count = this.GetSuccessorCount(node);
+                for (var index = 0; index < count; index++)
+                {
+                    var successor = this.GetSuccessor(node, index);
+                    predecessors[positions[successor]++] = node;
+                }
+            }
+            return predecessors;
+        }
+
+        private static int[] ComputeImmediateDominators(
+            int[] reversePostorder, int[] postorderNumbers, int[] predecessorOffsets, int[] predecessors, int virtualRoot)
+        {
+            var dominators = new int[virtualRoot + 1];
+            for (var index = 0; index < dominators.Length; index++)
+            {
+                dominators[index] = Unreachable;
+            }
+            dominators[virtualRoot] = virtualRoot;
+
+            var changed = true;
+            while (changed)
+            {
+                changed = false;
+                foreach (var node in reversePostorder)
+                {
+                    var newDominator = Unreachable;
+                    for (var offset = predecessorOffsets[node]; offset < predecessorOffsets[node + 1]; offset++)
+                    {
+                        var predecessor = predecessors[offset];
+                        if (dominators[predecessor] == Unreachable)
+                        {
+                            continue;
+                        }
+                        newDominator = (newDominator == Unreachable) ?
+                            predecessor :
+                            Intersect(dominators, postorderNumbers, predecessor, newDominator);
+                    }
+
+                    if (dominators[node] != newDominator)
+                    {
+                        dominators[node] = newDominator;
+                        changed = true;
+                    }
+                }
+            }
+
+            return dominators;
+        }
+
+        private static int Intersect(int[] dominators, int[] postorderNumbers, int node1, int node2)
+        {
+            while (node1 != node2)
+            {
+                while (postorderNumbers[node1] < postorderNumbers[node2])
+                {
+                    node1 = dominators[node1];
+                }
+                while (postorderNumbers[node2] < postorderNumbers[node1])
+                {
+                    node2 = dominators[node2];
+                }
+            }
+            return node1;
+        }
+    }
+}
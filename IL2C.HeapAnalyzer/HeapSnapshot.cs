@@ -0,0 +1,205 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+namespace IL2C.HeapAnalyzer
+{
+    // IL2C_HEAP_ROOT_* (il2c_private.h)
+    public enum RootKinds : byte
+    {
+        StaticField = 1,
+        ExecutionFrame = 2,
+        RootReference = 3,
+        FixedReference = 4,
+        FinalizerQueue = 5,
+    }
+
+    public struct HeapRoot
+    {
+        public readonly RootKinds Kind;
+        public readonly int Instance;
+
+        public HeapRoot(RootKinds kind, int instance)
+        {
+            this.Kind = kind;
+            this.Instance = instance;
+        }
+    }
+
+    // The snapshot written by il2c_dump_heap_snapshot() (the format is described at il2c_snapshot.c.)
+    // The instances are indexed by the order in the file.
+    public sealed class HeapSnapshot
+    {
+        private const int Version = 1;
+
+        public readonly int PointerSize;
+        public readonly string[] TypeNames;
+        public readonly ulong[] Addresses;
+        public readonly int[] Types;
+        public readonly long[] Sizes;
+        // The references from the instance i are References[ReferenceOffsets[i] .. ReferenceOffsets[i + 1]).
+        public readonly int[] ReferenceOffsets;
+        public readonly int[] References;
+        public readonly HeapRoot[] Roots;
+        // The references to the instances not in the snapshot (ignored.)
+        public readonly int UnknownReferences;
+
+        private HeapSnapshot(
+            int pointerSize,
+            string[] typeNames,
+            ulong[] addresses,
+            int[] types,
+            long[] sizes,
+            int[] referenceOffsets,
+            int[] references,
+            HeapRoot[] roots,
+            int unknownReferences)
+        {
+            this.PointerSize = pointerSize;
+            this.TypeNames = typeNames;
+            this.Addresses = addresses;
+            this.Types = types;
+            this.Sizes = sizes;
+            this.ReferenceOffsets = referenceOffsets;
+            this.References = references;
+            this.Roots = roots;
+            this.UnknownReferences = unknownReferences;
+        }
+
+        public int Count => this.Addresses.Length;
+
+        private static string ReadSignature(BinaryReader br) =>
+            Encoding.ASCII.GetString(br.ReadBytes(8));
+
+        public static HeapSnapshot Load(string path)
+        {
+            using (var fs = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.Read, 65536))
+            {
+                // BinaryReader is always little endian.
+                var br = new BinaryReader(fs);
+
+                if (ReadSignature(br) != "IL2CHEAP")
+                {
+                    throw new InvalidDataException("Not an IL2C heap snapshot: " + path);
+                }
+                var version = br.ReadUInt32();
+                if (version != Version)
+                {
+                    throw new InvalidDataException("Unsupported snapshot version: " + version);
+                }
+                var pointerSize = (int)br.ReadUInt32();
+
+                var typeIndexes = new Dictionary<ulong, int>();
+                var typeNames = new List<string>();
+                var addresses = new List<ulong>();
+                var types = new List<int>();
+                var sizes = new List<long>();
+                var referenceOffsets = new List<int>();
+                var referenceAddresses = new List<ulong>();
+                var rootAddresses = new List<KeyValuePair<RootKinds, ulong>>();
+
+                var completed = false;
+                while (!completed)
+                {
+                    var tag = (char)br.ReadByte();
+                    switch (tag)
+                    {
+                        case 'T':
+                            {
+                                var typeId = br.ReadUInt64();
+                                var nameLength = (int)br.ReadUInt32();
+                                typeIndexes[typeId] = typeNames.Count;
+                                typeNames.Add(Encoding.UTF8.GetString(br.ReadBytes(nameLength)));
+                            }
+                            break;
+                        case 'R':
+                            {
+                                var kind = (RootKinds)br.ReadByte();
+                                rootAddresses.Add(new KeyValuePair<RootKinds, ulong>(kind, br.ReadUInt64()));
+                            }
+                            break;
+                        case 'O':
+                            {
+                                addresses.Add(br.ReadUInt64());
+                                var typeId = br.ReadUInt64();
+                                if (!typeIndexes.TryGetValue(typeId, out var typeIndex))
+                                {
+                                    throw new InvalidDataException("Unknown type id: 0x" + typeId.ToString("x"));
+                                }
+                                types.Add(typeIndex);
+                                sizes.Add((long)br.ReadUInt64());
+                                referenceOffsets.Add(referenceAddresses.Count);
+                                var count = (int)br.ReadUInt32();
+                                for (var index = 0; index < count; index++)
+                                {
+                                    referenceAddresses.Add(br.ReadUInt64());
+                                }
+                            }
+                            break;
+                        case 'E':
+                            br.ReadUInt64();
+                            br.ReadUInt64();
+                            completed = true;
+                            break;
+                        default:
+                            throw new InvalidDataException(
+                                string.Format("Invalid record tag: 0x{0:x2}, position={1}", (int)tag, fs.Position - 1));
+                    }
+                }
+                referenceOffsets.Add(referenceAddresses.Count);
+
+                var instanceIndexes = new Dictionary<ulong, int>(addresses.Count);
+                for (var index = 0; index < addresses.Count; index++)
+                {
+                    instanceIndexes[addresses[index]] = index;
+                }
+
+                // Resolve the addresses, drop the unknown references.
+                var unknownReferences = 0;
+                var resolvedOffsets = new int[referenceOffsets.Count];
+                var references = new List<int>(referenceAddresses.Count);
+                for (var index = 0; index < addresses.Count; index++)
+                {
+                    resolvedOffsets[index] = references.Count;
+                    for (var offset = referenceOffsets[index]; offset < referenceOffsets[index + 1]; offset++)
+                    {
+                        if (instanceIndexes.TryGetValue(referenceAddresses[offset], out var target))
+                        {
+                            references.Add(target);
+                        }
+                        else
+                        {
+                            unknownReferences++;
+                        }
+                    }
+                }
+                resolvedOffsets[addresses.Count] = references.Count;
+
+                var roots = new List<HeapRoot>(rootAddresses.Count);
+                foreach (var entry in rootAddresses)
+                {
+                    if (instanceIndexes.TryGetValue(entry.Value, out var target))
+                    {
+                        roots.Add(new HeapRoot(entry.Key, target));
+                    }
+                    else
+                    {
+                        unknownReferences++;
+                    }
+                }
+
+                return new HeapSnapshot(
+                    pointerSize,
+                    typeNames.ToArray(),
+                    addresses.ToArray(),
+                    types.ToArray(),
+                    sizes.ToArray(),
+                    resolvedOffsets,
+                    references.ToArray(),
+                    roots.ToArray(),
+                    unknownReferences);
+            }
+        }
+    }
+}
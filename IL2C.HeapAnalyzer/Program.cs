@@ -0,0 +1,189 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Runtime.InteropServices;
+
+namespace IL2C.HeapAnalyzer
+{
+    public static class Program
+    {
+        private sealed class TypeStatistics
+        {
+            public string TypeName;
+            public long Count;
+            public long ShallowBytes;
+            public long RetainedBytes;
+            public long UnreachableCount;
+        }
+
+        // The retained bytes by the type counts the instances not dominated by the other instance of the same type,
+        // so the instances of the recursive structure (ex: linked list) aren't counted twice.
+        private static long[] ComputeRetainedBytesByType(HeapSnapshot snapshot, DominatorTree tree)
+        {
+            var retainedBytes = new long[snapshot.TypeNames.Length];
+
+            // Children of the dominator tree.
+            var offsets = new int[snapshot.Count + 2];
+            foreach (var instance in tree.ReversePostorder)
+            {
+                offsets[tree.ImmediateDominators[instance] + 1]++;
+            }
+            for (var index = 0; index <= snapshot.Count; index++)
+            {
+                offsets[index + 1] += offsets[index];
+            }
+            var children = new int[tree.ReversePostorder.Length];
+            var positions = new int[snapshot.Count + 1];
+            Array.Copy(offsets, positions, positions.Length);
+            foreach (var instance in tree.ReversePostorder)
+            {
+                children[positions[tree.ImmediateDominators[instance]]++] = instance;
+            }
+
+            // Depth first from the virtual root, with the count of the ancestors by the type.
+            var activeAncestors = new int[snapshot.TypeNames.Length];
+            var nodeStack = new int[snapshot.Count + 1];
+            var indexStack = new int[snapshot.Count + 1];
+            var depth = 0;
+            nodeStack[0] = snapshot.Count;
+            indexStack[0] = offsets[snapshot.Count];
+            while (depth >= 0)
+            {
+                var node = nodeStack[depth];
+                var index = indexStack[depth];
+                if (index < offsets[node + 1])
+                {
+                    indexStack[depth] = index + 1;
+                    var child = children[index];
+                    var type = snapshot.Types[child];
+                    if (activeAncestors[type] == 0)
+                    {
+                        retainedBytes[type] += tree.RetainedSizes[child];
+                    }
+                    activeAncestors[type]++;
+                    depth++;
+                    nodeStack[depth] = child;
+                    indexStack[depth] = offsets[child];
+                }
+                else
+                {
+                    if (node != snapshot.Count)
+                    {
+                        activeAncestors[snapshot.Types[node]]--;
+                    }
+                    depth--;
+                }
+            }
+
+            return retainedBytes;
+        }
+
+        private static void Analyze(string path, int top)
+        {
+            var snapshot = HeapSnapshot.Load(path);
+            var tree = new DominatorTree(snapshot);
+            var retainedBytesByType = ComputeRetainedBytesByType(snapshot, tree);
+
+            var types = snapshot.TypeNames.
+                Select((typeName, index) => new TypeStatistics { TypeName = typeName, RetainedBytes = retainedBytesByType[index] }).
+                ToArray();
+            long totalBytes = 0;
+            long reachableCount = 0;
+            long reachableBytes = 0;
+            for (var instance = 0; instance < snapshot.Count; instance++)
+            {
+                var statistics = types[snapshot.Types[instance]];
+                statistics.Count++;
+                statistics.ShallowBytes += snapshot.Sizes[instance];
+                totalBytes += snapshot.Sizes[instance];
+                if (tree.IsReachable(instance))
+                {
+                    reachableCount++;
+                    reachableBytes += snapshot.Sizes[instance];
+                }
+                else
+                {
+                    statistics.UnreachableCount++;
+                }
+            }
+
+            Console.Out.WriteLine("Snapshot: {0}", path);
+            Console.Out.WriteLine("Instances: {0}, {1} bytes", snapshot.Count, totalBytes);
+            Console.Out.WriteLine("Reachable: {0}, {1} bytes", reachableCount, reachableBytes);
+            Console.Out.WriteLine("Unreachable (allocated after the last collection): {0}, {1} bytes",
+                snapshot.Count - reachableCount, totalBytes - reachableBytes);
+            Console.Out.WriteLine("Roots: {0}",
+                string.Join(", ", snapshot.Roots.
+                    GroupBy(root => root.Kind).
+                    OrderBy(g => g.Key).
+                    Select(g => string.Format("{0}={1}", g.Key, g.Count()))));
+            if (snapshot.UnknownReferences >= 1)
+            {
+                Console.Out.WriteLine("Unknown references: {0}", snapshot.UnknownReferences);
+            }
+
+            Console.Out.WriteLine();
+            Console.Out.WriteLine("{0,12} {1,14} {2,14} {3,12}  {4}", "count", "shallow", "retained", "unreachable", "type");
+            foreach (var statistics in types.
+                OrderByDescending(s => s.RetainedBytes).
+                ThenByDescending(s => s.ShallowBytes))
+            {
+                Console.Out.WriteLine("{0,12} {1,14} {2,14} {3,12}  {4}",
+                    statistics.Count,
+                    statistics.ShallowBytes,
+                    statistics.RetainedBytes,
+                    statistics.UnreachableCount,
+                    statistics.TypeName);
+            }
+
+            var rootKinds = new Dictionary<int, HashSet<RootKinds>>();
+            foreach (var root in snapshot.Roots)
+            {
+                if (!rootKinds.TryGetValue(root.Instance, out var kinds))
+                {
+                    kinds = new HashSet<RootKinds>();
+                    rootKinds.Add(root.Instance, kinds);
+                }
+                kinds.Add(root.Kind);
+            }
+
+            Console.Out.WriteLine();
+            Console.Out.WriteLine("Top {0} instances by retained size:", top);
+            Console.Out.WriteLine("{0,18} {1,14} {2,14}  {3}", "address", "shallow", "retained", "type [roots]");
+            foreach (var instance in tree.ReversePostorder.
+                OrderByDescending(instance => tree.RetainedSizes[instance]).
+                Take(top))
+            {
+                Console.Out.WriteLine("{0,18} {1,14} {2,14}  {3}{4}",
+                    "0x" + snapshot.Addresses[instance].ToString("x"),
+                    snapshot.Sizes[instance],
+                    tree.RetainedSizes[instance],
+                    snapshot.TypeNames[snapshot.Types[instance]],
+                    rootKinds.TryGetValue(instance, out var kinds) ?
+                        " [" + string.Join(", ", kinds.OrderBy(kind => kind)) + "]" :
+                        string.Empty);
+            }
+        }
+
+        public static int Main(string[] args)
+        {
+            try
+            {
+                if (args.Length < 1)
+                {
+                    Console.Out.WriteLine("usage: IL2C.HeapAnalyzer.exe <snapshot_path> [top_instances]");
+                    return 0;
+                }
+
+                var top = (args.Length >= 2) ? int.Parse(args[1]) : 20;
+                Analyze(args[0], top);
+                return 0;
+            }
+            catch (Exception ex)
+            {
+                Console.Error.WriteLine(ex);
+                return Marshal.GetHRForException(ex);
+            }
+        }
+    }
+}
@@ -18,7 +18,10 @@ extern /* static */ void System_GC_SuppressFinalize__System_Object(System_Object
 extern /* static */ void System_GC_ReRegisterForFinalize__System_Object(System_Object* obj);
 extern /* static */ void System_GC_WaitForPendingFinalizers(void);
 extern /* static */ void System_GC_Collect(void);
-#define System_GC_Collect__System_Int32(generation) System_GC_Collect()
+extern /* static */ void System_GC_Collect__System_Int32(int32_t generation);
+extern /* static */ int32_t System_GC_CollectionCount__System_Int32(int32_t generation);
+extern /* static */ int64_t System_GC_GetTotalMemory__System_Boolean(bool forceFullCollection);
+extern /* static */ int64_t System_GC_GetTotalAllocatedBytes__System_Boolean(bool precise);
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,11 @@
 #define IL2C_USE_LINE_INFORMATION
 #endif
 
+// Conservative stack scanning (GCC on x86-64/AArch64 Linux only):
+//   The GC scans the native stacks and the registers of the stopped threads instead of the execution frames.
+//   Both the runtime and the translated code (translated with the conservative stack scanning option) require it.
+//#define IL2C_USE_CONSERVATIVE_STACK_SCAN
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -182,6 +187,102 @@ extern void il2c_initialize(void);
 extern void il2c_shutdown(void);
 #endif
 
+///////////////////////////////////////////////////////
+// Garbage collector configuration
+
+typedef struct IL2C_GC_CONFIGURATION_DECL
+{
+    // Collect after allocated this bytes since the last collection. (0: default or IL2C_GC_ALLOCATION_BUDGET)
+    uintptr_t allocationBudget;
+    // Full collect when the old generation grows this percent over the surviving bytes. (0: default or IL2C_GC_HEAP_GROWTH)
+    uint32_t heapGrowthPercent;
+    // IL2C_GC_FLAG_*
+    uint32_t flags;
+    // Threads for the mark phase includes the collecting thread. (0: default or IL2C_GC_MARK_THREADS, default is the processor count)
+    uint32_t markThreads;
+    // Instances traced by an increment of the incremental marking. (0: default or IL2C_GC_MARK_STEP_WORK)
+    uint32_t markStepWork;
+    // Time limit of an increment in microseconds. (0: unlimited or IL2C_GC_MARK_STEP_TIME)
+    uint32_t markStepMicroseconds;
+    // The free heap blocks unused for this milliseconds are returned to the OS after the collection. (0: default or IL2C_GC_TRIM_DELAY)
+    uint32_t trimDelayMilliseconds;
+    // All free heap blocks are returned without the delay if the surviving bytes are less than
+    // this percent of the committed bytes. (0: default or IL2C_GC_TRIM_LIVE_PERCENT)
+    uint32_t trimLivePercent;
+} IL2C_GC_CONFIGURATION;
+
+// IL2C_GC_CONFIGURATION_DECL.flags
+#define IL2C_GC_FLAG_STRESS 0x01U                 // Collect at every allocation (for GC debugging, or IL2C_GC_STRESS=1)
+#define IL2C_GC_FLAG_DISABLE_GENERATIONAL 0x02U   // Always full collection (or IL2C_GC_DISABLE_GENERATIONAL=1)
+#define IL2C_GC_FLAG_BACKGROUND_SWEEP 0x04U       // Sweep by the dedicated sweeper thread (or IL2C_GC_BACKGROUND_SWEEP=1)
+#define IL2C_GC_FLAG_COMPACTION 0x08U             // GC.Collect() evacuates the sparse heap blocks (or IL2C_GC_COMPACTION=1)
+#define IL2C_GC_FLAG_INCREMENTAL 0x10U            // The full collection marks in the bounded increments (or IL2C_GC_INCREMENTAL=1)
+#define IL2C_GC_FLAG_DISABLE_TRIM 0x20U           // Never return the free heap blocks to the OS (or IL2C_GC_DISABLE_TRIM=1)
+
+// It can call before il2c_initialize(), the configuration will apply at initializing.
+extern void il2c_configure_gc(const IL2C_GC_CONFIGURATION* pConfiguration);
+
+///////////////////////////////////////////////////////
+// Garbage collector statistics
+
+typedef struct IL2C_GC_STATISTICS_DECL
+{
+    // Finished collections includes the full collections (GC.CollectionCount(0))
+    uint64_t collections;
+    // Finished full collections (GC.CollectionCount(1))
+    uint64_t fullCollections;
+    // Pause times, each increment of the incremental marking is a pause. (0 if the platform doesn't have the clock)
+    uint64_t totalPauseMicroseconds;
+    uint64_t maxPauseMicroseconds;
+    // Allocated bytes includes the instance headers (GC.GetTotalAllocatedBytes())
+    uint64_t allocatedBytes;
+    // Freed bytes by the sweeper
+    uint64_t freedBytes;
+    // Surviving bytes and instances at the last finished sweeping
+    uint64_t liveBytes;
+    uint64_t liveObjects;
+    // Surviving bytes and allocated bytes since the last collection (GC.GetTotalMemory())
+    uint64_t heapBytes;
+    // Called finalizers
+    uint64_t finalizersCalled;
+    // Bytes committed from the OS for the heap blocks and the large instances
+    uint64_t committedBytes;
+    // Committed bytes excluding the free heap blocks
+    uint64_t usedBytes;
+    // Bytes returned to the OS by the trimming
+    uint64_t trimmedBytes;
+} IL2C_GC_STATISTICS;
+
+// The counters are cumulative since il2c_initialize(), it doesn't stop the collection.
+extern void il2c_get_gc_statistics(IL2C_GC_STATISTICS* pStatistics);
+
+///////////////////////////////////////////////////////
+// Allocation profiler
+
+// Samples the allocations at every sampling bytes per thread (0: default 512KB.)
+//   The samples are attributed to the allocation site (type, file and line), the file and line are recorded
+//   if IL2C_USE_LINE_INFORMATION is defined. It's enabled at initializing by IL2C_ALLOCATION_PROFILE=<sampling bytes>,
+//   and the report is written at shutdown to IL2C_ALLOCATION_PROFILE_OUTPUT (*.pb or *.pprof is the pprof format.)
+extern void il2c_start_allocation_profiler(uintptr_t samplingBytes);
+extern void il2c_stop_allocation_profiler(void);
+extern void il2c_reset_allocation_profile(void);
+
+// il2c_dump_allocation_profile() format
+#define IL2C_ALLOCATION_PROFILE_FORMAT_TEXT 0U    // Sorted by bytes
+#define IL2C_ALLOCATION_PROFILE_FORMAT_PPROF 1U   // perftools.profiles.Profile (not compressed)
+
+// Writes the sampled allocations, returns false if failed or the platform doesn't support.
+extern bool il2c_dump_allocation_profile(const char* pPath, uint32_t format);
+
+///////////////////////////////////////////////////////
+// Heap snapshot
+
+// Writes all instances (type, size and references) and the roots holding them while the mutators are stopped.
+//   Returns false if failed or the platform doesn't support. The snapshot is analyzed by the IL2C.HeapAnalyzer tool.
+//   On Linux, IL2C_HEAP_SNAPSHOT_SIGNAL=1 makes SIGUSR2 write the snapshot to
+//   IL2C_HEAP_SNAPSHOT_OUTPUT (numbered: "<output>.<n>", default "il2c_heap.snapshot.<n>".)
+extern bool il2c_dump_heap_snapshot(const char* pPath);
+
 ///////////////////////////////////////////////////////
 // Runtime stack frame types
 
@@ -209,7 +310,6 @@ struct IL2C_EXCEPTION_FRAME_DECL
 
 struct IL2C_REF_HEADER_DECL
 {
-    IL2C_REF_HEADER* pNext;
     IL2C_RUNTIME_TYPE type;
     interlock_t characteristic;
 };
@@ -229,6 +329,7 @@ extern const uintptr_t typeName##_RUNTIME_TYPE__[]
 #define IL2C_TYPE_UNSIGNED_INTEGER (0x10 | IL2C_TYPE_INTEGER)
 #define IL2C_TYPE_STATIC 0x20
 #define IL2C_TYPE_INTERFACE 0x40
+#define IL2C_TYPE_POINTER_FREE 0x80     // The instance doesn't contain any objrefs
 
 #define il2c_typeof(typeName) \
     ((IL2C_RUNTIME_TYPE)&(typeName##_RUNTIME_TYPE__))
@@ -288,15 +389,19 @@ extern void* il2c_unlink_execution_frame__(/* IL2C_EXECUTION_FRAME* */ volatile
 #define il2c_unlink_execution_frame(pFrame, pReference) il2c_unlink_execution_frame__((pFrame), (pReference))
 #endif
 
-extern void* il2c_cleanup_at_return__(void* pReference);
+// The method elided the execution frame is the plain C function, it doesn't make the thread RUNNING
+//   or hold its objref arguments. So the native code has to call the managed methods inside
+//   the execution frame holding the objref arguments (same as the thread entry point and the delegate invoker.)
+//   The caller holds the returned objref in its C local variable and spills it at the next GC point,
+//   the GC doesn't run before that because the thread is RUNNING inside the caller's execution frame.
 #define il2c_return() \
-    il2c_cleanup_at_return__(NULL); return
-#define il2c_return_unlink(pFrame) \
-    il2c_unlink_execution_frame((pFrame), NULL); return
+    return
 #define il2c_return_with_objref(pReference) \
-    return il2c_cleanup_at_return__(pReference)
+    return (pReference)
 #define il2c_return_with_value(value) \
-    il2c_cleanup_at_return__(NULL); return (value)
+    return (value)
+#define il2c_return_unlink(pFrame) \
+    il2c_unlink_execution_frame((pFrame), NULL); return
 #define il2c_return_unlink_with_objref(pFrame, pReference) \
     return il2c_unlink_execution_frame((pFrame), (pReference))
 #define il2c_return_unlink_with_value(pFrame, value) \
@@ -305,6 +410,37 @@ extern void* il2c_cleanup_at_return__(void* pReference);
 extern const uintptr_t* il2c_initializer_count;
 extern void il2c_register_static_fields(/* IL2C_STATIC_FIELDS* */ volatile void* pStaticFields);
 
+// The write barriers for the generational GC, have to invoke after stored objref (or value type contains objref.)
+//   il2c_write_barrier: The stored target is the instance (field or array element.)
+//   il2c_write_barrier_for_address: The stored target is the managed reference (may point to the heap.)
+extern void il2c_write_barrier__(/* System_Object* */ void* pReference);
+extern void il2c_write_barrier_for_address__(void* pAddress);
+#define il2c_write_barrier(pReference) il2c_write_barrier__((void*)(pReference))
+#define il2c_write_barrier_for_address(pAddress) il2c_write_barrier_for_address__((void*)(pAddress))
+
+// The safepoint poll, the translated code invokes at the loop back-edges.
+//   (The method entry and the allocation poll inside the runtime.
+//    The translated code polls at the method entry too if IL2C_USE_CONSERVATIVE_STACK_SCAN.)
+extern volatile interlock_t g_SafepointRequested__;
+extern void il2c_safepoint__(void);
+#define il2c_poll_safepoint() \
+    do { if (il2c_unlikely__(g_SafepointRequested__ != 0)) il2c_safepoint__(); } while (0)
+// The translated code keeps the objrefs in the C local variables and stores these to the execution frame
+//   only when GC is requested. (The arguments are the assignment expressions.)
+//   il2c_safepoint__() is the external function call, so the compiler can't reorder the stores across it.
+#define il2c_poll_safepoint_with_spill(...) \
+    do { if (il2c_unlikely__(g_SafepointRequested__ != 0)) { __VA_ARGS__; il2c_safepoint__(); } } while (0)
+
+// The native code has to enter the safe region before blocking (ex: waiting for the other thread),
+//   the GC doesn't wait for the thread inside it. It can't touch the managed instances inside it.
+//   il2c_leave_safe_region() takes the result of il2c_enter_safe_region() (it can nest.)
+//   If IL2C_USE_CONSERVATIVE_STACK_SCAN, the attached thread is always RUNNING outside of it:
+//   The native code has to enter it before blocking, and has to detach the native thread before exit.
+extern bool il2c_enter_safe_region(void);
+extern void il2c_leave_safe_region(bool entered);
+// The attached native thread (called the managed code) gives back the thread local resources before exit.
+extern void il2c_detach_current_thread(void);
+
 ///////////////////////////////////////////////////////
 // Basic exceptions
 
@@ -504,6 +640,7 @@ const uintptr_t typeName##_RUNTIME_TYPE__[] = { \
 #define IL2C_RUNTIME_TYPE_INTERFACE_BEGIN(typeName, typeNameString, interfaceCount) \
     IL2C_RUNTIME_TYPE_BEGIN__(typeName, typeNameString, IL2C_TYPE_INTERFACE, 0, NULL, NULL, 0, interfaceCount)
 
+// The fieldName can be the member designator for the objref inside the value type field (ex: value__.message__)
 #define IL2C_RUNTIME_TYPE_MARK_TARGET_FOR_REFERENCE(typeName, fieldName) \
     0, \
     offsetof(typeName, fieldName),
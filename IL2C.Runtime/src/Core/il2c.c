@@ -2,13 +2,9 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef volatile struct IL2C_ROOT_REFERENCES_DECL IL2C_ROOT_REFERENCES;
 typedef struct IL2C_MONITOR_LOCK_BLOCK_INFORMATION_DECL IL2C_MONITOR_LOCK_BLOCK_INFORMATION;
 typedef void(*il2c_sighandler)(int sig);
 
-extern IL2C_REF_HEADER* g_pBeginHeader__;
-extern IL2C_ROOT_REFERENCES* g_pRootReferences__;
-extern IL2C_ROOT_REFERENCES* g_pFixedReferences__;
 extern IL2C_STATIC_FIELDS* g_pBeginStaticFields__;
 
 extern IL2C_MONITOR_LOCK_BLOCK_INFORMATION* g_MonitorLockBlockInformations__[7];
@@ -143,6 +139,7 @@ System_ValueType* il2c_box__(
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         valueType,
         bodySize,
+        (valueType->flags & IL2C_TYPE_POINTER_FREE) != 0,
         pFile,
         line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -150,7 +147,8 @@ System_ValueType* il2c_box__(
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         valueType,
-        bodySize);
+        bodySize,
+        (valueType->flags & IL2C_TYPE_POINTER_FREE) != 0);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -287,6 +285,7 @@ System_ValueType* il2c_box2__(
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         valueType,
         bodySize,
+        (valueType->flags & IL2C_TYPE_POINTER_FREE) != 0,
         pFile,
         line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -294,7 +293,8 @@ System_ValueType* il2c_box2__(
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         valueType,
-        bodySize);
+        bodySize,
+        (valueType->flags & IL2C_TYPE_POINTER_FREE) != 0);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -355,14 +355,20 @@ void il2c_initialize__(void)
 
     g_TlsIndex__ = il2c_tls_alloc();
 
-    g_pBeginHeader__ = NULL;
     g_pBeginStaticFields__ = NULL;
-    g_pRootReferences__ = NULL;
-    g_pFixedReferences__ = NULL;
+    il2c_initialize_root_references__();
 
     memset(&g_MonitorLockBlockInformations__[0], 0, sizeof g_MonitorLockBlockInformations__);
 
     il2c_initialize_monitor_lock__(&g_GlobalLockForCollect__);
+    il2c_initialize_gc_configuration__();
+    il2c_initialize_allocation_profiler__();
+    il2c_initialize_generations__();
+    il2c_initialize_mark_workers__();
+    il2c_heap_initialize__();
+    il2c_initialize_sweeper__();
+    il2c_initialize_finalizer__();
+    il2c_initialize_heap_snapshot__();
 
 #if defined(_DEBUG)
     g_CollectCountBreak = -1;
@@ -375,7 +381,15 @@ void il2c_initialize__(void)
 
 void il2c_shutdown__(void)
 {
+    il2c_shutdown_heap_snapshot__();
+    il2c_shutdown_allocation_profiler__();
+    il2c_shutdown_finalizer__();
+    il2c_shutdown_sweeper__();
     il2c_collect_for_final_shutdown__();
+    il2c_shutdown_mark_workers__();
+    il2c_shutdown_generations__();
+    il2c_heap_shutdown__();
+    il2c_shutdown_root_references__();
 
 #ifdef IL2C_USE_SIGNAL
     signal(SIGSEGV, g_SIGSEGV_saved);
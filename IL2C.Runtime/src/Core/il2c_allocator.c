@@ -3,9 +3,7 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 extern IL2C_TLS_INDEX g_TlsIndex__;
-extern interlock_t g_CollectionMarkIndex__;
 
-IL2C_REF_HEADER* g_pBeginHeader__ = NULL;
 IL2C_ROOT_REFERENCES* g_pRootReferences__ = NULL;
 IL2C_ROOT_REFERENCES* g_pFixedReferences__ = NULL;
 IL2C_STATIC_FIELDS* g_pBeginStaticFields__ = NULL;
@@ -13,22 +11,57 @@ IL2C_STATIC_FIELDS* g_pBeginStaticFields__ = NULL;
 /////////////////////////////////////////////////////////////
 // Instance allocator functions
 
+static IL2C_REF_HEADER* il2c_allocate_from_heap__(IL2C_RUNTIME_TYPE type, uintptr_t size, bool pointerFree)
+{
+    // The thread context isn't attached when allocating the thread instance itself.
+    IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
+    if (il2c_unlikely__(pThreadContext == NULL))
+    {
+        if (type == il2c_typeof(System_Threading_Thread))
+        {
+            return il2c_heap_allocate__(NULL, type, size, pointerFree);
+        }
+
+        // Attach before allocating: The GC doesn't stop the unattached thread,
+        // so the instance allocated from the shared heap may be swept while the collection is running.
 #if defined(IL2C_USE_LINE_INFORMATION)
-IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
-    IL2C_RUNTIME_TYPE type, uintptr_t bodySize, const char* pFile, int line)
+        pThreadContext = il2c_acquire_thread_context__(__FILE__, __LINE__);
 #else
-IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
-    IL2C_RUNTIME_TYPE type, uintptr_t bodySize)
+        pThreadContext = il2c_acquire_thread_context__();
 #endif
-{
-    il2c_assert(type != NULL);
+    }
+
+    // Allocate from the thread local allocation buffer.
+    // The GC retires these buffers after stopped the thread at the safepoint,
+    // so the thread without execution frames (SAFE) runs as the mutator while allocating.
+    const bool safe = (pThreadContext->safepointState != IL2C_SAFEPOINT_STATE_RUNNING);
+    if (il2c_unlikely__(safe))
+    {
+        il2c_leave_safe_region__(pThreadContext);
+    }
+
+    il2c_enter_giant_lock__();
+    IL2C_REF_HEADER* pHeader = il2c_heap_allocate__(
+        (IL2C_HEAP_ALLOCATION_CONTEXT*)&pThreadContext->allocationContext, type, size, pointerFree);
+    il2c_exit_giant_lock__();
+
+    if (il2c_unlikely__(safe))
+    {
+        il2c_enter_safe_region__(pThreadContext);
+    }
+
+    return pHeader;
+}
 
-    // TODO: always collect
 #if defined(IL2C_USE_LINE_INFORMATION)
-    il2c_collect__(pFile, line);
+IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
+    IL2C_RUNTIME_TYPE type, uintptr_t bodySize, bool pointerFree, const char* pFile, int line)
 #else
-    il2c_collect__();
+IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
+    IL2C_RUNTIME_TYPE type, uintptr_t bodySize, bool pointerFree)
 #endif
+{
+    il2c_assert(type != NULL);
 
     // +----------------------+ <-- pHeader
     // | IL2C_REF_HEADER      |
@@ -39,11 +72,21 @@ IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
     // +----------------------+                  -------
 
     const uintptr_t totalSize = sizeof(IL2C_REF_HEADER) + bodySize;
+
+    // The allocation is the safepoint.
+    il2c_poll_safepoint();
+
+    // Collect if exhausted the allocation budget.
+    if (il2c_unlikely__(il2c_consume_allocation_budget__(totalSize)))
+    {
 #if defined(IL2C_USE_LINE_INFORMATION)
-    IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)il2c_malloc(totalSize, pFile, line);
+        il2c_collect__(pFile, line);
 #else
-    IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)il2c_malloc(totalSize);
+        il2c_collect__();
 #endif
+    }
+
+    IL2C_REF_HEADER* pHeader = il2c_allocate_from_heap__(type, totalSize, pointerFree);
     if (il2c_unlikely__(pHeader == NULL))
     {
         while (1)
@@ -56,11 +99,7 @@ IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
 #endif
 
             // Retry
-#if defined(IL2C_USE_LINE_INFORMATION)
-            pHeader = (IL2C_REF_HEADER*)il2c_malloc(totalSize, pFile, line);
-#else
-            pHeader = (IL2C_REF_HEADER*)il2c_malloc(totalSize);
-#endif
+            pHeader = il2c_allocate_from_heap__(type, totalSize, pointerFree);
             if (il2c_likely__(pHeader != NULL))
             {
                 break;
@@ -71,11 +110,26 @@ IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
         }
     }
 
-    // Guarantee cleared body
-    memset((void*)pHeader, 0, totalSize);
+#if defined(IL2C_USE_ALLOCATION_PROFILER)
+    if (il2c_unlikely__(g_AllocationSamplingBytes__ != 0))
+    {
+#if defined(IL2C_USE_LINE_INFORMATION)
+        il2c_sample_allocation__(type, totalSize, pFile, line);
+#else
+        il2c_sample_allocation__(type, totalSize, NULL, 0);
+#endif
+    }
+#endif
 
-    // Set RTTI.
-    pHeader->type = type;
+    // NOTE: Entered critical section for partially construted instance.
+    //   The heap allocator already set the header with NOT MARKED (young) and NOT INITIALIZED,
+    //   IL2C will make the mark INITIALIZED.
+
+    // Guarantee cleared body
+    if (il2c_likely__(!il2c_heap_is_zero_filled__(pHeader)))
+    {
+        memset((void*)(pHeader + 1), 0, bodySize);
+    }
 
     // Setup vptr0.
     System_Object* pReference = (System_Object*)(((uint8_t*)pHeader) + sizeof(IL2C_REF_HEADER));
@@ -96,30 +150,12 @@ IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
         *((const void**)(((uint8_t*)pReference) + offset)) = pInterface->vptr0;
     }
 
-    // FOR GC TEST.
-    //il2c_sleep(100);
-
-    // Safe link both headers.
-    while (1)
+    // The collection finds the unreachable instances with the finalizer from the registered list.
+    if (il2c_unlikely__((void*)((System_Object_VTABLE_DECL__*)(type->vptr0))->Finalize != (void*)System_Object_Finalize))
     {
-        IL2C_REF_HEADER* pNext = g_pBeginHeader__;
-        pHeader->pNext = pNext;
-        if (il2c_likely__((IL2C_REF_HEADER*)il2c_icmpxchgptr(&g_pBeginHeader__, pHeader, pNext) == pNext))
-        {
-            break;
-        }
+        il2c_register_finalizable__(pReference);
     }
 
-    // NOTE: Entered critical section for partially construted instance.
-    //   IL2C will make the mark INITIALIZED.
-
-    // HACK: Current GC mark status is same as g_CollectionMarkIndex__,
-    // it means MARKED but NOT INITIALIZED.
-    pHeader->characteristic = g_CollectionMarkIndex__;
-
-    // FOR GC TEST.
-    //il2c_sleep(100);
-
     return pHeader;
 }
 
@@ -140,12 +176,12 @@ void* il2c_get_uninitialized_object__(IL2C_RUNTIME_TYPE type)
     // Allocate heap memory.
 #if defined(IL2C_USE_LINE_INFORMATION)
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
-        type, type->bodySize, pFile, line);
+        type, type->bodySize, (type->flags & IL2C_TYPE_POINTER_FREE) != 0, pFile, line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
         pFile, line);
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
-        type, type->bodySize);
+        type, type->bodySize, (type->flags & IL2C_TYPE_POINTER_FREE) != 0);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -177,21 +213,24 @@ void il2c_link_execution_frame__(/* EXECUTION_FRAME__* */ volatile void* pNewFra
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
-    // Touch for lock region.
-    il2c_enter_monitor_lock__((void*)IL2C_THREAD_LOCK_TARGET(pThreadContext));
-
-    while (1)
+    // The first frame (or calling back from the safe region) makes the thread RUNNING,
+    // so the GC doesn't read the frames while linking.
+    if (il2c_unlikely__(pThreadContext->safepointState != IL2C_SAFEPOINT_STATE_RUNNING))
     {
-        IL2C_EXECUTION_FRAME* pNext = pThreadContext->pFrame;
-        ((IL2C_EXECUTION_FRAME*)pNewFrame)->pNext__ = pNext;
-        if (il2c_likely__(il2c_icmpxchgptr(&pThreadContext->pFrame, pNewFrame, pNext) == pNext))
-        {
-            break;
-        }
+        il2c_leave_safe_region__(pThreadContext);
     }
 
-    // Exit for lock region.
-    il2c_exit_monitor_lock__((void*)IL2C_THREAD_LOCK_TARGET(pThreadContext));
+    // Only this thread updates the frames while RUNNING.
+    il2c_enter_giant_lock__();
+    ((IL2C_EXECUTION_FRAME*)pNewFrame)->pNext__ = pThreadContext->pFrame;
+    pThreadContext->pFrame = pNewFrame;
+    il2c_exit_giant_lock__();
+
+    // The method entry is the safepoint.
+    if (il2c_unlikely__(g_SafepointRequested__ != 0))
+    {
+        il2c_park_at_safepoint__(pThreadContext);
+    }
 }
 
 #if defined(IL2C_USE_LINE_INFORMATION)
@@ -202,43 +241,32 @@ void* il2c_unlink_execution_frame__(/* EXECUTION_FRAME__* */ volatile void* pFra
 {
     il2c_assert(pFrame != NULL);
 
-    // TODO: always collect
-#if defined(IL2C_USE_LINE_INFORMATION)
-    il2c_collect__(pFile, line);
-#else
-    il2c_collect__();
-#endif
-
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
     il2c_assert(pThreadContext != NULL);
 
     // Save retval into temporary reference anchor.
     pThreadContext->pTemporaryReferenceAnchor = pReference;
 
-    // Touch for lock region.
-    il2c_enter_monitor_lock__((void*)IL2C_THREAD_LOCK_TARGET(pThreadContext));
-
+    il2c_enter_giant_lock__();
     il2c_assert(pThreadContext->pFrame == pFrame);
-    pThreadContext->pFrame = ((IL2C_EXECUTION_FRAME*)pFrame)->pNext__;
-
-    // Exit for lock region.
-    il2c_exit_monitor_lock__((void*)IL2C_THREAD_LOCK_TARGET(pThreadContext));
+    IL2C_EXECUTION_FRAME* pNext = ((IL2C_EXECUTION_FRAME*)pFrame)->pNext__;
+    pThreadContext->pFrame = pNext;
+    il2c_exit_giant_lock__();
+
+#if !defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+    // The thread without execution frames doesn't stop at the safepoint,
+    // it may return to the native code and block (or exit.)
+    if (il2c_unlikely__(pNext == NULL))
+    {
+        il2c_enter_safe_region__(pThreadContext);
+    }
+#endif
 
     // TODO: Remove thread context for the last frame?
 
     return pReference;
 }
 
-void* il2c_cleanup_at_return__(void* pReference)
-{
-    IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
-    il2c_assert(pThreadContext != NULL);
-
-    pThreadContext->pTemporaryReferenceAnchor = pReference;
-
-    return pReference;
-}
-
 /////////////////////////////////////////////////////////////
 // Static fields manipulator functions
 
@@ -265,125 +293,230 @@ void il2c_register_static_fields(/* IL2C_STATIC_FIELDS* */ volatile void* pStati
 /////////////////////////////////////////////////////////////
 // Root reference manipulator functions
 
-void il2c_register_root_reference__(void* pReference, bool isFixed)
+// The root references are the slab allocated handle table.
+// The handle is (slab index * IL2C_ROOT_REFERENCES_SLAB_SIZE + slot index + 1), zero is the invalid handle.
+// The free slots are chained by the handle, so register and unregister are O(1).
+// The GC doesn't know the table, it scans the published slab list (g_pRootReferences__, g_pFixedReferences__.)
+// The slab index is read without the lock, so the expanded index keeps the previous one
+// at the tail (ppSlabs[slabCapacity]) and these are freed at the final shutdown.
+typedef struct IL2C_ROOT_REFERENCE_TABLE_DECL
+{
+    IL2C_MONITOR_LOCK lock;
+    IL2C_ROOT_REFERENCES** ppRootReferences;
+    IL2C_ROOT_REFERENCES* volatile* volatile ppSlabs;
+    uintptr_t slabCount;
+    uintptr_t slabCapacity;
+    uintptr_t freeHandle;
+} IL2C_ROOT_REFERENCE_TABLE;
+
+static IL2C_ROOT_REFERENCE_TABLE g_RootReferenceTable__;
+static IL2C_ROOT_REFERENCE_TABLE g_FixedReferenceTable__;
+
+static void il2c_initialize_root_reference_table__(
+    IL2C_ROOT_REFERENCE_TABLE* pTable, IL2C_ROOT_REFERENCES** ppRootReferences)
 {
-    il2c_assert(pReference != NULL);
+    il2c_initialize_monitor_lock__(&pTable->lock);
+    pTable->ppRootReferences = ppRootReferences;
+    pTable->ppSlabs = NULL;
+    pTable->slabCount = 0;
+    pTable->slabCapacity = 0;
+    pTable->freeHandle = 0;
+}
 
-    System_Object* pAdjustedReference = il2c_adjusted_reference(pReference);
+void il2c_initialize_root_references__(void)
+{
+    g_pRootReferences__ = NULL;
+    g_pFixedReferences__ = NULL;
 
-    // TODO: O(n) order
-    IL2C_ROOT_REFERENCES** ppRootReferences = isFixed ?
-        &g_pFixedReferences__ :
-        &g_pRootReferences__;
-    volatile System_Object* volatile* ppFreeReference = NULL;
-    IL2C_ROOT_REFERENCES* pCurrentRootReferences = *ppRootReferences;
-    while (il2c_likely__(pCurrentRootReferences != NULL))
-    {
-        uint8_t index;
-        volatile System_Object* volatile* ppReference;
-        for (index = 0, ppReference = &pCurrentRootReferences->pReferences[0];
-            il2c_likely__(index < sizeof(pCurrentRootReferences->pReferences) / sizeof(void*));
-            index++, ppReference++)
-        {
-            if (il2c_unlikely__(*ppReference == pAdjustedReference))
-            {
-                // Already registered.
-                return;
-            }
-            if (il2c_unlikely__(*ppReference == NULL))
-            {
-                // Memoize free position.
-                if (il2c_unlikely__(ppFreeReference == NULL))
-                {
-                    ppFreeReference = ppReference;
-                }
-            }
-        }
+    il2c_initialize_root_reference_table__(&g_RootReferenceTable__, &g_pRootReferences__);
+    il2c_initialize_root_reference_table__(&g_FixedReferenceTable__, &g_pFixedReferences__);
+}
 
-        pCurrentRootReferences = pCurrentRootReferences->pNext;
-    }
+void il2c_shutdown_root_references__(void)
+{
+    il2c_assert(g_RootReferenceTable__.ppSlabs == NULL);
+    il2c_assert(g_FixedReferenceTable__.ppSlabs == NULL);
+
+    il2c_destroy_monitor_lock__(&g_FixedReferenceTable__.lock);
+    il2c_destroy_monitor_lock__(&g_RootReferenceTable__.lock);
+}
+
+static IL2C_ROOT_REFERENCE_TABLE* il2c_get_root_reference_table__(bool isFixed)
+{
+    return isFixed ? &g_FixedReferenceTable__ : &g_RootReferenceTable__;
+}
 
-    // If detected free slot.
-    if (il2c_likely__(ppFreeReference != NULL))
+// It can call without the table lock if the handle is registered.
+static IL2C_ROOT_REFERENCES* il2c_get_root_reference_slab__(
+    IL2C_ROOT_REFERENCE_TABLE* pTable, uintptr_t handle)
+{
+    il2c_assert(handle >= 1);
+    il2c_assert(((handle - 1) / IL2C_ROOT_REFERENCES_SLAB_SIZE) < pTable->slabCount);
+
+    return pTable->ppSlabs[(handle - 1) / IL2C_ROOT_REFERENCES_SLAB_SIZE];
+}
+
+// Have to hold the table lock.
+static void il2c_append_root_reference_slab__(IL2C_ROOT_REFERENCE_TABLE* pTable)
+{
+    if (il2c_unlikely__(pTable->slabCount >= pTable->slabCapacity))
     {
-        // Try store.
-        if (il2c_likely__(il2c_icmpxchgptr(ppFreeReference, pAdjustedReference, NULL) == NULL))
+        uintptr_t slabCapacity = (pTable->slabCapacity >= 1) ? (pTable->slabCapacity * 2) : 4;
+#if defined(IL2C_USE_LINE_INFORMATION)
+        IL2C_ROOT_REFERENCES** ppSlabs = il2c_malloc((slabCapacity + 1) * sizeof(IL2C_ROOT_REFERENCES*), __FILE__, __LINE__);
+#else
+        IL2C_ROOT_REFERENCES** ppSlabs = il2c_malloc((slabCapacity + 1) * sizeof(IL2C_ROOT_REFERENCES*));
+#endif
+        // TODO: OutOfMemoryException
+        il2c_assert(ppSlabs != NULL);
+
+        if (pTable->ppSlabs != NULL)
         {
-            // Success.
-            return;
+            memcpy(ppSlabs, (void*)pTable->ppSlabs, pTable->slabCount * sizeof(IL2C_ROOT_REFERENCES*));
         }
-    }
 
-    // Nothing free place (or failed), append new slots.
-    // It's safe for duplicates new slots rarely critical timing...
+        // The readers without the lock may still refer the previous index.
+        ppSlabs[slabCapacity] = (IL2C_ROOT_REFERENCES*)pTable->ppSlabs;
+
+        // Publish after copied.
+        (void)il2c_ixchgptr(&pTable->ppSlabs, ppSlabs);
+        pTable->slabCapacity = slabCapacity;
+    }
 
 #if defined(IL2C_USE_LINE_INFORMATION)
-    pCurrentRootReferences = il2c_malloc(sizeof(IL2C_ROOT_REFERENCES), __FILE__, __LINE__);
+    IL2C_ROOT_REFERENCES* pSlab = il2c_malloc(sizeof(IL2C_ROOT_REFERENCES), __FILE__, __LINE__);
 #else
-    pCurrentRootReferences = il2c_malloc(sizeof(IL2C_ROOT_REFERENCES));
+    IL2C_ROOT_REFERENCES* pSlab = il2c_malloc(sizeof(IL2C_ROOT_REFERENCES));
 #endif
-    memset((void*)pCurrentRootReferences, 0, sizeof(IL2C_ROOT_REFERENCES));
+    // TODO: OutOfMemoryException
+    il2c_assert(pSlab != NULL);
+    memset((void*)pSlab, 0, sizeof(IL2C_ROOT_REFERENCES));
+
+    // Chain all slots into the free list (the lower slot is used first.)
+    uintptr_t baseHandle = pTable->slabCount * IL2C_ROOT_REFERENCES_SLAB_SIZE + 1;
+    uintptr_t index;
+    for (index = 0; index < (IL2C_ROOT_REFERENCES_SLAB_SIZE - 1); index++)
+    {
+        pSlab->freeHandles[index] = baseHandle + index + 1;
+    }
+    pSlab->freeHandles[IL2C_ROOT_REFERENCES_SLAB_SIZE - 1] = pTable->freeHandle;
+    pTable->freeHandle = baseHandle;
 
-    pCurrentRootReferences->pReferences[0] = pAdjustedReference;
+    // The handles in this slab are given after released the lock, so the readers see this entry.
+    pTable->ppSlabs[pTable->slabCount++] = pSlab;
 
+    // Publish to the GC after initialized.
     while (1)
     {
-        IL2C_ROOT_REFERENCES* pNext = *ppRootReferences;
-        pCurrentRootReferences->pNext = pNext;
-        if (il2c_likely__(il2c_icmpxchgptr(ppRootReferences, pCurrentRootReferences, pNext) == pNext))
+        IL2C_ROOT_REFERENCES* pNext = *pTable->ppRootReferences;
+        pSlab->pNext = pNext;
+        if (il2c_likely__(il2c_icmpxchgptr(pTable->ppRootReferences, pSlab, pNext) == pNext))
         {
             break;
         }
     }
 }
 
-void il2c_unregister_root_reference__(void* pReference, bool isFixed)
+uintptr_t il2c_register_root_reference__(void* pReference, bool isFixed)
 {
-    il2c_assert(pReference != NULL);
+    System_Object* pAdjustedReference = (pReference != NULL) ?
+        il2c_adjusted_reference(pReference) :
+        NULL;
 
-    System_Object* pAdjustedReference = il2c_adjusted_reference(pReference);
+    IL2C_ROOT_REFERENCE_TABLE* pTable = il2c_get_root_reference_table__(isFixed);
 
-    // TODO: O(n) order
-    IL2C_ROOT_REFERENCES** ppRootReferences = isFixed ?
-        &g_pFixedReferences__ :
-        &g_pRootReferences__;
-    IL2C_ROOT_REFERENCES* pCurrentRootReferences = *ppRootReferences;
-    while (il2c_likely__(pCurrentRootReferences != NULL))
-    {
-        uint8_t index;
-        volatile System_Object* volatile* ppReference;
-        for (index = 0, ppReference = &pCurrentRootReferences->pReferences[0];
-            il2c_likely__(index < sizeof(pCurrentRootReferences->pReferences) / sizeof(void*));
-            index++, ppReference++)
-        {
-            if (il2c_unlikely__(*ppReference == pAdjustedReference))
-            {
-                // Found, unregister.
-                *ppReference = NULL;
-                return;
-            }
-        }
+    il2c_enter_monitor_lock__(&pTable->lock);
 
-        pCurrentRootReferences = pCurrentRootReferences->pNext;
+    if (il2c_unlikely__(pTable->freeHandle == 0))
+    {
+        il2c_append_root_reference_slab__(pTable);
     }
+
+    uintptr_t handle = pTable->freeHandle;
+    IL2C_ROOT_REFERENCES* pSlab = il2c_get_root_reference_slab__(pTable, handle);
+    uintptr_t index = (handle - 1) % IL2C_ROOT_REFERENCES_SLAB_SIZE;
+
+    pTable->freeHandle = pSlab->freeHandles[index];
+    pSlab->freeHandles[index] = 0;
+    pSlab->pReferences[index] = pAdjustedReference;
+
+    il2c_exit_monitor_lock__(&pTable->lock);
+
+    return handle;
 }
 
-void il2c_unregister_all_root_references_for_final_shutdown__(IL2C_ROOT_REFERENCES** ppRootReferences)
+void il2c_unregister_root_reference__(uintptr_t handle, bool isFixed)
 {
-    while (1)
-    {
-        IL2C_ROOT_REFERENCES* pCurrentRootReferences = *ppRootReferences;
-        if (il2c_unlikely__(pCurrentRootReferences == NULL))
-        {
-            break;
-        }
+    IL2C_ROOT_REFERENCE_TABLE* pTable = il2c_get_root_reference_table__(isFixed);
 
-        IL2C_ROOT_REFERENCES* pNext = pCurrentRootReferences->pNext;
-        if (il2c_unlikely__(il2c_icmpxchgptr(ppRootReferences, pNext, pCurrentRootReferences) != pCurrentRootReferences))
-        {
-            continue;
-        }
+    il2c_enter_monitor_lock__(&pTable->lock);
+
+    IL2C_ROOT_REFERENCES* pSlab = il2c_get_root_reference_slab__(pTable, handle);
+    uintptr_t index = (handle - 1) % IL2C_ROOT_REFERENCES_SLAB_SIZE;
+    il2c_assert(pSlab->freeHandles[index] == 0);
+
+    pSlab->pReferences[index] = NULL;
+    pSlab->freeHandles[index] = pTable->freeHandle;
+    pTable->freeHandle = handle;
 
-        il2c_free((void*)pCurrentRootReferences);
+    il2c_exit_monitor_lock__(&pTable->lock);
+}
+
+// The slot of the registered handle is stable (the compaction anchors the root references, never moves),
+// so it's read without the table lock same as the GC.
+System_Object* il2c_get_root_reference__(uintptr_t handle, bool isFixed)
+{
+    IL2C_ROOT_REFERENCE_TABLE* pTable = il2c_get_root_reference_table__(isFixed);
+
+    IL2C_ROOT_REFERENCES* pSlab = il2c_get_root_reference_slab__(pTable, handle);
+    return (System_Object*)pSlab->pReferences[(handle - 1) % IL2C_ROOT_REFERENCES_SLAB_SIZE];
+}
+
+void il2c_set_root_reference__(uintptr_t handle, void* pReference, bool isFixed)
+{
+    System_Object* pAdjustedReference = (pReference != NULL) ?
+        il2c_adjusted_reference(pReference) :
+        NULL;
+
+    IL2C_ROOT_REFERENCE_TABLE* pTable = il2c_get_root_reference_table__(isFixed);
+
+    il2c_enter_monitor_lock__(&pTable->lock);
+
+    IL2C_ROOT_REFERENCES* pSlab = il2c_get_root_reference_slab__(pTable, handle);
+    pSlab->pReferences[(handle - 1) % IL2C_ROOT_REFERENCES_SLAB_SIZE] = pAdjustedReference;
+
+    il2c_exit_monitor_lock__(&pTable->lock);
+}
+
+void il2c_unregister_all_root_references_for_final_shutdown__(bool isFixed)
+{
+    IL2C_ROOT_REFERENCE_TABLE* pTable = il2c_get_root_reference_table__(isFixed);
+
+    il2c_enter_monitor_lock__(&pTable->lock);
+
+    *pTable->ppRootReferences = NULL;
+
+    uintptr_t index;
+    for (index = 0; index < pTable->slabCount; index++)
+    {
+        il2c_free((void*)pTable->ppSlabs[index]);
     }
+
+    // Free the index and the previous ones (the capacity is doubled at each expansion.)
+    IL2C_ROOT_REFERENCES** ppSlabs = (IL2C_ROOT_REFERENCES**)pTable->ppSlabs;
+    uintptr_t slabCapacity = pTable->slabCapacity;
+    while (ppSlabs != NULL)
+    {
+        IL2C_ROOT_REFERENCES** ppPreviousSlabs = (IL2C_ROOT_REFERENCES**)ppSlabs[slabCapacity];
+        il2c_free(ppSlabs);
+        ppSlabs = ppPreviousSlabs;
+        slabCapacity /= 2;
+    }
+
+    pTable->ppSlabs = NULL;
+    pTable->slabCount = 0;
+    pTable->slabCapacity = 0;
+    pTable->freeHandle = 0;
+
+    il2c_exit_monitor_lock__(&pTable->lock);
 }
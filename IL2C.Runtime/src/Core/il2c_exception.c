@@ -54,6 +54,14 @@ static il2c_noreturn__ void il2c_do_throw__(
     // Update execution frame.
     pThreadContext->pFrame = pTargetFrame->pFrame;
 
+#if !defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+    // Same as unlinked the last frame.
+    if (il2c_unlikely__(pTargetFrame->pFrame == NULL))
+    {
+        il2c_enter_safe_region__(pThreadContext);
+    }
+#endif
+
     // Transision to target handler.
     il2c_longjmp((void*)pTargetFrame->saved, filterNumber);
 }
@@ -4,7 +4,6 @@
 
 extern IL2C_TLS_INDEX g_TlsIndex__;
 
-extern IL2C_REF_HEADER* g_pBeginHeader__;
 extern IL2C_ROOT_REFERENCES* g_pRootReferences__;
 extern IL2C_ROOT_REFERENCES* g_pFixedReferences__;
 extern IL2C_STATIC_FIELDS* g_pBeginStaticFields__;
@@ -12,9 +11,8 @@ extern IL2C_STATIC_FIELDS* g_pBeginStaticFields__;
 // Stop the world global lock.
 IL2C_MONITOR_LOCK g_GlobalLockForCollect__;
 
-interlock_t g_CollectionMarkIndex__ = 0; //  IL2C_CHARACTERISTIC_MARK_INDEX;
 static interlock_t g_ExecutingCollection__ = 0;
-volatile uint32_t g_PendingRemains__ = 0;
+static volatile uint32_t g_PendingRemains__ = 0;
 
 #if defined(_DEBUG)
 static uint32_t g_CollectCount = 0;
@@ -24,105 +22,2287 @@ static uint32_t g_CollectCount = 0;
 int64_t g_CollectCountBreak = -1;
 #endif
 
+#if !defined(IL2C_GC_DEFAULT_ALLOCATION_BUDGET)
+#define IL2C_GC_DEFAULT_ALLOCATION_BUDGET (1024U * 1024U)
+#endif
+#if !defined(IL2C_GC_DEFAULT_HEAP_GROWTH_PERCENT)
+#define IL2C_GC_DEFAULT_HEAP_GROWTH_PERCENT 100U
+#endif
+#if !defined(IL2C_GC_DEFAULT_MARK_STEP_WORK)
+#define IL2C_GC_DEFAULT_MARK_STEP_WORK 4096U
+#endif
+#if !defined(IL2C_GC_DEFAULT_TRIM_DELAY_MILLISECONDS)
+#define IL2C_GC_DEFAULT_TRIM_DELAY_MILLISECONDS 5000U
+#endif
+#if !defined(IL2C_GC_DEFAULT_TRIM_LIVE_PERCENT)
+#define IL2C_GC_DEFAULT_TRIM_LIVE_PERCENT 25U
+#endif
+
+// The configuration requested by il2c_configure_gc(), zero fields will be replaced by defaults.
+static IL2C_GC_CONFIGURATION g_RequestedGCConfiguration__ = { 0, 0, 0, 0, 0, 0, 0, 0 };
+static IL2C_GC_CONFIGURATION g_GCConfiguration__ = {
+    IL2C_GC_DEFAULT_ALLOCATION_BUDGET, IL2C_GC_DEFAULT_HEAP_GROWTH_PERCENT, 0, 1, IL2C_GC_DEFAULT_MARK_STEP_WORK, 0,
+    IL2C_GC_DEFAULT_TRIM_DELAY_MILLISECONDS, IL2C_GC_DEFAULT_TRIM_LIVE_PERCENT };
+
+// Allocation accounting since the last collection.
+static interlock_t g_AllocatedBytesSinceCollect__ = 0;
+static uintptr_t g_CollectionThreshold__ = IL2C_GC_DEFAULT_ALLOCATION_BUDGET;
+
+// Generations: The GC uses sticky mark bits, the instances surviving a collection stay marked (old generation)
+//   and the minor collection traces only the young (not marked) instances.
+//   The full collection unmarks all instances at first.
+static interlock_t g_FullCollectionRequested__ = 0;
+static uintptr_t g_OldGenerationBytes__ = 0;
+static uintptr_t g_FullCollectionThreshold__ = IL2C_GC_DEFAULT_ALLOCATION_BUDGET;
+
+// Lazy sweeping: The thresholds are updated when the heap finishes sweeping (il2c_notify_swept__.)
+static bool g_LastCollectionFull__ = false;
+
+// Statistics: The collecting thread (or the sweeper, the finalizer lock holder) updates without atomic operations,
+//   and il2c_get_gc_statistics() reads them without stopping the collection.
+static IL2C_GC_STATISTICS g_GCStatistics__;
+
+#if defined(IL2C_USE_MONOTONIC_CLOCK)
+#define il2c_get_pause_timestamp__() il2c_get_monotonic_microseconds__()
+#else
+#define il2c_get_pause_timestamp__() ((uint64_t)0)
+#endif
+
+#if !defined(IL2C_GC_REMEMBERED_SET_LIMIT)
+#define IL2C_GC_REMEMBERED_SET_LIMIT 65536U
+#endif
+
+// The remembered set: the old instances (or addresses) may contain references to young instances.
+typedef struct IL2C_REMEMBERED_SET_DECL
+{
+    void** ppEntries;
+    uintptr_t count;
+    uintptr_t capacity;
+} IL2C_REMEMBERED_SET;
+
+static IL2C_MONITOR_LOCK g_RememberedSetLock__;
+static IL2C_REMEMBERED_SET g_RememberedInstances__ = { NULL, 0, 0 };
+static IL2C_REMEMBERED_SET g_RememberedAddresses__ = { NULL, 0, 0 };
+
+// Parallel marking: The mark phase fans out to the GC worker threads when the platform supports.
+#if defined(IL2C_USE_SEMAPHORE) && !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+#define IL2C_USE_PARALLEL_MARK
+#endif
+
+// Background sweeping: The sweeper thread sweeps the heap blocks after the mutators resume.
+#if defined(IL2C_USE_SEMAPHORE) && !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+#define IL2C_USE_BACKGROUND_SWEEP
+#endif
+
+// Finalizer thread: The finalizers are called outside of the collection.
+#if defined(IL2C_USE_SEMAPHORE) && !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+#define IL2C_USE_FINALIZER_THREAD
+#endif
+
+#if !defined(IL2C_GC_MAX_MARK_THREADS)
+#define IL2C_GC_MAX_MARK_THREADS 64U
+#endif
+#if !defined(IL2C_GC_MARK_DEQUE_SIZE)
+#define IL2C_GC_MARK_DEQUE_SIZE 4096U     // Have to be power of 2
+#endif
+#if !defined(IL2C_GC_MARK_STACK_LIMIT)
+#define IL2C_GC_MARK_STACK_LIMIT (UINTPTR_MAX / sizeof(void*))
+#endif
+#if !defined(IL2C_GC_MARK_ARRAY_CHUNK)
+#define IL2C_GC_MARK_ARRAY_CHUNK 256U     // The serial marker traces the array elements by the chunks
+#endif
+#if !defined(IL2C_GC_PARALLEL_MARK_WORK)
+#define IL2C_GC_PARALLEL_MARK_WORK 256U   // Have to be less than the deque size
+#endif
+#if !defined(IL2C_GC_BACKGROUND_SWEEP_BLOCKS)
+#define IL2C_GC_BACKGROUND_SWEEP_BLOCKS 16U
+#endif
+
+// The instances waiting for calling the finalizer.
+//   The entries [head, count) are pending, and they are the GC roots until the finalizer is called.
+//   The finalizer thread calls them after the mutators resume if available,
+//   otherwise the collecting thread calls them at the end of the collection.
+static IL2C_MONITOR_LOCK g_FinalizerLock__;
+static System_Object** g_ppFinalizerQueue__ = NULL;
+static uintptr_t g_FinalizerQueueHead__ = 0;
+static uintptr_t g_FinalizerQueueCount__ = 0;
+static uintptr_t g_FinalizerQueueCapacity__ = 0;
+// The instance is calling the finalizer now.
+static System_Object* volatile g_pFinalizingReference__ = NULL;
+// The instances with the finalizer, registered at the allocation (or GC.ReRegisterForFinalize().)
+//   The collection finds the unreachable instances here instead of walking the heap, and drops them after reserved.
+//   It isn't the GC roots, guarded by g_FinalizerLock__.
+static System_Object** g_ppFinalizables__ = NULL;
+static uintptr_t g_FinalizableCount__ = 0;
+static uintptr_t g_FinalizableCapacity__ = 0;
+
+// Compaction: GC.Collect() moves the live instances out of the sparse blocks if IL2C_GC_FLAG_COMPACTION.
+//   Only the requesting thread compacts, because the allocating thread may hold the raw pointers.
+#if !defined(IL2C_GC_EVACUATION_LIVE_PERCENT)
+#define IL2C_GC_EVACUATION_LIVE_PERCENT 50U
+#endif
+static volatile int32_t g_CompactionRequestedThreadId__ = 0;
+// The custom mark handlers report the references for anchoring (not marking.)
+static volatile bool g_CompactionAnchoring__ = false;
+
+// Heap walking: The custom mark handlers report the references to the walker (not marking.)
+static const IL2C_HEAP_WALKER* volatile g_pHeapWalker__ = NULL;
+// The root kind reporting now, or IL2C_HEAP_ROOT_NONE if reporting the references from the instance.
+static uint8_t g_HeapWalkerRootKind__ = IL2C_HEAP_ROOT_NONE;
+
+// Incremental marking: The full collection traces the heap in the bounded increments at the allocations.
+//   The write barrier remembers the marked instances stored after tracing, they're traced again (incremental update.)
+//   The execution frames and the static fields don't have the write barrier, so every increment scans the roots,
+//   and the increment finished tracing continues the collection (reserving finalizers and sweeping.)
+#if !defined(IL2C_GC_MARK_STEP_BYTES)
+#define IL2C_GC_MARK_STEP_BYTES (64U * 1024U)
+#endif
+#if !defined(IL2C_GC_MARK_STEP_RESCAN_BLOCKS)
+#define IL2C_GC_MARK_STEP_RESCAN_BLOCKS 8U
+#endif
+static volatile bool g_IncrementalMarking__ = false;
+static uintptr_t g_IncrementalSavedThreshold__ = 0;
+// The remembered set overflowed while the incremental marking, all marked instances have to be traced again.
+//   The increments rescan IL2C_GC_MARK_STEP_RESCAN_BLOCKS blocks from the cursor.
+//   Overflowed again after began rescanning, the final increment rescans all (doesn't restart endlessly.)
+static interlock_t g_IncrementalRememberedSetOverflowed__ = 0;
+static bool g_IncrementalRescanning__ = false;
+static bool g_IncrementalRescanLost__ = false;
+static uintptr_t g_IncrementalRescanCursor__ = 0;
+
 typedef struct IL2C_MONITOR_LOCK_BLOCK_INFORMATION_DECL IL2C_MONITOR_LOCK_BLOCK_INFORMATION;
-extern void il2c_release_monitor_lock_from_objref__(IL2C_REF_HEADER* pHeader);
 extern void il2c_release_all_monitor_lock_for_final_shutdown__(void);
-extern void il2c_unregister_all_root_references_for_final_shutdown__(IL2C_ROOT_REFERENCES** ppRootReferences);
+extern void il2c_unregister_all_root_references_for_final_shutdown__(bool isFixed);
+
+/////////////////////////////////////////////////////////////
+// GC triggering policy
+
+#if defined(IL2C_USE_GETENV)
+uintptr_t il2c_get_environment_size__(const char* pName)
+{
+    const char* pValue = getenv(pName);
+    if (il2c_likely__(pValue == NULL))
+    {
+        return 0;
+    }
+
+    char* pUnit = NULL;
+    uintptr_t value = (uintptr_t)strtoul(pValue, &pUnit, 10);
+    switch (*pUnit)
+    {
+    case 'k': case 'K':
+        value *= 1024U;
+        break;
+    case 'm': case 'M':
+        value *= 1024U * 1024U;
+        break;
+    case 'g': case 'G':
+        value *= 1024U * 1024U * 1024U;
+        break;
+    }
+    return value;
+}
+#endif
+
+void il2c_configure_gc(const IL2C_GC_CONFIGURATION* pConfiguration)
+{
+    il2c_assert(pConfiguration != NULL);
+
+    g_RequestedGCConfiguration__ = *pConfiguration;
+    il2c_initialize_gc_configuration__();
+}
+
+void il2c_initialize_gc_configuration__(void)
+{
+    // Priority: il2c_configure_gc() --> environment variables --> defaults
+    IL2C_GC_CONFIGURATION configuration = g_RequestedGCConfiguration__;
+
+#if defined(IL2C_USE_GETENV)
+    if (configuration.allocationBudget == 0)
+    {
+        configuration.allocationBudget = il2c_get_environment_size__("IL2C_GC_ALLOCATION_BUDGET");
+    }
+    if (configuration.heapGrowthPercent == 0)
+    {
+        configuration.heapGrowthPercent = (uint32_t)il2c_get_environment_size__("IL2C_GC_HEAP_GROWTH");
+    }
+    if (il2c_get_environment_size__("IL2C_GC_STRESS") != 0)
+    {
+        configuration.flags |= IL2C_GC_FLAG_STRESS;
+    }
+    if (il2c_get_environment_size__("IL2C_GC_DISABLE_GENERATIONAL") != 0)
+    {
+        configuration.flags |= IL2C_GC_FLAG_DISABLE_GENERATIONAL;
+    }
+    if (il2c_get_environment_size__("IL2C_GC_BACKGROUND_SWEEP") != 0)
+    {
+        configuration.flags |= IL2C_GC_FLAG_BACKGROUND_SWEEP;
+    }
+    if (il2c_get_environment_size__("IL2C_GC_COMPACTION") != 0)
+    {
+        configuration.flags |= IL2C_GC_FLAG_COMPACTION;
+    }
+    if (il2c_get_environment_size__("IL2C_GC_INCREMENTAL") != 0)
+    {
+        configuration.flags |= IL2C_GC_FLAG_INCREMENTAL;
+    }
+    if (configuration.markThreads == 0)
+    {
+        configuration.markThreads = (uint32_t)il2c_get_environment_size__("IL2C_GC_MARK_THREADS");
+    }
+    if (configuration.markStepWork == 0)
+    {
+        configuration.markStepWork = (uint32_t)il2c_get_environment_size__("IL2C_GC_MARK_STEP_WORK");
+    }
+    if (configuration.markStepMicroseconds == 0)
+    {
+        configuration.markStepMicroseconds = (uint32_t)il2c_get_environment_size__("IL2C_GC_MARK_STEP_TIME");
+    }
+    if (il2c_get_environment_size__("IL2C_GC_DISABLE_TRIM") != 0)
+    {
+        configuration.flags |= IL2C_GC_FLAG_DISABLE_TRIM;
+    }
+    if (configuration.trimDelayMilliseconds == 0)
+    {
+        configuration.trimDelayMilliseconds = (uint32_t)il2c_get_environment_size__("IL2C_GC_TRIM_DELAY");
+    }
+    if (configuration.trimLivePercent == 0)
+    {
+        configuration.trimLivePercent = (uint32_t)il2c_get_environment_size__("IL2C_GC_TRIM_LIVE_PERCENT");
+    }
+#endif
+
+    if (configuration.allocationBudget == 0)
+    {
+        configuration.allocationBudget = IL2C_GC_DEFAULT_ALLOCATION_BUDGET;
+    }
+    if (configuration.heapGrowthPercent == 0)
+    {
+        configuration.heapGrowthPercent = IL2C_GC_DEFAULT_HEAP_GROWTH_PERCENT;
+    }
+    if (configuration.markStepWork == 0)
+    {
+        configuration.markStepWork = IL2C_GC_DEFAULT_MARK_STEP_WORK;
+    }
+    if (configuration.trimDelayMilliseconds == 0)
+    {
+        configuration.trimDelayMilliseconds = IL2C_GC_DEFAULT_TRIM_DELAY_MILLISECONDS;
+    }
+    if (configuration.trimLivePercent == 0)
+    {
+        configuration.trimLivePercent = IL2C_GC_DEFAULT_TRIM_LIVE_PERCENT;
+    }
+
+#if defined(IL2C_USE_PARALLEL_MARK)
+    if (configuration.markThreads == 0)
+    {
+        configuration.markThreads = il2c_get_processor_count__();
+    }
+    if (configuration.markThreads == 0)
+    {
+        configuration.markThreads = 1;
+    }
+    else if (configuration.markThreads > IL2C_GC_MAX_MARK_THREADS)
+    {
+        configuration.markThreads = IL2C_GC_MAX_MARK_THREADS;
+    }
+#else
+    // This platform doesn't have the threads for the marking.
+    configuration.markThreads = 1;
+#endif
+
+#if !defined(IL2C_USE_BACKGROUND_SWEEP)
+    // This platform doesn't have the thread for the sweeping, the allocator sweeps lazily.
+    configuration.flags &= ~IL2C_GC_FLAG_BACKGROUND_SWEEP;
+#endif
+#if !defined(IL2C_USE_MONOTONIC_CLOCK)
+    // This platform doesn't have the clock, the increment is limited by the work only,
+    // and the free blocks are trimmed at the next collection.
+    configuration.markStepMicroseconds = 0;
+    configuration.trimDelayMilliseconds = 0;
+#endif
+
+    // interlock_t may be 32bit width.
+    if (configuration.allocationBudget > (uintptr_t)LONG_MAX / 2)
+    {
+        configuration.allocationBudget = (uintptr_t)LONG_MAX / 2;
+    }
+
+    g_GCConfiguration__ = configuration;
+    g_CollectionThreshold__ = configuration.allocationBudget;
+    g_FullCollectionThreshold__ = configuration.allocationBudget;
+}
+
+// Accounts the allocation and returns true if the allocator should collect before allocating.
+bool il2c_consume_allocation_budget__(uintptr_t size)
+{
+    const interlock_t allocated = il2c_iadd(&g_AllocatedBytesSinceCollect__, size);
+
+    return il2c_unlikely__(
+        ((uintptr_t)allocated >= g_CollectionThreshold__) ||
+        (g_GCConfiguration__.flags & IL2C_GC_FLAG_STRESS));
+}
+
+void il2c_request_full_collection__(void)
+{
+    il2c_ixchg(&g_FullCollectionRequested__, 1);
+}
+
+void il2c_request_compaction__(void)
+{
+    if (g_GCConfiguration__.flags & IL2C_GC_FLAG_COMPACTION)
+    {
+        g_CompactionRequestedThreadId__ = il2c_get_current_thread_id__();
+    }
+}
+
+static bool il2c_is_compaction_requested__(void)
+{
+    if (il2c_likely__(g_CompactionRequestedThreadId__ == 0))
+    {
+        return false;
+    }
+
+    const bool requested = (g_CompactionRequestedThreadId__ == il2c_get_current_thread_id__());
+    if (requested)
+    {
+        g_CompactionRequestedThreadId__ = 0;
+    }
+    return requested;
+}
+
+static bool il2c_is_full_collection_requested__(void)
+{
+    return il2c_ixchg(&g_FullCollectionRequested__, 0) != 0;
+}
+
+static bool il2c_is_full_collection_required__(void)
+{
+    return
+        (g_GCConfiguration__.flags & IL2C_GC_FLAG_DISABLE_GENERATIONAL) ||
+        (g_OldGenerationBytes__ >= g_FullCollectionThreshold__);
+}
+
+static void il2c_update_collection_threshold__(uintptr_t liveBytes, bool full)
+{
+    // All surviving instances are promoted to the old generation.
+    g_OldGenerationBytes__ = liveBytes;
+
+    uintptr_t threshold = liveBytes / 100U * g_GCConfiguration__.heapGrowthPercent;
+    if (threshold < g_GCConfiguration__.allocationBudget)
+    {
+        threshold = g_GCConfiguration__.allocationBudget;
+    }
+    else if (threshold > (uintptr_t)LONG_MAX / 2)
+    {
+        threshold = (uintptr_t)LONG_MAX / 2;
+    }
+
+    if (il2c_unlikely__(g_GCConfiguration__.flags & IL2C_GC_FLAG_DISABLE_GENERATIONAL))
+    {
+        g_CollectionThreshold__ = threshold;
+    }
+    else
+    {
+        // The allocation budget is the young generation size,
+        // and the heap growth paces the full collection.
+        g_CollectionThreshold__ = g_GCConfiguration__.allocationBudget;
+        if (full)
+        {
+            g_FullCollectionThreshold__ = liveBytes + threshold;
+        }
+    }
+}
+
+// Called by the heap when the last unswept block is swept.
+void il2c_notify_swept__(uintptr_t liveBytes, uintptr_t liveObjects, uintptr_t freedBytes)
+{
+    il2c_update_collection_threshold__(liveBytes, g_LastCollectionFull__);
+
+    g_GCStatistics__.freedBytes += freedBytes;
+    g_GCStatistics__.liveBytes = liveBytes;
+    g_GCStatistics__.liveObjects = liveObjects;
+}
+
+/////////////////////////////////////////////////////////////
+// Statistics
+
+static void il2c_account_pause__(uint64_t beginTimestamp)
+{
+    const uint64_t pause = il2c_get_pause_timestamp__() - beginTimestamp;
+    g_GCStatistics__.totalPauseMicroseconds += pause;
+    if (pause > g_GCStatistics__.maxPauseMicroseconds)
+    {
+        g_GCStatistics__.maxPauseMicroseconds = pause;
+    }
+}
+
+void il2c_get_gc_statistics(IL2C_GC_STATISTICS* pStatistics)
+{
+    il2c_assert(pStatistics != NULL);
+
+    *pStatistics = g_GCStatistics__;
+
+    // The allocation since the last collection isn't accounted yet.
+    const uint64_t allocatedBytes = (uint64_t)(uintptr_t)g_AllocatedBytesSinceCollect__;
+    pStatistics->allocatedBytes += allocatedBytes;
+    pStatistics->heapBytes = pStatistics->liveBytes + allocatedBytes;
+
+    uintptr_t committedBytes;
+    uintptr_t usedBytes;
+    il2c_heap_get_committed_bytes__(&committedBytes, &usedBytes);
+    pStatistics->committedBytes = committedBytes;
+    pStatistics->usedBytes = usedBytes;
+}
+
+/////////////////////////////////////////////////////////////
+// Trimming
+
+// Returns the free heap blocks to the OS: the blocks unused for the delay,
+// or all free blocks at the full collection if the surviving bytes (at the last finished sweeping)
+// are sparse in the committed bytes. The minor collection doesn't, the surviving bytes aren't settled at starting up.
+// It has to be invoked from inside for GC process.
+static void il2c_trim_heap__(bool full)
+{
+    if (g_GCConfiguration__.flags & IL2C_GC_FLAG_DISABLE_TRIM)
+    {
+        return;
+    }
+
+    uintptr_t committedBytes;
+    uintptr_t usedBytes;
+    il2c_heap_get_committed_bytes__(&committedBytes, &usedBytes);
+    if (committedBytes == usedBytes)
+    {
+        return;
+    }
+
+    const bool sparse = full &&
+        g_GCStatistics__.liveBytes < (uint64_t)(committedBytes / 100U) * g_GCConfiguration__.trimLivePercent;
+    g_GCStatistics__.trimmedBytes += il2c_heap_trim__(
+        sparse ? 0 : g_GCConfiguration__.trimDelayMilliseconds);
+}
+
+/////////////////////////////////////////////////////////////
+// Write barriers and the remembered set
+
+void il2c_initialize_generations__(void)
+{
+    il2c_initialize_monitor_lock__(&g_RememberedSetLock__);
+
+    g_FullCollectionRequested__ = 0;
+    g_OldGenerationBytes__ = 0;
+    g_LastCollectionFull__ = false;
+
+    memset(&g_GCStatistics__, 0, sizeof g_GCStatistics__);
+}
+
+static void il2c_clear_remembered_set__(void)
+{
+    g_RememberedInstances__.count = 0;
+    g_RememberedAddresses__.count = 0;
+}
+
+// Clears the remembered flags before the full collection.
+//   The flag is set only while the instance is in the remembered set, so the GC doesn't scan all headers.
+static void il2c_forget_remembered_set__(void)
+{
+    uintptr_t index;
+    for (index = 0; index < g_RememberedInstances__.count; index++)
+    {
+        IL2C_REF_HEADER* pHeader = il2c_get_header__(g_RememberedInstances__.ppEntries[index]);
+        il2c_iand(&pHeader->characteristic, ~IL2C_CHARACTERISTIC_REMEMBERED);
+    }
+
+    il2c_clear_remembered_set__();
+}
+
+void il2c_shutdown_generations__(void)
+{
+    if (g_RememberedInstances__.ppEntries != NULL)
+    {
+        il2c_free(g_RememberedInstances__.ppEntries);
+    }
+    if (g_RememberedAddresses__.ppEntries != NULL)
+    {
+        il2c_free(g_RememberedAddresses__.ppEntries);
+    }
+    g_RememberedInstances__.ppEntries = NULL;
+    g_RememberedInstances__.capacity = 0;
+    g_RememberedAddresses__.ppEntries = NULL;
+    g_RememberedAddresses__.capacity = 0;
+    il2c_clear_remembered_set__();
+
+    il2c_destroy_monitor_lock__(&g_RememberedSetLock__);
+}
+
+// Returns false if the remembered set overflowed.
+static bool il2c_remember__(IL2C_REMEMBERED_SET* pRememberedSet, void* pEntry)
+{
+    il2c_enter_monitor_lock__(&g_RememberedSetLock__);
+
+    // Ignore continuous storing to the same place.
+    if (il2c_unlikely__((pRememberedSet->count >= 1) &&
+        (pRememberedSet->ppEntries[pRememberedSet->count - 1] == pEntry)))
+    {
+        il2c_exit_monitor_lock__(&g_RememberedSetLock__);
+        return true;
+    }
+
+    if (il2c_unlikely__(pRememberedSet->count >= pRememberedSet->capacity))
+    {
+        const uintptr_t capacity = (pRememberedSet->capacity >= 1) ? (pRememberedSet->capacity * 2) : 256;
+        void** ppEntries = NULL;
+        if (capacity <= IL2C_GC_REMEMBERED_SET_LIMIT)
+        {
+#if defined(IL2C_USE_LINE_INFORMATION)
+            ppEntries = il2c_malloc(capacity * sizeof(void*), __FILE__, __LINE__);
+#else
+            ppEntries = il2c_malloc(capacity * sizeof(void*));
+#endif
+        }
+
+        // Overflowed: The next collection has to trace all instances.
+        //   The incremental marking rescans them by the increments instead of abandoning the cycle.
+        if (il2c_unlikely__(ppEntries == NULL))
+        {
+            if (g_IncrementalMarking__)
+            {
+                il2c_ixchg(&g_IncrementalRememberedSetOverflowed__, 1);
+            }
+            else
+            {
+                il2c_request_full_collection__();
+            }
+            il2c_exit_monitor_lock__(&g_RememberedSetLock__);
+            return false;
+        }
+
+        if (pRememberedSet->ppEntries != NULL)
+        {
+            memcpy(ppEntries, pRememberedSet->ppEntries, pRememberedSet->count * sizeof(void*));
+            il2c_free(pRememberedSet->ppEntries);
+        }
+        pRememberedSet->ppEntries = ppEntries;
+        pRememberedSet->capacity = capacity;
+    }
+
+    pRememberedSet->ppEntries[pRememberedSet->count++] = pEntry;
+
+    il2c_exit_monitor_lock__(&g_RememberedSetLock__);
+    return true;
+}
+
+void il2c_write_barrier__(void* pReference)
+{
+    il2c_assert(pReference != NULL);
+
+    if (il2c_unlikely__((g_GCConfiguration__.flags & IL2C_GC_FLAG_DISABLE_GENERATIONAL) && !g_IncrementalMarking__))
+    {
+        return;
+    }
+
+    // The young instance will trace at the next collection,
+    // and the old instance is traced only once if it's already remembered.
+    // While the incremental marking, the marked instance is traced again by the next increment.
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(pReference);
+    const interlock_t characteristic = pHeader->characteristic;
+    if (il2c_likely__((characteristic & (IL2C_CHARACTERISTIC_REMEMBERED | IL2C_CHARACTERISTIC_CONST)) ||
+        !il2c_is_marked__(pHeader)))
+    {
+        return;
+    }
+
+    if (il2c_unlikely__(il2c_ior(&pHeader->characteristic, IL2C_CHARACTERISTIC_REMEMBERED) &
+        IL2C_CHARACTERISTIC_REMEMBERED))
+    {
+        return;
+    }
+
+    if (il2c_unlikely__(!il2c_remember__(&g_RememberedInstances__, pReference)))
+    {
+        il2c_iand(&pHeader->characteristic, ~IL2C_CHARACTERISTIC_REMEMBERED);
+    }
+}
+
+void il2c_write_barrier_for_address__(void* pAddress)
+{
+    il2c_assert(pAddress != NULL);
+
+    if (il2c_unlikely__((g_GCConfiguration__.flags & IL2C_GC_FLAG_DISABLE_GENERATIONAL) && !g_IncrementalMarking__))
+    {
+        return;
+    }
+
+    // The stack (execution frames) and static fields are always traced.
+    const uint8_t* p = (const uint8_t*)pAddress;
+    if (il2c_likely__((p < g_pHeapLowerBound__) || (p >= g_pHeapUpperBound__)))
+    {
+        return;
+    }
+
+    // The instance contains this address will find at the next collection.
+    il2c_remember__(&g_RememberedAddresses__, pAddress);
+}
+
+/////////////////////////////////////////////////////////////
+// Mark stack
+
+// The mark worker of the parallel marking, NULL is the serial marking (by g_MarkStack__.)
+//   The marker passes it down to the mark handlers instead of looking up the thread local storage.
+typedef struct IL2C_MARK_WORKER_DECL IL2C_MARK_WORKER;
+
+static void il2c_trace_objref__(
+    IL2C_MARK_WORKER* pWorker, IL2C_REF_HEADER* pHeader, System_Object* pAdjustedReference);
+static void il2c_trace_array__(IL2C_MARK_WORKER* pWorker, System_Array* arr, intptr_t begin);
+
+// The marked instances waiting for tracing. The marker traverses by this stack instead of the recursive call.
+typedef struct IL2C_MARK_STACK_DECL
+{
+    System_Object** ppEntries;
+    uintptr_t count;
+    uintptr_t capacity;
+} IL2C_MARK_STACK;
+
+// The mark stack for the serial marking, it's reused at the next collection.
+//   The large array continues by the pair of entries [array, (index << 1) | 1], the tagged index is on the top.
+static IL2C_MARK_STACK g_MarkStack__ = { NULL, 0, 0 };
+// The mark stack couldn't grow, the marked instances have to be traced again from the heap.
+static interlock_t g_MarkStackOverflowed__ = 0;
+
+#define il2c_is_mark_continuation__(pEntry) (((uintptr_t)(pEntry)) & 1U)
+
+static void il2c_mark_stack_push__(IL2C_MARK_STACK* pMarkStack, System_Object* pAdjustedReference)
+{
+    if (il2c_unlikely__(pMarkStack->count >= pMarkStack->capacity))
+    {
+        const uintptr_t capacity = (pMarkStack->capacity >= 1) ? (pMarkStack->capacity * 2) : 1024;
+        System_Object** ppEntries = NULL;
+        if (capacity <= IL2C_GC_MARK_STACK_LIMIT)
+        {
+#if defined(IL2C_USE_LINE_INFORMATION)
+            ppEntries = il2c_malloc(capacity * sizeof(System_Object*), __FILE__, __LINE__);
+#else
+            ppEntries = il2c_malloc(capacity * sizeof(System_Object*));
+#endif
+        }
+        // Overflowed: This instance is already marked, so it will be found at rescanning.
+        if (il2c_unlikely__(ppEntries == NULL))
+        {
+            il2c_ixchg(&g_MarkStackOverflowed__, 1);
+            return;
+        }
+
+        if (pMarkStack->ppEntries != NULL)
+        {
+            memcpy(ppEntries, pMarkStack->ppEntries, pMarkStack->count * sizeof(System_Object*));
+            il2c_free(pMarkStack->ppEntries);
+        }
+        pMarkStack->ppEntries = ppEntries;
+        pMarkStack->capacity = capacity;
+    }
+
+    pMarkStack->ppEntries[pMarkStack->count++] = pAdjustedReference;
+}
+
+static System_Object* il2c_mark_stack_pop__(IL2C_MARK_STACK* pMarkStack)
+{
+    if (il2c_unlikely__(pMarkStack->count == 0))
+    {
+        return NULL;
+    }
+
+    System_Object* pAdjustedReference = pMarkStack->ppEntries[--pMarkStack->count];
+
+    // The next entry will be traced soon if this instance doesn't have untraced fields.
+    if (il2c_likely__((pMarkStack->count >= 1) &&
+        !il2c_is_mark_continuation__(pMarkStack->ppEntries[pMarkStack->count - 1])))
+    {
+        il2c_prefetch(il2c_get_header__(pMarkStack->ppEntries[pMarkStack->count - 1]));
+    }
+
+    return pAdjustedReference;
+}
+
+static void il2c_trace_mark_entry__(IL2C_MARK_STACK* pMarkStack, System_Object* pEntry)
+{
+    // The array continuation traces the next chunk.
+    if (il2c_unlikely__(il2c_is_mark_continuation__(pEntry)))
+    {
+        il2c_assert(pMarkStack->count >= 1);
+        System_Array* arr = (System_Array*)pMarkStack->ppEntries[--pMarkStack->count];
+        il2c_trace_array__(NULL, arr, (intptr_t)((uintptr_t)pEntry >> 1));
+        return;
+    }
+
+    il2c_trace_objref__(NULL, il2c_get_header__(pEntry), pEntry);
+}
+
+static void il2c_drain_mark_stack__(IL2C_MARK_STACK* pMarkStack)
+{
+    System_Object* pEntry;
+    while ((pEntry = il2c_mark_stack_pop__(pMarkStack)) != NULL)
+    {
+        il2c_trace_mark_entry__(pMarkStack, pEntry);
+    }
+}
+
+// Traces until the work or the time (deadline, 0 is unlimited) is exhausted, returns true if the mark stack is empty.
+static bool il2c_drain_mark_stack_bounded__(IL2C_MARK_STACK* pMarkStack, uint32_t work, uint64_t deadline)
+{
+    uint32_t traced = 0;
+    System_Object* pEntry;
+    while ((pEntry = il2c_mark_stack_pop__(pMarkStack)) != NULL)
+    {
+        il2c_trace_mark_entry__(pMarkStack, pEntry);
+
+        traced++;
+        if (il2c_unlikely__(traced >= work))
+        {
+            break;
+        }
+#if defined(IL2C_USE_MONOTONIC_CLOCK)
+        // Reading the clock is expensive than tracing.
+        if (il2c_unlikely__((deadline != 0) && ((traced % 64U) == 0) &&
+            (il2c_get_monotonic_microseconds__() >= deadline)))
+        {
+            break;
+        }
+#else
+        ((void)deadline);
+#endif
+    }
+    return pMarkStack->count == 0;
+}
+
+static void il2c_release_mark_stack__(IL2C_MARK_STACK* pMarkStack)
+{
+    if (pMarkStack->ppEntries != NULL)
+    {
+        il2c_free(pMarkStack->ppEntries);
+    }
+    pMarkStack->ppEntries = NULL;
+    pMarkStack->count = 0;
+    pMarkStack->capacity = 0;
+}
+
+static void il2c_rescan_marked_instance__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    ((void)pContext);
+
+    il2c_trace_objref__(NULL, pHeader, (System_Object*)(pHeader + 1));
+    il2c_drain_mark_stack__(&g_MarkStack__);
+}
+
+// The incremental rescanning leaves the traced instances on the mark stack, the bounded increment drains them.
+static void il2c_retrace_marked_instance__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    ((void)pContext);
+
+    il2c_trace_objref__(NULL, pHeader, (System_Object*)(pHeader + 1));
+}
+
+/////////////////////////////////////////////////////////////
+// Parallel marking
+
+#if defined(IL2C_USE_PARALLEL_MARK)
+
+// The work-stealing deque (Chase-Lev) holds the marked instances waiting for tracing.
+//   The owner worker pushes and pops at the bottom, the other workers steal at the top.
+struct IL2C_MARK_WORKER_DECL
+{
+    interlock_t top;
+    interlock_t bottom;
+    intptr_t threadHandle;
+    // The entries couldn't push to the full deque, only the owner uses.
+    IL2C_MARK_STACK overflowStack;
+    System_Object* pEntries[IL2C_GC_MARK_DEQUE_SIZE];
+};
+
+static IL2C_TLS_INDEX g_MarkWorkerTlsIndex__;
+static IL2C_MARK_WORKER* g_pMarkWorkers__ = NULL;
+static uint32_t g_MarkWorkerCount__ = 0;
+static IL2C_SEMAPHORE g_MarkWorkerStartSemaphore__;
+static IL2C_SEMAPHORE g_MarkWorkerFinishedSemaphore__;
+static volatile bool g_MarkWorkerShutdown__ = false;
+
+// Seeding: The collecting thread distributes the roots to all deques before the workers begin.
+static volatile bool g_MarkSeeding__ = false;
+static uint32_t g_MarkSeedIndex__ = 0;
+static interlock_t g_ActiveMarkWorkers__ = 0;
+
+// The idle workers wait on it until the others push the entries to steal or the marking finishes.
+static IL2C_SEMAPHORE g_MarkWorkerIdleSemaphore__;
+static interlock_t g_IdleMarkWorkers__ = 0;
+static volatile bool g_MarkFinished__ = false;
+
+#define il2c_get_current_mark_worker__() ((IL2C_MARK_WORKER*)il2c_get_tls_value(g_MarkWorkerTlsIndex__))
+
+static bool il2c_mark_deque_push__(IL2C_MARK_WORKER* pWorker, System_Object* pAdjustedReference)
+{
+    const interlock_t bottom = pWorker->bottom;
+    if (il2c_unlikely__((uintptr_t)(bottom - pWorker->top) >= IL2C_GC_MARK_DEQUE_SIZE))
+    {
+        return false;
+    }
+
+    pWorker->pEntries[(uintptr_t)bottom & (IL2C_GC_MARK_DEQUE_SIZE - 1)] = pAdjustedReference;
+
+    // Publish the entry to the thieves.
+    il2c_iinc(&pWorker->bottom);
+    return true;
+}
+
+static System_Object* il2c_mark_deque_pop__(IL2C_MARK_WORKER* pWorker)
+{
+    const interlock_t bottom = il2c_idec(&pWorker->bottom);
+    const interlock_t top = pWorker->top;
+
+    // Empty.
+    if (il2c_likely__(bottom < top))
+    {
+        pWorker->bottom = top;
+        return NULL;
+    }
+
+    System_Object* pAdjustedReference = pWorker->pEntries[(uintptr_t)bottom & (IL2C_GC_MARK_DEQUE_SIZE - 1)];
+    if (il2c_likely__(bottom > top))
+    {
+        return pAdjustedReference;
+    }
+
+    // The last entry: Races with the thieves.
+    if (il2c_icmpxchg(&pWorker->top, top + 1, top) != top)
+    {
+        pAdjustedReference = NULL;
+    }
+    pWorker->bottom = top + 1;
+    return pAdjustedReference;
+}
+
+static System_Object* il2c_mark_deque_steal__(IL2C_MARK_WORKER* pWorker)
+{
+    const interlock_t top = pWorker->top;
+    il2c_memory_barrier();
+    const interlock_t bottom = pWorker->bottom;
+
+    if (il2c_likely__(top >= bottom))
+    {
+        return NULL;
+    }
+
+    System_Object* pAdjustedReference = pWorker->pEntries[(uintptr_t)top & (IL2C_GC_MARK_DEQUE_SIZE - 1)];
+    if (il2c_unlikely__(il2c_icmpxchg(&pWorker->top, top + 1, top) != top))
+    {
+        // Another worker got it.
+        return NULL;
+    }
+    return pAdjustedReference;
+}
+
+// Moves the entries from the overflow stack to the empty deque, the other workers can steal them.
+static void il2c_refill_mark_deque__(IL2C_MARK_WORKER* pWorker)
+{
+    uint32_t index;
+    for (index = 0; index < IL2C_GC_MARK_DEQUE_SIZE / 2; index++)
+    {
+        System_Object* pAdjustedReference = il2c_mark_stack_pop__(&pWorker->overflowStack);
+        if (pAdjustedReference == NULL)
+        {
+            break;
+        }
+        il2c_mark_deque_push__(pWorker, pAdjustedReference);
+    }
+}
+
+static System_Object* il2c_mark_steal_from_others__(IL2C_MARK_WORKER* pWorker)
+{
+    const uint32_t self = (uint32_t)(pWorker - g_pMarkWorkers__);
+    uint32_t index;
+    for (index = 1; index < g_MarkWorkerCount__; index++)
+    {
+        System_Object* pAdjustedReference =
+            il2c_mark_deque_steal__(&g_pMarkWorkers__[(self + index) % g_MarkWorkerCount__]);
+        if (pAdjustedReference != NULL)
+        {
+            return pAdjustedReference;
+        }
+    }
+    return NULL;
+}
+
+// Wakes an idle worker up if this deque has the entries to steal. The caller has to be active.
+static void il2c_wake_idle_mark_worker__(IL2C_MARK_WORKER* pWorker)
+{
+    const interlock_t idle = g_IdleMarkWorkers__;
+    if (il2c_likely__((idle == 0) || ((pWorker->bottom - pWorker->top) < 2)))
+    {
+        return;
+    }
+
+    if (il2c_icmpxchg(&g_IdleMarkWorkers__, idle - 1, idle) == idle)
+    {
+        // Count it as active on behalf of, so the marking doesn't finish before it steals.
+        il2c_iinc(&g_ActiveMarkWorkers__);
+        il2c_release_semaphore__(&g_MarkWorkerIdleSemaphore__);
+    }
+}
+
+static System_Object* il2c_take_mark_entry__(IL2C_MARK_WORKER* pWorker)
+{
+    // The thieves may take all refilled entries before popping.
+    System_Object* pAdjustedReference;
+    while (il2c_unlikely__(((pAdjustedReference = il2c_mark_deque_pop__(pWorker)) == NULL) &&
+        (pWorker->overflowStack.count >= 1)))
+    {
+        il2c_refill_mark_deque__(pWorker);
+        il2c_wake_idle_mark_worker__(pWorker);
+    }
+    if (il2c_unlikely__(pAdjustedReference == NULL))
+    {
+        pAdjustedReference = il2c_mark_steal_from_others__(pWorker);
+    }
+    return pAdjustedReference;
+}
+
+// Traces the instances until all deques are empty.
+static void il2c_drain_mark_worker__(IL2C_MARK_WORKER* pWorker)
+{
+    while (1)
+    {
+        System_Object* pAdjustedReference = il2c_take_mark_entry__(pWorker);
+        if (il2c_likely__(pAdjustedReference != NULL))
+        {
+            il2c_trace_objref__(pWorker, il2c_get_header__(pAdjustedReference), pAdjustedReference);
+            continue;
+        }
+
+        // Idle: Only the active worker can push the entries, so the marking finishes when all workers are idle.
+        //   It's counted as idle before inactive, so the last worker can wake all idle workers up.
+        il2c_iinc(&g_IdleMarkWorkers__);
+        if (il2c_idec(&g_ActiveMarkWorkers__) == 0)
+        {
+            g_MarkFinished__ = true;
+            const interlock_t idle = il2c_ixchg(&g_IdleMarkWorkers__, 0) - 1;
+            interlock_t index;
+            for (index = 0; index < idle; index++)
+            {
+                il2c_release_semaphore__(&g_MarkWorkerIdleSemaphore__);
+            }
+            return;
+        }
+
+        // Blocks until an active worker pushes the entries (and counts this as active) or the marking finishes.
+        il2c_wait_semaphore__(&g_MarkWorkerIdleSemaphore__);
+        if (g_MarkFinished__)
+        {
+            return;
+        }
+    }
+}
+
+// Traces by the collecting thread alone while the marked instances are few (waking the workers up costs more.)
+//   Returns true if the marking finished.
+static bool il2c_drain_mark_worker_alone__(IL2C_MARK_WORKER* pWorker)
+{
+    // The seeded entries are distributed to all deques.
+    uintptr_t work = 0;
+    uint32_t index;
+    for (index = 0; index < g_MarkWorkerCount__; index++)
+    {
+        work += (uintptr_t)(g_pMarkWorkers__[index].bottom - g_pMarkWorkers__[index].top) +
+            g_pMarkWorkers__[index].overflowStack.count;
+    }
+
+    while (work < IL2C_GC_PARALLEL_MARK_WORK)
+    {
+        System_Object* pAdjustedReference = il2c_take_mark_entry__(pWorker);
+        if (pAdjustedReference == NULL)
+        {
+            return true;
+        }
+
+        il2c_trace_objref__(pWorker, il2c_get_header__(pAdjustedReference), pAdjustedReference);
+
+        // The others' deques are only decreased.
+        work = (uintptr_t)(pWorker->bottom - pWorker->top) + pWorker->overflowStack.count;
+    }
+    return false;
+}
+
+static IL2C_THREAD_ENTRY_POINT_RESULT_TYPE il2c_mark_worker_entry_point__(
+    IL2C_THREAD_ENTRY_POINT_PARAMETER_TYPE parameter)
+{
+    IL2C_MARK_WORKER* pWorker = (IL2C_MARK_WORKER*)parameter;
+    il2c_set_tls_value(g_MarkWorkerTlsIndex__, pWorker);
+
+    while (1)
+    {
+        il2c_wait_semaphore__(&g_MarkWorkerStartSemaphore__);
+        if (il2c_unlikely__(g_MarkWorkerShutdown__))
+        {
+            break;
+        }
+
+        il2c_drain_mark_worker__(pWorker);
+
+        il2c_release_semaphore__(&g_MarkWorkerFinishedSemaphore__);
+    }
+
+    IL2C_THREAD_ENTRY_POINT_RETURN(0);
+}
+
+// Traces the seeded entries by all workers, the collecting thread is the worker 0.
+//   The workers are woken up only if the roots and the remembered set (or the tracing) give enough work.
+static void il2c_finish_parallel_mark__(IL2C_MARK_WORKER* pWorker)
+{
+    g_MarkSeeding__ = false;
+
+    if (!il2c_drain_mark_worker_alone__(pWorker))
+    {
+        g_ActiveMarkWorkers__ = (interlock_t)g_MarkWorkerCount__;
+        g_IdleMarkWorkers__ = 0;
+        g_MarkFinished__ = false;
+
+        uint32_t index;
+        for (index = 1; index < g_MarkWorkerCount__; index++)
+        {
+            il2c_release_semaphore__(&g_MarkWorkerStartSemaphore__);
+        }
+
+        il2c_drain_mark_worker__(pWorker);
+
+        for (index = 1; index < g_MarkWorkerCount__; index++)
+        {
+            il2c_wait_semaphore__(&g_MarkWorkerFinishedSemaphore__);
+        }
+    }
+
+    il2c_set_tls_value(g_MarkWorkerTlsIndex__, NULL);
+}
+
+static void il2c_start_mark_workers__(void)
+{
+    const uint32_t count = g_GCConfiguration__.markThreads;
+
+#if defined(IL2C_USE_LINE_INFORMATION)
+    g_pMarkWorkers__ = il2c_malloc(count * sizeof(IL2C_MARK_WORKER), __FILE__, __LINE__);
+#else
+    g_pMarkWorkers__ = il2c_malloc(count * sizeof(IL2C_MARK_WORKER));
+#endif
+    // Continue the serial marking.
+    if (il2c_unlikely__(g_pMarkWorkers__ == NULL))
+    {
+        return;
+    }
+    memset(g_pMarkWorkers__, 0, count * sizeof(IL2C_MARK_WORKER));
+
+    il2c_initialize_semaphore__(&g_MarkWorkerStartSemaphore__);
+    il2c_initialize_semaphore__(&g_MarkWorkerFinishedSemaphore__);
+    il2c_initialize_semaphore__(&g_MarkWorkerIdleSemaphore__);
+    g_MarkWorkerShutdown__ = false;
+
+    // The worker 0 is the collecting thread.
+    g_MarkWorkerCount__ = 1;
+    while (g_MarkWorkerCount__ < count)
+    {
+        IL2C_MARK_WORKER* pWorker = &g_pMarkWorkers__[g_MarkWorkerCount__];
+        pWorker->threadHandle = il2c_create_thread__(il2c_mark_worker_entry_point__, pWorker);
+        if (il2c_unlikely__((pWorker->threadHandle == 0) || (pWorker->threadHandle == -1)))
+        {
+            break;
+        }
+        il2c_resume_thread__(pWorker->threadHandle);
+        g_MarkWorkerCount__++;
+    }
+}
+
+void il2c_initialize_mark_workers__(void)
+{
+    g_MarkWorkerTlsIndex__ = il2c_tls_alloc();
+    g_pMarkWorkers__ = NULL;
+    g_MarkWorkerCount__ = 0;
+}
+
+void il2c_shutdown_mark_workers__(void)
+{
+    il2c_release_mark_stack__(&g_MarkStack__);
+
+    if (g_pMarkWorkers__ != NULL)
+    {
+        g_MarkWorkerShutdown__ = true;
+
+        uint32_t index;
+        for (index = 1; index < g_MarkWorkerCount__; index++)
+        {
+            il2c_release_semaphore__(&g_MarkWorkerStartSemaphore__);
+        }
+        for (index = 1; index < g_MarkWorkerCount__; index++)
+        {
+            il2c_join_thread__(g_pMarkWorkers__[index].threadHandle);
+            il2c_close_thread_handle__(g_pMarkWorkers__[index].threadHandle);
+        }
+        for (index = 0; index < g_MarkWorkerCount__; index++)
+        {
+            il2c_release_mark_stack__(&g_pMarkWorkers__[index].overflowStack);
+        }
+
+        il2c_destroy_semaphore__(&g_MarkWorkerStartSemaphore__);
+        il2c_destroy_semaphore__(&g_MarkWorkerFinishedSemaphore__);
+        il2c_destroy_semaphore__(&g_MarkWorkerIdleSemaphore__);
+
+        il2c_free(g_pMarkWorkers__);
+        g_pMarkWorkers__ = NULL;
+        g_MarkWorkerCount__ = 0;
+    }
+
+    il2c_tls_free(g_MarkWorkerTlsIndex__);
+}
+#else
+void il2c_initialize_mark_workers__(void)
+{
+}
+
+void il2c_shutdown_mark_workers__(void)
+{
+    il2c_release_mark_stack__(&g_MarkStack__);
+}
+
+#define il2c_get_current_mark_worker__() ((IL2C_MARK_WORKER*)NULL)
+#endif
+
+/////////////////////////////////////////////////////////////
+// Background sweeping
+
+#if defined(IL2C_USE_BACKGROUND_SWEEP)
+
+static intptr_t g_SweeperThreadHandle__ = 0;
+static IL2C_SEMAPHORE g_SweeperSemaphore__;
+static volatile bool g_SweeperShutdown__ = false;
+
+static IL2C_THREAD_ENTRY_POINT_RESULT_TYPE il2c_sweeper_entry_point__(
+    IL2C_THREAD_ENTRY_POINT_PARAMETER_TYPE parameter)
+{
+    ((void)parameter);
+
+    while (1)
+    {
+        il2c_wait_semaphore__(&g_SweeperSemaphore__);
+        if (il2c_unlikely__(g_SweeperShutdown__))
+        {
+            break;
+        }
+
+        // Sweep by the small chunks, because the allocator may wait for the size class lock.
+        while (!g_SweeperShutdown__ && il2c_heap_sweep_pending__(IL2C_GC_BACKGROUND_SWEEP_BLOCKS));
+    }
+
+    IL2C_THREAD_ENTRY_POINT_RETURN(0);
+}
+
+void il2c_initialize_sweeper__(void)
+{
+    g_SweeperThreadHandle__ = 0;
+    g_SweeperShutdown__ = false;
+
+    if (!(g_GCConfiguration__.flags & IL2C_GC_FLAG_BACKGROUND_SWEEP))
+    {
+        return;
+    }
+
+    il2c_initialize_semaphore__(&g_SweeperSemaphore__);
+
+    const intptr_t threadHandle = il2c_create_thread__(il2c_sweeper_entry_point__, NULL);
+    // Continue the lazy sweeping by the allocator.
+    if (il2c_unlikely__((threadHandle == 0) || (threadHandle == -1)))
+    {
+        il2c_destroy_semaphore__(&g_SweeperSemaphore__);
+        return;
+    }
+
+    g_SweeperThreadHandle__ = threadHandle;
+    il2c_resume_thread__(threadHandle);
+}
+
+void il2c_shutdown_sweeper__(void)
+{
+    if (g_SweeperThreadHandle__ != 0)
+    {
+        g_SweeperShutdown__ = true;
+        il2c_release_semaphore__(&g_SweeperSemaphore__);
+
+        il2c_join_thread__(g_SweeperThreadHandle__);
+        il2c_close_thread_handle__(g_SweeperThreadHandle__);
+        il2c_destroy_semaphore__(&g_SweeperSemaphore__);
+
+        g_SweeperThreadHandle__ = 0;
+    }
+}
+
+static bool il2c_is_background_sweeping__(void)
+{
+    return g_SweeperThreadHandle__ != 0;
+}
+
+// Wakes the sweeper up, it has to be invoked after the mutators resume.
+static void il2c_wake_sweeper__(void)
+{
+    if (g_SweeperThreadHandle__ != 0)
+    {
+        il2c_release_semaphore__(&g_SweeperSemaphore__);
+    }
+}
+#else
+void il2c_initialize_sweeper__(void)
+{
+}
+
+void il2c_shutdown_sweeper__(void)
+{
+}
+
+#define il2c_is_background_sweeping__() (false)
+#define il2c_wake_sweeper__() ((void)0)
+#endif
+
+// Begins the marking, the marked instances are traced at il2c_finish_mark__().
+//   Returns the mark worker of the collecting thread, or NULL if it's the serial marking.
+//   Whether the workers wake up is decided by the marked instances at il2c_finish_mark__(),
+//   so the minor collection with the large remembered set is traced in parallel too.
+static IL2C_MARK_WORKER* il2c_begin_mark__(void)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+#if defined(IL2C_USE_PARALLEL_MARK)
+    if (g_GCConfiguration__.markThreads <= 1)
+    {
+        return NULL;
+    }
+
+    if (il2c_unlikely__(g_pMarkWorkers__ == NULL))
+    {
+        il2c_start_mark_workers__();
+    }
+    // Couldn't create the workers.
+    if (il2c_unlikely__(g_MarkWorkerCount__ <= 1))
+    {
+        return NULL;
+    }
+
+    uint32_t index;
+    for (index = 0; index < g_MarkWorkerCount__; index++)
+    {
+        g_pMarkWorkers__[index].top = 0;
+        g_pMarkWorkers__[index].bottom = 0;
+    }
+
+    g_MarkSeeding__ = true;
+    g_MarkSeedIndex__ = 0;
+
+    // The custom mark handlers reach the worker by the thread local storage.
+    il2c_set_tls_value(g_MarkWorkerTlsIndex__, &g_pMarkWorkers__[0]);
+    return &g_pMarkWorkers__[0];
+#else
+    return NULL;
+#endif
+}
+
+// Pushes the marked instance for tracing at il2c_finish_mark__().
+static void il2c_push_mark__(IL2C_MARK_WORKER* pWorker, System_Object* pAdjustedReference)
+{
+#if defined(IL2C_USE_PARALLEL_MARK)
+    if (il2c_likely__(pWorker != NULL))
+    {
+        // The workers aren't running yet, so can push to any deque.
+        if (il2c_unlikely__(g_MarkSeeding__))
+        {
+            pWorker = &g_pMarkWorkers__[g_MarkSeedIndex__++ % g_MarkWorkerCount__];
+        }
+
+        if (il2c_unlikely__(!il2c_mark_deque_push__(pWorker, pAdjustedReference)))
+        {
+            il2c_mark_stack_push__(&pWorker->overflowStack, pAdjustedReference);
+            return;
+        }
+
+        il2c_wake_idle_mark_worker__(pWorker);
+        return;
+    }
+#else
+    ((void)pWorker);
+#endif
+
+    il2c_mark_stack_push__(&g_MarkStack__, pAdjustedReference);
+}
+
+static void il2c_finish_mark__(IL2C_MARK_WORKER* pWorker)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+#if defined(IL2C_USE_PARALLEL_MARK)
+    if (pWorker != NULL)
+    {
+        il2c_finish_parallel_mark__(pWorker);
+    }
+#else
+    ((void)pWorker);
+#endif
+
+    // Serial marking.
+    il2c_drain_mark_stack__(&g_MarkStack__);
+
+    // The marked instances may not be traced if the mark stack overflowed.
+    //   Tracing the traced instance again is harmless.
+    while (il2c_unlikely__(il2c_ixchg(&g_MarkStackOverflowed__, 0) != 0))
+    {
+        il2c_heap_enumerate_marked__(il2c_rescan_marked_instance__, NULL);
+    }
+}
+
+/////////////////////////////////////////////////////////////
+// Internal GC mark handlers
+
+// Has to ignore if objref is const.  (NOT const and NOT marked)
+// HACK: The const instance isn't placed at the heap, so il2c_is_marked__() tests the const flag before the mark bitmap.
+#define TRY_GET_HEADER(pHeader, pAdjustedReference) \
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(pAdjustedReference); \
+    if (il2c_unlikely__(!il2c_is_marked__(pHeader)))
+
+static void il2c_mark_handler_recursive__(
+    IL2C_MARK_WORKER* pWorker, void* pTarget, IL2C_RUNTIME_TYPE type, const uint8_t offset);
+
+static void il2c_mark_handler_for_objref__(IL2C_MARK_WORKER* pWorker, System_Object* pAdjustedReference)
+{
+    il2c_assert(pAdjustedReference != NULL);
+
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(pAdjustedReference);
+    il2c_assert(pHeader->type != NULL);
+    
+    // Marking with atomicity, it has to be idempotent because the mark workers may race on the same instance.
+    // The mark bit is set at the side table, so the instance header isn't written.
+    const interlock_t markBit = il2c_heap_mark_bit__(pHeader);
+    const interlock_t lastMarkWord = il2c_ior(il2c_heap_mark_word__(pHeader), markBit);
+    if (il2c_likely__(lastMarkWord & markBit))
+    {
+        il2c_runtime_debug_log_format(
+            L"il2c_mark_handler_for_objref__ [1]: pAdjustedReference=0x{0:p}, type={1:s}, characteristic=0x{2:x}",
+            pAdjustedReference,
+            pHeader->type->pTypeName,
+            pHeader->characteristic);
+        // Already marked/fixed/constant
+        return;
+    }
+
+    // The pointer-free instance is finished by only marking (doesn't scan the body.)
+    if (il2c_unlikely__(pHeader->characteristic & IL2C_CHARACTERISTIC_POINTER_FREE))
+    {
+        return;
+    }
+
+    il2c_push_mark__(pWorker, pAdjustedReference);
+}
+
+static void il2c_mark_handler_for_value_type__(IL2C_MARK_WORKER* pWorker, void* pValue, IL2C_RUNTIME_TYPE valueType);
+
+// Traverses the array elements from the index (same as System_Array_MarkHandler__, but passes the worker down.)
+// The serial marker traces IL2C_GC_MARK_ARRAY_CHUNK elements and pushes the continuation,
+// so the large array doesn't exceed the bounded increment.
+static void il2c_trace_array__(IL2C_MARK_WORKER* pWorker, System_Array* arr, intptr_t begin)
+{
+    // The pointer-free value type elements don't have any objrefs.
+    IL2C_RUNTIME_TYPE elementType = arr->elementType__;
+    if ((elementType->flags & (IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE)) == (IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE))
+    {
+        return;
+    }
+
+    intptr_t end = arr->Length;
+    if ((pWorker == NULL) && ((end - begin) > (intptr_t)IL2C_GC_MARK_ARRAY_CHUNK))
+    {
+        end = begin + (intptr_t)IL2C_GC_MARK_ARRAY_CHUNK;
+
+        // Overflowed: The array alone is traced from the first element, or found at rescanning.
+        const uintptr_t count = g_MarkStack__.count;
+        il2c_mark_stack_push__(&g_MarkStack__, (System_Object*)arr);
+        if (il2c_likely__(g_MarkStack__.count != count))
+        {
+            il2c_mark_stack_push__(&g_MarkStack__, (System_Object*)((((uintptr_t)end) << 1) | 1U));
+        }
+    }
+
+    intptr_t index;
+    if (elementType->flags & IL2C_TYPE_VALUE)
+    {
+        for (index = begin; il2c_likely__(index < end); index++)
+        {
+            void* pValue = il2c_array_itemptr__(arr, (uint32_t)(elementType->bodySize), index);
+            il2c_mark_handler_for_value_type__(pWorker, pValue, elementType);
+        }
+    }
+    else
+    {
+        for (index = begin; il2c_likely__(index < end); index++)
+        {
+            void* pReference = il2c_array_item(arr, void*, index);
+            if (pReference == NULL)
+            {
+                continue;
+            }
+
+            System_Object* pAdjustedReference = il2c_adjusted_reference(pReference);
+            TRY_GET_HEADER(pHeader, pAdjustedReference)
+            {
+                il2c_mark_handler_for_objref__(pWorker, pAdjustedReference);
+            }
+        }
+    }
+}
+
+// Traverses the fields, doesn't care the instance is marked.
+static void il2c_trace_objref__(
+    IL2C_MARK_WORKER* pWorker, IL2C_REF_HEADER* pHeader, System_Object* pAdjustedReference)
+{
+    typedef void (*IL2C_MARK_HANDLER)(void* pReference);
+
+    // The pointer-free instance doesn't have any objrefs.
+    if (il2c_unlikely__(pHeader->characteristic & IL2C_CHARACTERISTIC_POINTER_FREE))
+    {
+        return;
+    }
+
+    // The array is traced here, the custom mark handler can't receive the worker.
+    if (pHeader->type == il2c_typeof(System_Array))
+    {
+        il2c_trace_array__(pWorker, (System_Array*)pAdjustedReference, 0);
+        return;
+    }
+
+    // This type has the custom mark handler.
+    // Because it's variable type, can't fix pointer offsets.
+    if (il2c_unlikely__((pHeader->type->flags & IL2C_TYPE_WITH_MARK_HANDLER) == IL2C_TYPE_WITH_MARK_HANDLER))
+    {
+        IL2C_MARK_HANDLER pMarkHandler = (IL2C_MARK_HANDLER)(pHeader->type->markTarget);
+        il2c_assert(pMarkHandler != NULL);
+
+        il2c_runtime_debug_log_format(
+            L"il2c_trace_objref__ [1]: pAdjustedReference=0x{0:p}, type={1:s}, pMarkHandler=0x{2:p}",
+            pAdjustedReference,
+            pHeader->type->pTypeName,
+            pMarkHandler);
+
+        // Invoke custom mark handler
+        pMarkHandler(pAdjustedReference);
+    }
+    // This type doesn't have the custom mark handler, traverser works just now.
+    else
+    {
+        // NOTE: If this type is (boxed) value type,
+        //   we have to shift additional offset for System_ValueType (maybe only vptr0).
+        const uint8_t offset = (pHeader->type->flags & IL2C_TYPE_VALUE) ?
+            sizeof(System_ValueType) :
+            0;
+
+        il2c_runtime_debug_log_format(
+            L"il2c_trace_objref__ [2]: pAdjustedReference=0x{0:p}, type={1:s}, offset={2:u}",
+            pAdjustedReference,
+            pHeader->type->pTypeName,
+            offset);
+
+        // Traverse recursively.
+        il2c_mark_handler_recursive__(pWorker, pAdjustedReference, pHeader->type, offset);
+    }
+}
+
+static void il2c_mark_handler_for_value_type__(IL2C_MARK_WORKER* pWorker, void* pValue, IL2C_RUNTIME_TYPE valueType)
+{
+    il2c_assert(pValue != NULL);
+    il2c_assert(valueType != NULL);
+    il2c_assert((valueType->flags & IL2C_TYPE_VALUE) == IL2C_TYPE_VALUE);
+
+    il2c_runtime_debug_log_format(
+        L"il2c_mark_handler_for_value_type__: pValue=0x{0:p}, type={1:s}",
+        pValue,
+        valueType->pTypeName);
+
+    // Traverse recursively.
+    il2c_mark_handler_recursive__(pWorker, pValue, valueType, 0);
+}
+
+static void il2c_mark_handler_recursive__(
+    IL2C_MARK_WORKER* pWorker, void* pTarget, IL2C_RUNTIME_TYPE type, const uint8_t offset)
+{
+    il2c_assert(pTarget != NULL);
+    il2c_assert(type != NULL);
+
+    // Traverse type fields recursivity.
+    IL2C_MARK_TARGET* pMarkTarget = (IL2C_MARK_TARGET*)(type + 1);
+    uintptr_t index;
+    for (index = 0;
+        il2c_likely__(index < type->markTarget);
+        index++, pMarkTarget++)
+    {
+        void* pTargetField = (void*)(((uint8_t*)pTarget) + pMarkTarget->offset + offset);
+
+        // Is this entry value type?
+        // The translator flattens the objrefs inside the value type fields,
+        // only the hand-written runtime types may have the value type entries.
+        if (il2c_unlikely__(pMarkTarget->valueType != NULL))
+        {
+            il2c_assert((pMarkTarget->valueType->flags & IL2C_TYPE_VALUE) == IL2C_TYPE_VALUE);
+            il2c_assert(pTargetField != NULL);
+
+            il2c_runtime_debug_log_format(
+                L"il2c_mark_handler_recursive__ [1]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pTargetField=0x{3:p}, fieldType={4:s}",
+                pTarget,
+                type->pTypeName,
+                index,
+                pTargetField,
+                pMarkTarget->valueType->pTypeName);
+
+            // Mark for this value.
+            il2c_mark_handler_for_value_type__(pWorker, pTargetField, pMarkTarget->valueType);
+
+            continue;
+        }
+
+        // This field isn't assigned.
+        void* pReference = *(void**)pTargetField;
+        if (il2c_unlikely__(pReference == NULL))
+        {
+            il2c_runtime_debug_log_format(
+                L"il2c_mark_handler_recursive__ [2]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pReference=NULL",
+                pTarget,
+                type->pTypeName,
+                index,
+                pReference);
+
+            continue;
+        }
+
+        System_Object* pAdjustedReferenceInner = il2c_adjusted_reference(pReference);
+        TRY_GET_HEADER(pHeaderInner, pAdjustedReferenceInner)
+        {
+            il2c_runtime_debug_log_format(
+                L"il2c_mark_handler_recursive__ [3]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pAdjustedReferenceInner=0x{3:x}, targetType={4:s}, characteristic=0x{5:x}",
+                pTarget,
+                type->pTypeName,
+                index,
+                pAdjustedReferenceInner,
+                pHeaderInner->type->pTypeName,
+                pHeaderInner->characteristic);
+
+            // Use mark offset from type information.
+            il2c_mark_handler_for_objref__(pWorker, pAdjustedReferenceInner);
+        }
+        else
+        {
+            il2c_runtime_debug_log_format(
+                L"il2c_mark_handler_recursive__ [4]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pAdjustedReferenceInner=0x{3:p}, targetType={4:s}, characteristic=0x{5:x}",
+                pTarget,
+                type->pTypeName,
+                index,
+                pAdjustedReferenceInner,
+                pHeaderInner->type->pTypeName,
+                pHeaderInner->characteristic);
+        }
+    }
+}
+
+// Marks the objref (may be the interface reference.)
+static void il2c_mark_reference__(IL2C_MARK_WORKER* pWorker, void* pReference)
+{
+    System_Object * pAdjustedReference = il2c_adjusted_reference(pReference);
+    TRY_GET_HEADER(pHeader, pAdjustedReference)
+    {
+        il2c_runtime_debug_log_format(
+            L"il2c_mark_reference__ [1]: pReference=0x{0:p}, pAdjustedReference=0x{1:p}, type={2:s}, characteristic=0x{3:x}",
+            pReference,
+            pAdjustedReference,
+            pHeader->type->pTypeName,
+            pHeader->characteristic);
+
+        // Traverse recursively.
+        il2c_mark_handler_for_objref__(pWorker, pAdjustedReference);
+    }
+    else
+    {
+        il2c_runtime_debug_log_format(
+            L"il2c_mark_reference__ [2]: pReference=0x{0:p}, pAdjustedReference=0x{1:p}, type={2:s}, characteristic=0x{3:x}",
+            pReference,
+            pAdjustedReference,
+            pHeader->type->pTypeName,
+            pHeader->characteristic);
+    }
+}
+
+/////////////////////////////////////////////////////////////
+// GC processes
+
+static void il2c_step2_mark_gcmark__(IL2C_MARK_WORKER* pWorker, IL2C_GC_TRACKING_INFORMATION* pBeginFrame)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    // Mark headers.
+    IL2C_GC_TRACKING_INFORMATION* pCurrentFrame = pBeginFrame;
+    while (il2c_likely__(pCurrentFrame != NULL))
+    {
+        // Traverse objrefs at the current frame.
+        uint16_t index;
+        void** ppReference = (void**)&pCurrentFrame->pReferences__[0];
+        for (index = 0; il2c_likely__(index < pCurrentFrame->objRefCount__); index++, ppReference++)
+        {
+            // This variable isn't assigned.
+            if (il2c_unlikely__(*ppReference == NULL))
+            {
+                il2c_runtime_debug_log_format(
+                    L"il2c_step2_mark_gcmark__ [2]: pCurrentFrame=0x{0:p}, index={1:u}, *ppReference=NULL",
+                    pCurrentFrame,
+                    index);
+                continue;
+            }
+
+            System_Object* pAdjustedReference = il2c_adjusted_reference(*ppReference);
+            TRY_GET_HEADER(pHeader, pAdjustedReference)
+            {
+                il2c_runtime_debug_log_format(
+                    L"il2c_step2_mark_gcmark__ [3]: pCurrentFrame=0x{0:p}, index={1:u}, *ppReference=0x{2:p}, pAdjustedReference=0x{3:p}, type={4:s}, characteristic=0x{5:x}",
+                    pCurrentFrame,
+                    index,
+                    *ppReference,
+                    pAdjustedReference,
+                    pHeader->type->pTypeName,
+                    pHeader->characteristic);
+
+                // Mark for this objref.
+                il2c_mark_handler_for_objref__(pWorker, pAdjustedReference);
+            }
+            else
+            {
+                il2c_runtime_debug_log_format(
+                    L"il2c_step2_mark_gcmark__ [4]: pCurrentFrame=0x{0:p}, index={1:u}, *ppReference=0x{2:p}, pAdjustedReference=0x{3:p}, type={4:s}, characteristic=0x{5:x}",
+                    pCurrentFrame,
+                    index,
+                    *ppReference,
+                    pAdjustedReference,
+                    pHeader->type->pTypeName,
+                    pHeader->characteristic);
+            }
+        }
+
+        // Traverse value types at the current frame.
+        IL2C_VALUE_DESCRIPTOR* pValueDesc =
+            (IL2C_VALUE_DESCRIPTOR*)&pCurrentFrame->pReferences__[pCurrentFrame->objRefCount__];
+        for (index = 0; il2c_likely__(index < pCurrentFrame->valueCount__); index++, pValueDesc++)
+        {
+            il2c_assert(pValueDesc->ptr_value != NULL);
+            il2c_assert(pValueDesc->type_value != NULL);
+            il2c_assert((pValueDesc->type_value->flags & IL2C_TYPE_VALUE) == IL2C_TYPE_VALUE);
+
+            il2c_runtime_debug_log_format(
+                L"il2c_step2_mark_gcmark__ [5]: pCurrentFrame=0x{0:p}, index={1:u}, type={2:s}, pValue={3:p}",
+                pCurrentFrame,
+                index,
+                pValueDesc->type_value->pTypeName,
+                pValueDesc->ptr_value);
+
+            // Mark for this value.
+            il2c_mark_handler_for_value_type__(pWorker, (void*)pValueDesc->ptr_value, pValueDesc->type_value);
+        }
+
+        // Next frame
+        pCurrentFrame = pCurrentFrame->pNext__;
+    }
+}
+
+static void il2c_step2_mark_gcmark_for_root_referfences__(
+    IL2C_MARK_WORKER* pWorker, IL2C_ROOT_REFERENCES* pRootReferences, bool full)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    while (il2c_likely__(pRootReferences != NULL))
+    {
+        uint8_t index;
+        volatile System_Object* volatile* ppReference;
+        for (index = 0, ppReference = &pRootReferences->pReferences[0];
+            il2c_likely__(index < sizeof(pRootReferences->pReferences) / sizeof(void*));
+            index++, ppReference++)
+        {
+            // This slot is assigned.
+            System_Object* pAdjustedReference = (System_Object*)*ppReference;
+            if (il2c_likely__(pAdjustedReference != NULL))
+            {
+                TRY_GET_HEADER(pHeader, pAdjustedReference)
+                {
+                    il2c_runtime_debug_log_format(
+                        L"il2c_step2_mark_gcmark_for_root_referfences__ [1]: pRootReferences=0x{0:p}, index={1:u}, pAdjustedReference=0x{2:p}, type={3:s}, characteristic=0x{4:x}",
+                        pRootReferences,
+                        index,
+                        pAdjustedReference,
+                        pHeader->type->pTypeName,
+                        pHeader->characteristic);
 
-/////////////////////////////////////////////////////////////
-// Internal GC mark handlers
+                    // Mark for this objref.
+                    il2c_mark_handler_for_objref__(pWorker, pAdjustedReference);
+                }
+                else
+                {
+                    il2c_runtime_debug_log_format(
+                        L"il2c_step2_mark_gcmark_for_root_referfences__ [2]: pRootReferences=0x{0:p}, index={1:u}, pAdjustedReference=0x{2:p}, type={3:s}, characteristic=0x{4:x}",
+                        pRootReferences,
+                        index,
+                        pAdjustedReference,
+                        pHeader->type->pTypeName,
+                        pHeader->characteristic);
 
-// Has to ignore if objref is const.  (NOT const and initialized and NOT marked)
-// HACK: It's shame the icmpxchg may cause system fault if header is placed at read-only memory (CONST).
-//   (at x86/x64 cause, another platform may cause)
-// TODO: Reduce flags calculation.
-#define TRY_GET_HEADER(pHeader, pAdjustedReference) \
-    IL2C_REF_HEADER* pHeader = il2c_get_header__(pAdjustedReference); \
-    if (il2c_unlikely__(((pHeader->characteristic & \
-        (IL2C_CHARACTERISTIC_CONST | IL2C_CHARACTERISTIC_MARK_INDEX)) ^ IL2C_CHARACTERISTIC_MARK_INDEX) == \
-        g_CollectionMarkIndex__))
+                    // The old root instance (ex: thread) may contain young instances without the write barrier.
+                    if (!full && il2c_likely__((pHeader->characteristic & IL2C_CHARACTERISTIC_CONST) == 0))
+                    {
+                        il2c_push_mark__(pWorker, pAdjustedReference);
+                    }
+                }
+            }
+        }
 
-static void il2c_mark_handler_recursive__(void* pTarget, IL2C_RUNTIME_TYPE type, const uint8_t offset);
+        pRootReferences = pRootReferences->pNext;
+    }
+}
 
-static void il2c_mark_handler_for_objref__(System_Object* pAdjustedReference)
+static void il2c_step2_mark_gcmark_for_remembered_set__(IL2C_MARK_WORKER* pWorker)
 {
-    typedef void (*IL2C_MARK_HANDLER)(void* pReference);
-
-    il2c_assert(pAdjustedReference != NULL);
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
 
-    IL2C_REF_HEADER* pHeader = il2c_get_header__(pAdjustedReference);
-    il2c_assert(pHeader->type != NULL);
-    
-    // Marking with atomicity.
-    const interlock_t lastCharacteristic = il2c_ixor(&pHeader->characteristic, IL2C_CHARACTERISTIC_MARK_INDEX);
-    if (il2c_likely__((lastCharacteristic & IL2C_CHARACTERISTIC_MARK_INDEX) == g_CollectionMarkIndex__))
+    uintptr_t index;
+    for (index = 0; index < g_RememberedInstances__.count; index++)
     {
+        System_Object* pAdjustedReference = (System_Object*)g_RememberedInstances__.ppEntries[index];
+        IL2C_REF_HEADER* pHeader = il2c_get_header__(pAdjustedReference);
+
         il2c_runtime_debug_log_format(
-            L"il2c_mark_handler_for_objref__ [1]: pAdjustedReference=0x{0:p}, type={1:s}, lastCharacteristic=0x{2:x}",
+            L"il2c_step2_mark_gcmark_for_remembered_set__ [1]: pAdjustedReference=0x{0:p}, type={1:s}, characteristic=0x{2:x}",
             pAdjustedReference,
             pHeader->type->pTypeName,
-            lastCharacteristic);
-        // Already marked/fixed/constant
+            pHeader->characteristic);
+
+        il2c_iand(&pHeader->characteristic, ~IL2C_CHARACTERISTIC_REMEMBERED);
+        il2c_push_mark__(pWorker, pAdjustedReference);
+    }
+
+    for (index = 0; index < g_RememberedAddresses__.count; index++)
+    {
+        // Ignore if the address isn't inside the old instance.
+        IL2C_REF_HEADER* pHeader = il2c_heap_find_object__(g_RememberedAddresses__.ppEntries[index]);
+        if ((pHeader != NULL) &&
+            il2c_is_marked__(pHeader) &&
+            (pHeader->characteristic & IL2C_CHARACTERISTIC_INITIALIZED))
+        {
+            il2c_runtime_debug_log_format(
+                L"il2c_step2_mark_gcmark_for_remembered_set__ [2]: pAddress=0x{0:p}, type={1:s}, characteristic=0x{2:x}",
+                g_RememberedAddresses__.ppEntries[index],
+                pHeader->type->pTypeName,
+                pHeader->characteristic);
+
+            il2c_push_mark__(pWorker, (System_Object*)(pHeader + 1));
+        }
+    }
+
+    // All survivors will be the old generation, so the remembered set is empty after this collection.
+    il2c_clear_remembered_set__();
+}
+
+void il2c_register_finalizable__(System_Object* pAdjustedReference)
+{
+    il2c_assert(pAdjustedReference != NULL);
+
+    il2c_enter_monitor_lock__(&g_FinalizerLock__);
+
+    if (il2c_unlikely__(g_FinalizableCount__ >= g_FinalizableCapacity__))
+    {
+        const uintptr_t capacity = (g_FinalizableCapacity__ >= 1) ? (g_FinalizableCapacity__ * 2) : 64;
+#if defined(IL2C_USE_LINE_INFORMATION)
+        System_Object** ppFinalizables = il2c_malloc(capacity * sizeof(System_Object*), __FILE__, __LINE__);
+#else
+        System_Object** ppFinalizables = il2c_malloc(capacity * sizeof(System_Object*));
+#endif
+        // throw NotEnoughMemoryException();
+        il2c_assert(ppFinalizables != NULL);
+
+        if (g_ppFinalizables__ != NULL)
+        {
+            memcpy(ppFinalizables, g_ppFinalizables__, g_FinalizableCount__ * sizeof(System_Object*));
+            il2c_free(g_ppFinalizables__);
+        }
+        g_ppFinalizables__ = ppFinalizables;
+        g_FinalizableCapacity__ = capacity;
+    }
+
+    g_ppFinalizables__[g_FinalizableCount__++] = pAdjustedReference;
+
+    il2c_exit_monitor_lock__(&g_FinalizerLock__);
+}
+
+static void il2c_enqueue_finalizer__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    // Class type doesn't override the finalizer.
+    if (il2c_likely__((void*)((System_Object_VTABLE_DECL__*)(pHeader->type->vptr0))->Finalize == (void*)System_Object_Finalize))
+    {
         return;
     }
 
-    // This type has the custom mark handler.
-    // Because it's variable type, can't fix pointer offsets.
-    if (il2c_unlikely__((pHeader->type->flags & IL2C_TYPE_WITH_MARK_HANDLER) == IL2C_TYPE_WITH_MARK_HANDLER))
+    // Do atomic set finalized flag
+    const interlock_t characteristic = il2c_ior(&pHeader->characteristic, IL2C_CHARACTERISTIC_FINALIZER_CALLED);
+    if (il2c_unlikely__((characteristic & IL2C_CHARACTERISTIC_FINALIZER_CALLED) != 0))
     {
-        IL2C_MARK_HANDLER pMarkHandler = (IL2C_MARK_HANDLER)(pHeader->type->markTarget);
-        il2c_assert(pMarkHandler != NULL);
+        // Finalizer already called or suppressed (GC.SuppressFinalize())
+        return;
+    }
 
-        il2c_runtime_debug_log_format(
-            L"il2c_mark_handler_for_objref__ [2]: pAdjustedReference=0x{0:p}, type={1:s}, pMarkHandler=0x{2:p}",
-            pAdjustedReference,
-            pHeader->type->pTypeName,
-            pMarkHandler);
+    if (il2c_unlikely__(g_FinalizerQueueCount__ >= g_FinalizerQueueCapacity__))
+    {
+        const uintptr_t capacity = (g_FinalizerQueueCapacity__ >= 1) ? (g_FinalizerQueueCapacity__ * 2) : 16;
+#if defined(IL2C_USE_LINE_INFORMATION)
+        System_Object** ppQueue = il2c_malloc(capacity * sizeof(System_Object*), __FILE__, __LINE__);
+#else
+        System_Object** ppQueue = il2c_malloc(capacity * sizeof(System_Object*));
+#endif
+        // throw NotEnoughMemoryException();
+        il2c_assert(ppQueue != NULL);
 
-        // Invoke custom mark handler
-        pMarkHandler(pAdjustedReference);
+        if (g_ppFinalizerQueue__ != NULL)
+        {
+            memcpy(ppQueue, g_ppFinalizerQueue__, g_FinalizerQueueCount__ * sizeof(System_Object*));
+            il2c_free(g_ppFinalizerQueue__);
+        }
+        g_ppFinalizerQueue__ = ppQueue;
+        g_FinalizerQueueCapacity__ = capacity;
     }
-    // This type doesn't have the custom mark handler, traverser works just now.
-    else
+
+    System_Object* pAdjustedReference = (System_Object*)(pHeader + 1);
+    il2c_assert((void*)pAdjustedReference->vptr0__ == (void*)pHeader->type->vptr0);
+
+    g_ppFinalizerQueue__[g_FinalizerQueueCount__++] = pAdjustedReference;
+}
+
+// The pending finalizers (reserved at the earlier collections) keep their instances.
+static void il2c_step2_mark_gcmark_for_finalizer_queue__(IL2C_MARK_WORKER* pWorker)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    il2c_enter_monitor_lock__(&g_FinalizerLock__);
+
+    uintptr_t index;
+    for (index = g_FinalizerQueueHead__; index < g_FinalizerQueueCount__; index++)
     {
-        // NOTE: If this type is (boxed) value type,
-        //   we have to shift additional offset for System_ValueType (maybe only vptr0).
-        const uint8_t offset = (pHeader->type->flags & IL2C_TYPE_VALUE) ?
-            sizeof(System_ValueType) :
-            0;
+        il2c_mark_reference__(pWorker, g_ppFinalizerQueue__[index]);
+    }
+    if (g_pFinalizingReference__ != NULL)
+    {
+        il2c_mark_reference__(pWorker, g_pFinalizingReference__);
+    }
+
+    il2c_exit_monitor_lock__(&g_FinalizerLock__);
+}
+
+static uintptr_t il2c_step3_reserve_finalizers__(void)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    il2c_enter_monitor_lock__(&g_FinalizerLock__);
+
+    // Compact the pending entries.
+    if (g_FinalizerQueueHead__ >= 1)
+    {
+        memmove(g_ppFinalizerQueue__,
+            g_ppFinalizerQueue__ + g_FinalizerQueueHead__,
+            (g_FinalizerQueueCount__ - g_FinalizerQueueHead__) * sizeof(System_Object*));
+        g_FinalizerQueueCount__ -= g_FinalizerQueueHead__;
+        g_FinalizerQueueHead__ = 0;
+    }
+    const uintptr_t first = g_FinalizerQueueCount__;
+
+    // Collect unmarked instances with the finalizer.
+    //   The unreachable instances are dropped from the finalizable list (they're reserved or swept),
+    //   and the suppressed instances too (GC.ReRegisterForFinalize() registers again.)
+    //   The minor collection doesn't find the old instances, because they're still marked.
+    uintptr_t index;
+    uintptr_t kept = 0;
+    for (index = 0; index < g_FinalizableCount__; index++)
+    {
+        System_Object* pAdjustedReference = g_ppFinalizables__[index];
+        IL2C_REF_HEADER* pHeader = il2c_get_header__(pAdjustedReference);
+        if ((pHeader->characteristic & IL2C_CHARACTERISTIC_INITIALIZED) && !il2c_is_marked__(pHeader))
+        {
+            il2c_enqueue_finalizer__(pHeader, NULL);
+        }
+        else if (il2c_likely__((pHeader->characteristic & IL2C_CHARACTERISTIC_FINALIZER_CALLED) == 0))
+        {
+            g_ppFinalizables__[kept++] = pAdjustedReference;
+        }
+    }
+    g_FinalizableCount__ = kept;
+
+    // GC doesn't collect them (and referenced instances) current situation because finalizer perhaps made resurrection.
+    IL2C_MARK_WORKER* pWorker = il2c_begin_mark__();
+    for (index = first; index < g_FinalizerQueueCount__; index++)
+    {
+        il2c_mark_reference__(pWorker, g_ppFinalizerQueue__[index]);
+    }
+    il2c_finish_mark__(pWorker);
+
+    const uintptr_t count = g_FinalizerQueueCount__ - first;
+
+    il2c_exit_monitor_lock__(&g_FinalizerLock__);
+
+    return count;
+}
+
+// Calls the pending finalizers on the current thread, and returns count of the called finalizers.
+static uintptr_t il2c_invoke_finalizers__(void)
+{
+    uintptr_t count = 0;
+    while (1)
+    {
+        il2c_enter_monitor_lock__(&g_FinalizerLock__);
+        if (g_FinalizerQueueHead__ >= g_FinalizerQueueCount__)
+        {
+            g_FinalizerQueueHead__ = 0;
+            g_FinalizerQueueCount__ = 0;
+            g_pFinalizingReference__ = NULL;
+            il2c_exit_monitor_lock__(&g_FinalizerLock__);
+            break;
+        }
+
+        // It's still the GC root while calling the finalizer.
+        System_Object* pAdjustedReference = g_ppFinalizerQueue__[g_FinalizerQueueHead__++];
+        g_pFinalizingReference__ = pAdjustedReference;
+        g_GCStatistics__.finalizersCalled++;
+        il2c_exit_monitor_lock__(&g_FinalizerLock__);
 
         il2c_runtime_debug_log_format(
-            L"il2c_mark_handler_for_objref__ [3]: pAdjustedReference=0x{0:p}, type={1:s}, offset={2:u}",
-            pAdjustedReference,
-            pHeader->type->pTypeName,
-            offset);
+            L"il2c_invoke_finalizers__: call finalizer: type={0:s}, pAdjustedReference=0x{1:p}",
+            il2c_get_header__(pAdjustedReference)->type->pTypeName,
+            pAdjustedReference);
 
-        // Traverse recursively.
-        il2c_mark_handler_recursive__(pAdjustedReference, pHeader->type, offset);
+        // Call finalizer inside the frame, it's the entry point from the native code (the finalizer thread.)
+        struct
+        {
+            const IL2C_EXECUTION_FRAME* pNext__;
+            const uint16_t objRefCount__;
+            const uint16_t valueCount__;
+            System_Object* pReference;
+        } frame__ = { NULL, 1, 0, pAdjustedReference };
+        il2c_link_execution_frame(&frame__);
+        pAdjustedReference->vptr0__->Finalize(pAdjustedReference);
+        il2c_unlink_execution_frame(&frame__, NULL);
+        count++;
     }
+
+    return count;
 }
 
-static void il2c_mark_handler_for_value_type__(void* pValue, IL2C_RUNTIME_TYPE valueType)
+/////////////////////////////////////////////////////////////
+// Finalizer thread
+
+#if defined(IL2C_USE_FINALIZER_THREAD)
+
+static intptr_t g_FinalizerThreadHandle__ = 0;
+static volatile int32_t g_FinalizerThreadId__ = 0;
+static IL2C_SEMAPHORE g_FinalizerSemaphore__;
+static IL2C_SEMAPHORE g_FinalizerDrainedSemaphore__;
+static uint32_t g_FinalizerWaiters__ = 0;
+static volatile bool g_FinalizerShutdown__ = false;
+
+static IL2C_THREAD_ENTRY_POINT_RESULT_TYPE il2c_finalizer_entry_point__(
+    IL2C_THREAD_ENTRY_POINT_PARAMETER_TYPE parameter)
 {
-    il2c_assert(pValue != NULL);
-    il2c_assert(valueType != NULL);
-    il2c_assert((valueType->flags & IL2C_TYPE_VALUE) == IL2C_TYPE_VALUE);
+    ((void)parameter);
+
+    g_FinalizerThreadId__ = il2c_get_current_thread_id__();
+
+    while (1)
+    {
+        // The finalizers attach this thread.
+        const bool entered = il2c_enter_safe_region();
+        il2c_wait_semaphore__(&g_FinalizerSemaphore__);
+        il2c_leave_safe_region(entered);
+
+        il2c_invoke_finalizers__();
+
+        // Wake the waiters up (GC.WaitForPendingFinalizers) if drained.
+        il2c_enter_monitor_lock__(&g_FinalizerLock__);
+        uint32_t waiters = 0;
+        if (g_FinalizerQueueHead__ >= g_FinalizerQueueCount__)
+        {
+            waiters = g_FinalizerWaiters__;
+            g_FinalizerWaiters__ = 0;
+        }
+        il2c_exit_monitor_lock__(&g_FinalizerLock__);
+
+        while (waiters >= 1)
+        {
+            il2c_release_semaphore__(&g_FinalizerDrainedSemaphore__);
+            waiters--;
+        }
+
+        if (il2c_unlikely__(g_FinalizerShutdown__))
+        {
+            break;
+        }
+    }
+
+    il2c_detach_current_thread();
+
+    IL2C_THREAD_ENTRY_POINT_RETURN(0);
+}
+
+static void il2c_start_finalizer_thread__(void)
+{
+    il2c_initialize_semaphore__(&g_FinalizerSemaphore__);
+    il2c_initialize_semaphore__(&g_FinalizerDrainedSemaphore__);
+
+    const intptr_t threadHandle = il2c_create_thread__(il2c_finalizer_entry_point__, NULL);
+    // Continue calling the finalizers inside the collection.
+    if (il2c_unlikely__((threadHandle == 0) || (threadHandle == -1)))
+    {
+        il2c_destroy_semaphore__(&g_FinalizerSemaphore__);
+        il2c_destroy_semaphore__(&g_FinalizerDrainedSemaphore__);
+        return;
+    }
+
+    g_FinalizerThreadHandle__ = threadHandle;
+    il2c_resume_thread__(threadHandle);
+}
+
+static void il2c_stop_finalizer_thread__(void)
+{
+    if (g_FinalizerThreadHandle__ != 0)
+    {
+        // The finalizer thread calls the pending finalizers before exit.
+        g_FinalizerShutdown__ = true;
+        il2c_release_semaphore__(&g_FinalizerSemaphore__);
+
+        const bool entered = il2c_enter_safe_region();
+        il2c_join_thread__(g_FinalizerThreadHandle__);
+        il2c_leave_safe_region(entered);
+        il2c_close_thread_handle__(g_FinalizerThreadHandle__);
+        il2c_destroy_semaphore__(&g_FinalizerSemaphore__);
+        il2c_destroy_semaphore__(&g_FinalizerDrainedSemaphore__);
+
+        g_FinalizerThreadHandle__ = 0;
+        g_FinalizerThreadId__ = 0;
+    }
+}
+
+static bool il2c_is_finalizer_thread_running__(void)
+{
+    return g_FinalizerThreadHandle__ != 0;
+}
+
+// Wakes the finalizer thread up, it has to be invoked after the mutators resume.
+static void il2c_wake_finalizer_thread__(void)
+{
+    il2c_release_semaphore__(&g_FinalizerSemaphore__);
+}
+
+static bool il2c_wait_for_finalizer_thread__(void)
+{
+    if (g_FinalizerThreadHandle__ == 0)
+    {
+        return false;
+    }
+
+    // The finalizer can't wait for itself.
+    if (il2c_get_current_thread_id__() == g_FinalizerThreadId__)
+    {
+        return true;
+    }
+
+    il2c_enter_monitor_lock__(&g_FinalizerLock__);
+    const bool pending =
+        (g_FinalizerQueueHead__ < g_FinalizerQueueCount__) ||
+        (g_pFinalizingReference__ != NULL);
+    if (pending)
+    {
+        g_FinalizerWaiters__++;
+    }
+    il2c_exit_monitor_lock__(&g_FinalizerLock__);
+
+    if (pending)
+    {
+        const bool entered = il2c_enter_safe_region();
+        il2c_wait_semaphore__(&g_FinalizerDrainedSemaphore__);
+        il2c_leave_safe_region(entered);
+    }
+    return true;
+}
+#else
+#define il2c_start_finalizer_thread__() ((void)0)
+#define il2c_stop_finalizer_thread__() ((void)0)
+#define il2c_is_finalizer_thread_running__() (false)
+#define il2c_wake_finalizer_thread__() ((void)0)
+#define il2c_wait_for_finalizer_thread__() (false)
+#endif
+
+void il2c_initialize_finalizer__(void)
+{
+    il2c_initialize_monitor_lock__(&g_FinalizerLock__);
+
+    g_ppFinalizerQueue__ = NULL;
+    g_FinalizerQueueHead__ = 0;
+    g_FinalizerQueueCount__ = 0;
+    g_FinalizerQueueCapacity__ = 0;
+    g_pFinalizingReference__ = NULL;
+    g_ppFinalizables__ = NULL;
+    g_FinalizableCount__ = 0;
+    g_FinalizableCapacity__ = 0;
+    g_PendingRemains__ = 0;
+
+#if defined(IL2C_USE_FINALIZER_THREAD)
+    g_FinalizerThreadHandle__ = 0;
+    g_FinalizerThreadId__ = 0;
+    g_FinalizerWaiters__ = 0;
+    g_FinalizerShutdown__ = false;
+#endif
+
+    il2c_start_finalizer_thread__();
+}
+
+// The pending finalizers are called by the finalizer thread before exit,
+// and the final collection calls the rest.
+void il2c_shutdown_finalizer__(void)
+{
+    il2c_stop_finalizer_thread__();
+}
+
+void il2c_wait_for_pending_finalizers__(void)
+{
+    // Blocks until the finalizer thread drained the queue.
+    if (il2c_wait_for_finalizer_thread__())
+    {
+        return;
+    }
+
+    // The finalizers are called at the end of the collection.
+    while (g_PendingRemains__ >= 1)
+    {
+        il2c_collect();
+    }
+}
+
+/////////////////////////////////////////////////////////////
+// Incremental marking
+
+static void il2c_begin_incremental_mark__(void)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    il2c_heap_unmark_all__();
+    il2c_forget_remembered_set__();
+
+    g_IncrementalRememberedSetOverflowed__ = 0;
+    g_IncrementalRescanning__ = false;
+    g_IncrementalRescanLost__ = false;
+    g_IncrementalRescanCursor__ = 0;
+    g_IncrementalMarking__ = true;
+
+    // The next increment runs after allocated IL2C_GC_MARK_STEP_BYTES.
+    g_IncrementalSavedThreshold__ = g_CollectionThreshold__;
+    g_CollectionThreshold__ = IL2C_GC_MARK_STEP_BYTES;
+}
+
+static void il2c_end_incremental_mark__(void)
+{
+    // The abandoned cycle (by GC.Collect()) drops the gray instances, the next marking begins from the roots.
+    g_MarkStack__.count = 0;
+    g_IncrementalMarking__ = false;
+    g_CollectionThreshold__ = g_IncrementalSavedThreshold__;
+}
+
+// Traces a bounded amount, and returns true if the marking finished.
+static bool il2c_step_incremental_mark__(void)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+    il2c_assert(g_IncrementalMarking__);
+
+#if defined(IL2C_USE_MONOTONIC_CLOCK)
+    const uint64_t deadline = (g_GCConfiguration__.markStepMicroseconds != 0) ?
+        (il2c_get_monotonic_microseconds__() + g_GCConfiguration__.markStepMicroseconds) :
+        0;
+#else
+    const uint64_t deadline = 0;
+#endif
+
+    // The roots may be changed since the last increment.
+    //   The thread instances are traced again for their execution frames.
+    il2c_step2_mark_gcmark__(NULL, g_pBeginStaticFields__);
+    il2c_step2_mark_gcmark_for_root_referfences__(NULL, g_pRootReferences__, false);
+    il2c_step2_mark_gcmark_for_root_referfences__(NULL, g_pFixedReferences__, true);
+    il2c_step2_mark_gcmark_for_finalizer_queue__(NULL);
+
+    // The marked instances stored since the last increment.
+    il2c_enter_monitor_lock__(&g_RememberedSetLock__);
+    il2c_step2_mark_gcmark_for_remembered_set__(NULL);
+    il2c_exit_monitor_lock__(&g_RememberedSetLock__);
+
+    // Lost some instances stored since the last increment, the marked instances are traced again from the first block.
+    //   The rescanning runs only one pass per cycle.
+    if (il2c_unlikely__(il2c_ixchg(&g_IncrementalRememberedSetOverflowed__, 0) != 0))
+    {
+        if (g_IncrementalRescanning__ || (g_IncrementalRescanCursor__ != 0))
+        {
+            g_IncrementalRescanLost__ = true;
+        }
+        else
+        {
+            g_IncrementalRescanning__ = true;
+            g_IncrementalRescanCursor__ = 0;
+        }
+    }
+    if (il2c_unlikely__(g_IncrementalRescanning__))
+    {
+        g_IncrementalRescanning__ = !il2c_heap_enumerate_marked_bounded__(
+            &g_IncrementalRescanCursor__, IL2C_GC_MARK_STEP_RESCAN_BLOCKS, il2c_retrace_marked_instance__, NULL);
+    }
+
+    if (!il2c_drain_mark_stack_bounded__(&g_MarkStack__, g_GCConfiguration__.markStepWork, deadline) ||
+        g_IncrementalRescanning__)
+    {
+        il2c_runtime_debug_log_format(
+            L"il2c_step_incremental_mark__: remains={0:u}, rescanning={1:d}",
+            (uint32_t)g_MarkStack__.count,
+            g_IncrementalRescanning__);
+        return false;
+    }
+
+    // Lost some instances again while rescanning.
+    if (il2c_unlikely__(g_IncrementalRescanLost__))
+    {
+        il2c_ixchg(&g_MarkStackOverflowed__, 1);
+    }
 
-    il2c_runtime_debug_log_format(
-        L"il2c_mark_handler_for_value_type__: pValue=0x{0:p}, type={1:s}",
-        pValue,
-        valueType->pTypeName);
+    il2c_finish_mark__(NULL);
+    il2c_end_incremental_mark__();
 
-    // Traverse recursively.
-    il2c_mark_handler_recursive__(pValue, valueType, 0);
+    il2c_runtime_debug_log(L"il2c_step_incremental_mark__: finished");
+    return true;
 }
 
-static void il2c_mark_handler_recursive__(void* pTarget, IL2C_RUNTIME_TYPE type, const uint8_t offset)
-{
-    il2c_assert(pTarget != NULL);
-    il2c_assert(type != NULL);
+/////////////////////////////////////////////////////////////
+// Compaction
 
-    // Traverse type fields recursivity.
+typedef void (*IL2C_SLOT_VISITOR)(void** ppReference);
+
+// Visits the assigned objref slots in the fields (same traversal as il2c_mark_handler_recursive__.)
+static void il2c_visit_slots__(void* pTarget, IL2C_RUNTIME_TYPE type, const uint8_t offset, IL2C_SLOT_VISITOR pVisitor)
+{
     IL2C_MARK_TARGET* pMarkTarget = (IL2C_MARK_TARGET*)(type + 1);
     uintptr_t index;
     for (index = 0;
@@ -130,156 +2310,82 @@ static void il2c_mark_handler_recursive__(void* pTarget, IL2C_RUNTIME_TYPE type,
         index++, pMarkTarget++)
     {
         void* pTargetField = (void*)(((uint8_t*)pTarget) + pMarkTarget->offset + offset);
-
-        // Is this entry value type?
         if (il2c_unlikely__(pMarkTarget->valueType != NULL))
         {
-            il2c_assert((pMarkTarget->valueType->flags & IL2C_TYPE_VALUE) == IL2C_TYPE_VALUE);
-            il2c_assert(pTargetField != NULL);
-
-            il2c_runtime_debug_log_format(
-                L"il2c_mark_handler_recursive__ [1]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pTargetField=0x{3:p}, fieldType={4:s}",
-                pTarget,
-                type->pTypeName,
-                index,
-                pTargetField,
-                pMarkTarget->valueType->pTypeName);
-
-            // Mark for this value.
-            il2c_mark_handler_for_value_type__(pTargetField, pMarkTarget->valueType);
+            il2c_visit_slots__(pTargetField, pMarkTarget->valueType, 0, pVisitor);
         }
-        // This entry is objref.
-        else
+        else if (*(void**)pTargetField != NULL)
         {
-            // This field isn't assigned.
-            void* pReference = *(void**)pTargetField;
-            if (il2c_unlikely__(pReference == NULL))
-            {
-                il2c_runtime_debug_log_format(
-                    L"il2c_mark_handler_recursive__ [2]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pReference=NULL",
-                    pTarget,
-                    type->pTypeName,
-                    index,
-                    pReference);
-
-                continue;
-            }
-
-            System_Object* pAdjustedReferenceInner = il2c_adjusted_reference(pReference);
-            TRY_GET_HEADER(pHeaderInner, pAdjustedReferenceInner)
-            {
-                il2c_runtime_debug_log_format(
-                    L"il2c_mark_handler_recursive__ [3]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pAdjustedReferenceInner=0x{3:x}, targetType={4:s}, characteristic=0x{5:x}",
-                    pTarget,
-                    type->pTypeName,
-                    index,
-                    pAdjustedReferenceInner,
-                    pHeaderInner->type->pTypeName,
-                    pHeaderInner->characteristic);
-
-                // Use mark offset from type information.
-                il2c_mark_handler_for_objref__(pAdjustedReferenceInner);
-            }
-            else
-            {
-                il2c_runtime_debug_log_format(
-                    L"il2c_mark_handler_recursive__ [4]: pTarget=0x{0:p}, type={1:s}, index={2:u}, pAdjustedReferenceInner=0x{3:p}, targetType={4:s}, characteristic=0x{5:x}",
-                    pTarget,
-                    type->pTypeName,
-                    index,
-                    pAdjustedReferenceInner,
-                    pHeaderInner->type->pTypeName,
-                    pHeaderInner->characteristic);
-            }
+            pVisitor((void**)pTargetField);
         }
     }
 }
 
-/////////////////////////////////////////////////////////////
-// GC processes
-
-static void il2c_step2_mark_gcmark__(IL2C_GC_TRACKING_INFORMATION* pBeginFrame)
+static void il2c_visit_tracking_information_slots__(IL2C_GC_TRACKING_INFORMATION* pFrame, IL2C_SLOT_VISITOR pVisitor)
 {
-    // It has to be invoked from inside for GC process.
-    il2c_assert(g_ExecutingCollection__ >= 1);
-
-    // Mark headers.
-    IL2C_GC_TRACKING_INFORMATION* pCurrentFrame = pBeginFrame;
-    while (il2c_likely__(pCurrentFrame != NULL))
+    while (il2c_likely__(pFrame != NULL))
     {
-        // Traverse objrefs at the current frame.
         uint16_t index;
-        void** ppReference = (void**)&pCurrentFrame->pReferences__[0];
-        for (index = 0; il2c_likely__(index < pCurrentFrame->objRefCount__); index++, ppReference++)
+        void** ppReference = (void**)&pFrame->pReferences__[0];
+        for (index = 0; il2c_likely__(index < pFrame->objRefCount__); index++, ppReference++)
         {
-            // This variable isn't assigned.
-            if (il2c_unlikely__(*ppReference == NULL))
-            {
-                il2c_runtime_debug_log_format(
-                    L"il2c_step2_mark_gcmark__ [2]: pCurrentFrame=0x{0:p}, index={1:u}, *ppReference=NULL",
-                    pCurrentFrame,
-                    index);
-                continue;
-            }
-
-            System_Object* pAdjustedReference = il2c_adjusted_reference(*ppReference);
-            TRY_GET_HEADER(pHeader, pAdjustedReference)
-            {
-                il2c_runtime_debug_log_format(
-                    L"il2c_step2_mark_gcmark__ [3]: pCurrentFrame=0x{0:p}, index={1:u}, *ppReference=0x{2:p}, pAdjustedReference=0x{3:p}, type={4:s}, characteristic=0x{5:x}",
-                    pCurrentFrame,
-                    index,
-                    *ppReference,
-                    pAdjustedReference,
-                    pHeader->type->pTypeName,
-                    pHeader->characteristic);
-
-                // Mark for this objref.
-                il2c_mark_handler_for_objref__(pAdjustedReference);
-            }
-            else
+            if (*ppReference != NULL)
             {
-                il2c_runtime_debug_log_format(
-                    L"il2c_step2_mark_gcmark__ [4]: pCurrentFrame=0x{0:p}, index={1:u}, *ppReference=0x{2:p}, pAdjustedReference=0x{3:p}, type={4:s}, characteristic=0x{5:x}",
-                    pCurrentFrame,
-                    index,
-                    *ppReference,
-                    pAdjustedReference,
-                    pHeader->type->pTypeName,
-                    pHeader->characteristic);
+                pVisitor(ppReference);
             }
         }
 
-        // Traverse value types at the current frame.
         IL2C_VALUE_DESCRIPTOR* pValueDesc =
-            (IL2C_VALUE_DESCRIPTOR*)&pCurrentFrame->pReferences__[pCurrentFrame->objRefCount__];
-        for (index = 0; il2c_likely__(index < pCurrentFrame->valueCount__); index++, pValueDesc++)
+            (IL2C_VALUE_DESCRIPTOR*)&pFrame->pReferences__[pFrame->objRefCount__];
+        for (index = 0; il2c_likely__(index < pFrame->valueCount__); index++, pValueDesc++)
         {
-            il2c_assert(pValueDesc->ptr_value != NULL);
-            il2c_assert(pValueDesc->type_value != NULL);
-            il2c_assert((pValueDesc->type_value->flags & IL2C_TYPE_VALUE) == IL2C_TYPE_VALUE);
+            il2c_visit_slots__((void*)pValueDesc->ptr_value, pValueDesc->type_value, 0, pVisitor);
+        }
 
-            il2c_runtime_debug_log_format(
-                L"il2c_step2_mark_gcmark__ [5]: pCurrentFrame=0x{0:p}, index={1:u}, type={2:s}, pValue={3:p}",
-                pCurrentFrame,
-                index,
-                pValueDesc->type_value->pTypeName,
-                pValueDesc->ptr_value);
+        pFrame = pFrame->pNext__;
+    }
+}
 
-            // Mark for this value.
-            il2c_mark_handler_for_value_type__((void*)pValueDesc->ptr_value, pValueDesc->type_value);
+// The anchored instance isn't moved, because it's referred from the place the GC can't update.
+static void il2c_anchor_objref__(void* pReference)
+{
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(il2c_adjusted_reference(pReference));
+    il2c_heap_anchor__(pHeader);
+}
+
+static void il2c_anchor_slot__(void** ppReference)
+{
+    il2c_anchor_objref__(*ppReference);
+}
+
+// The root references hold the raw addresses (ex: GCHandle, thread local storage.)
+static void il2c_anchor_root_references__(IL2C_ROOT_REFERENCES* pRootReferences)
+{
+    while (il2c_likely__(pRootReferences != NULL))
+    {
+        uint8_t index;
+        volatile System_Object* volatile* ppReference;
+        for (index = 0, ppReference = &pRootReferences->pReferences[0];
+            il2c_likely__(index < sizeof(pRootReferences->pReferences) / sizeof(void*));
+            index++, ppReference++)
+        {
+            if (*ppReference != NULL)
+            {
+                il2c_anchor_objref__((void*)*ppReference);
+            }
         }
 
-        // Next frame
-        pCurrentFrame = pCurrentFrame->pNext__;
+        pRootReferences = pRootReferences->pNext;
     }
 }
 
-static void il2c_step2_mark_gcmark_for_root_referfences__(IL2C_ROOT_REFERENCES* pRootReferences)
+// The generated code keeps the objrefs in the C local variables and spills them to the execution frame
+// only at the GC points, so the C local variable and the slot refer the same instance after the GC.
+// The objref arguments are the C parameters, these are held by the caller's frame.
+// Therefore the instances referred from the execution frames (and the caught exceptions) aren't moved.
+static void il2c_anchor_thread_contexts__(void)
 {
-    // It has to be invoked from inside for GC process.
-    il2c_assert(g_ExecutingCollection__ >= 1);
-
+    IL2C_ROOT_REFERENCES* pRootReferences = g_pRootReferences__;
     while (il2c_likely__(pRootReferences != NULL))
     {
         uint8_t index;
@@ -288,32 +2394,21 @@ static void il2c_step2_mark_gcmark_for_root_referfences__(IL2C_ROOT_REFERENCES*
             il2c_likely__(index < sizeof(pRootReferences->pReferences) / sizeof(void*));
             index++, ppReference++)
         {
-            // This slot is assigned.
-            System_Object* pAdjustedReference = (System_Object*)*ppReference;
-            if (il2c_likely__(pAdjustedReference != NULL))
+            IL2C_RUNTIME_THREAD* pRuntimeThread = (IL2C_RUNTIME_THREAD*)*ppReference;
+            if (il2c_likely__(pRuntimeThread != NULL))
             {
-                TRY_GET_HEADER(pHeader, pAdjustedReference)
-                {
-                    il2c_runtime_debug_log_format(
-                        L"il2c_step2_mark_gcmark_for_root_referfences__ [1]: pRootReferences=0x{0:p}, index={1:u}, pAdjustedReference=0x{2:p}, type={3:s}, characteristic=0x{4:x}",
-                        pRootReferences,
-                        index,
-                        pAdjustedReference,
-                        pHeader->type->pTypeName,
-                        pHeader->characteristic);
+                il2c_assert(pRuntimeThread->thread.vptr0__ == &System_Threading_Thread_VTABLE__);
 
-                    // Mark for this objref.
-                    il2c_mark_handler_for_objref__(pAdjustedReference);
-                }
-                else
+                il2c_visit_tracking_information_slots__(pRuntimeThread->context.pFrame, il2c_anchor_slot__);
+
+                IL2C_EXCEPTION_FRAME* pUnwindTarget = pRuntimeThread->context.pUnwindTarget;
+                while (pUnwindTarget != NULL)
                 {
-                    il2c_runtime_debug_log_format(
-                        L"il2c_step2_mark_gcmark_for_root_referfences__ [2]: pRootReferences=0x{0:p}, index={1:u}, pAdjustedReference=0x{2:p}, type={3:s}, characteristic=0x{4:x}",
-                        pRootReferences,
-                        index,
-                        pAdjustedReference,
-                        pHeader->type->pTypeName,
-                        pHeader->characteristic);
+                    if (pUnwindTarget->ex != NULL)
+                    {
+                        il2c_anchor_objref__((void*)pUnwindTarget->ex);
+                    }
+                    pUnwindTarget = pUnwindTarget->pNext;
                 }
             }
         }
@@ -322,121 +2417,211 @@ static void il2c_step2_mark_gcmark_for_root_referfences__(IL2C_ROOT_REFERENCES*
     }
 }
 
-static uintptr_t il2c_step3_sweep_garbage__(void)
+// The array and the delegate are updated by the GC, the other custom mark handlers can't update the references.
+static bool il2c_is_relocatable_mark_handler__(IL2C_RUNTIME_TYPE type)
 {
-    // It has to be invoked from inside for GC process.
-    il2c_assert(g_ExecutingCollection__ >= 1);
+    return
+        (type == il2c_typeof(System_Array)) ||
+        (type->markTarget == (uintptr_t)System_Delegate_MarkHandler__);
+}
 
-    // Detected pending instances
-    g_PendingRemains__ = 0;
-    // Detected instance remains
-    uintptr_t remains = 0;
+static void il2c_anchor_custom_marked_instance__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    typedef void (*IL2C_MARK_HANDLER)(void* pReference);
 
-    // =================================================================
-    // Step 1: Collect unmarked instances and call finalizers.
+    ((void)pContext);
 
-    IL2C_REF_HEADER** ppUnlinkTarget = &g_pBeginHeader__;
-    IL2C_REF_HEADER* pCurrentHeader = g_pBeginHeader__;
-    IL2C_REF_HEADER* pScheduledHeader = NULL;
-    while (il2c_likely__(pCurrentHeader != NULL))
+    if (il2c_likely__((pHeader->type->flags & IL2C_TYPE_WITH_MARK_HANDLER) != IL2C_TYPE_WITH_MARK_HANDLER) ||
+        il2c_is_relocatable_mark_handler__(pHeader->type))
     {
-        IL2C_REF_HEADER* pNext = pCurrentHeader->pNext;
-        if (il2c_unlikely__(((pCurrentHeader->characteristic &
-            (IL2C_CHARACTERISTIC_INITIALIZED | IL2C_CHARACTERISTIC_MARK_INDEX)) ^
-            (IL2C_CHARACTERISTIC_INITIALIZED | IL2C_CHARACTERISTIC_MARK_INDEX)) ==
-            g_CollectionMarkIndex__))
-        {
-            // Class type overrided the finalizer:
-            if (il2c_unlikely__((void*)((System_Object_VTABLE_DECL__*)(pCurrentHeader->type->vptr0))->Finalize != (void*)System_Object_Finalize))
-            {
-                // Do atomic set finalized flag
-                interlock_t characteristic = il2c_ior(&pCurrentHeader->characteristic, IL2C_CHARACTERISTIC_FINALIZER_CALLED);
-                if (il2c_likely__((characteristic & IL2C_CHARACTERISTIC_FINALIZER_CALLED) == 0))
-                {
-                    // Finalizer didn't call or reregistered (GC.ReRegisterForFinalize())
+        return;
+    }
 
-                    // Temporary marked (reserving resurrection)
-                    il2c_ixor(&pCurrentHeader->characteristic, IL2C_CHARACTERISTIC_MARK_INDEX);
+    // The instance itself may be referred by the native code (ex: thread context.)
+    il2c_anchor_objref__((void*)(pHeader + 1));
 
-                    System_Object* pAdjustedReference = (System_Object*)(((uint8_t*)pCurrentHeader) + sizeof(IL2C_REF_HEADER));
-                    il2c_assert((void*)pAdjustedReference->vptr0__ == (void*)pCurrentHeader->type->vptr0);
+    // The references are reported to il2c_default_mark_handler_for_objref__() while anchoring.
+    IL2C_MARK_HANDLER pMarkHandler = (IL2C_MARK_HANDLER)(pHeader->type->markTarget);
+    pMarkHandler((void*)(pHeader + 1));
+}
 
-                    il2c_runtime_debug_log_format(
-                        L"il2c_step3_sweep_garbage__ [1]: call finalizer: type={0:s}, pAdjustedReference=0x{0:p}",
-                        pCurrentHeader->type->pTypeName,
-                        pAdjustedReference);
+static void il2c_relocate_slot__(void** ppReference)
+{
+    uint8_t* pReference = (uint8_t*)*ppReference;
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(il2c_adjusted_reference(pReference));
+    if (il2c_unlikely__(pHeader->characteristic & IL2C_CHARACTERISTIC_FORWARDED))
+    {
+        // Keep the interface adjustor offset.
+        *ppReference = pReference + ((uint8_t*)il2c_heap_forwarded__(pHeader) - (uint8_t*)pHeader);
+    }
+}
 
-                    // Call finalizer.
-                    pAdjustedReference->vptr0__->Finalize(pAdjustedReference);
+static void il2c_relocate_instance__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    ((void)pContext);
 
-                    // GC don't collect current situation because finalizer perhaps made resurrection.
-                    g_PendingRemains__++;
-                    remains++;
+    if (pHeader->characteristic & IL2C_CHARACTERISTIC_POINTER_FREE)
+    {
+        return;
+    }
 
-                    ppUnlinkTarget = (void*)&pCurrentHeader->pNext;
+    void* pReference = (void*)(pHeader + 1);
+    if (il2c_unlikely__((pHeader->type->flags & IL2C_TYPE_WITH_MARK_HANDLER) == IL2C_TYPE_WITH_MARK_HANDLER))
+    {
+        if (pHeader->type == il2c_typeof(System_Array))
+        {
+            System_Array* arr = (System_Array*)pReference;
+            IL2C_RUNTIME_TYPE elementType = arr->elementType__;
+            intptr_t index;
+            if ((elementType->flags & IL2C_TYPE_VALUE) == 0)
+            {
+                for (index = 0; il2c_likely__(index < arr->Length); index++)
+                {
+                    void** ppElement = (void**)&il2c_array_item(arr, void*, index);
+                    if (*ppElement != NULL)
+                    {
+                        il2c_relocate_slot__(ppElement);
+                    }
                 }
-                else
+            }
+            else if ((elementType->flags & IL2C_TYPE_POINTER_FREE) == 0)
+            {
+                for (index = 0; il2c_likely__(index < arr->Length); index++)
                 {
-                    // Very important unlink step: because cause misread on purpose this__ instance is living.
-                    *ppUnlinkTarget = pNext;
-
-                    // Insert to free list.
-                    pCurrentHeader->pNext = pScheduledHeader;
-                    pScheduledHeader = pCurrentHeader;
+                    void* pValue = il2c_array_itemptr__(arr, (uint32_t)(elementType->bodySize), index);
+                    il2c_visit_slots__(pValue, elementType, 0, il2c_relocate_slot__);
                 }
             }
-            else
+        }
+        else if (pHeader->type->markTarget == (uintptr_t)System_Delegate_MarkHandler__)
+        {
+            System_Delegate* dlg = (System_Delegate*)pReference;
+            uintptr_t index;
+            for (index = 0; il2c_likely__(index < dlg->count__); index++)
             {
-                // Very important unlink step: because cause misread on purpose this__ instance is living.
-                *ppUnlinkTarget = pNext;
-
-                // Insert to free list.
-                pCurrentHeader->pNext = pScheduledHeader;
-                pScheduledHeader = pCurrentHeader;
+                void** ppTarget = (void**)&dlg->methodtbl__[index].target;
+                if (*ppTarget != NULL)
+                {
+                    il2c_relocate_slot__(ppTarget);
+                }
             }
         }
-        else
+        // The references by the other custom mark handlers are anchored.
+        return;
+    }
+
+    // The boxed value type shifts the offset for System_ValueType (same as il2c_trace_objref__.)
+    const uint8_t offset = (pHeader->type->flags & IL2C_TYPE_VALUE) ?
+        sizeof(System_ValueType) :
+        0;
+    il2c_visit_slots__(pReference, pHeader->type, offset, il2c_relocate_slot__);
+}
+
+// The execution frames aren't relocated, because the instances referred from them are anchored.
+static void il2c_relocate_roots__(void)
+{
+    il2c_visit_tracking_information_slots__(g_pBeginStaticFields__, il2c_relocate_slot__);
+
+    uintptr_t index;
+    for (index = g_FinalizerQueueHead__; index < g_FinalizerQueueCount__; index++)
+    {
+        il2c_relocate_slot__((void**)&g_ppFinalizerQueue__[index]);
+    }
+
+    // The finalizable list isn't the roots, but the registered instances are moved too.
+    for (index = 0; index < g_FinalizableCount__; index++)
+    {
+        il2c_relocate_slot__((void**)&g_ppFinalizables__[index]);
+    }
+}
+
+// The compaction doesn't move the instances while the other threads execute the managed code,
+// or the finalizer thread calls the finalizer.
+static bool il2c_can_compact__(void)
+{
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+    // The instances referred from the native stacks can't be moved (they aren't the precise references.)
+    return false;
+#else
+    if (g_pFinalizingReference__ != NULL)
+    {
+        return false;
+    }
+
+    const void* pCurrentThreadContext = il2c_get_tls_value(g_TlsIndex__);
+
+    IL2C_ROOT_REFERENCES* pRootReferences = g_pRootReferences__;
+    while (il2c_likely__(pRootReferences != NULL))
+    {
+        uint8_t index;
+        volatile System_Object* volatile* ppReference;
+        for (index = 0, ppReference = &pRootReferences->pReferences[0];
+            il2c_likely__(index < sizeof(pRootReferences->pReferences) / sizeof(void*));
+            index++, ppReference++)
         {
-            ppUnlinkTarget = (void*)&pCurrentHeader->pNext;
-            remains++;
+            IL2C_RUNTIME_THREAD* pRuntimeThread = (IL2C_RUNTIME_THREAD*)*ppReference;
+            if ((pRuntimeThread != NULL) &&
+                ((const void*)&pRuntimeThread->context != pCurrentThreadContext) &&
+                (pRuntimeThread->context.pFrame != NULL))
+            {
+                return false;
+            }
         }
 
-        // Next
-        pCurrentHeader = pNext;
+        pRootReferences = pRootReferences->pNext;
     }
 
-    // =================================================================
-    // Step 2: Free collected instances.
+    return true;
+#endif
+}
+
+// Moves the live instances out of the sparse blocks, and updates the precise references to them.
+// The instances referred from the untracked places (root references, custom mark handlers) aren't moved,
+// the instances referred from the execution frames (these may be copied to the C local variables),
+// and the pinned instances (the identity hash code is taken) or the monitor locked instances too.
+// NOTE: The managed pointers (byref) and the native pointers to the heap instances
+//   can't live across the GC.Collect() if IL2C_GC_FLAG_COMPACTION, use the pinned GCHandle.
+static void il2c_step3_compact__(void)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    // The finalizer thread doesn't begin the next finalizer while compacting.
+    il2c_enter_monitor_lock__(&g_FinalizerLock__);
 
-    while (il2c_likely__(pScheduledHeader != NULL))
+    if (il2c_can_compact__())
     {
-        IL2C_REF_HEADER* pNext = pScheduledHeader->pNext;
+        il2c_anchor_root_references__(g_pRootReferences__);
+        il2c_anchor_root_references__(g_pFixedReferences__);
+        il2c_anchor_thread_contexts__();
 
-        il2c_runtime_debug_log_format(
-            L"il2c_step3_sweep_garbage__ [2]: free: type={0:s}, pObject=0x{1:p}, characteristic=0x{2:x}",
-            pScheduledHeader->type->pTypeName,
-            ((uint8_t*)pScheduledHeader) + sizeof(IL2C_REF_HEADER),
-            pScheduledHeader->characteristic);
+        g_CompactionAnchoring__ = true;
+        il2c_heap_enumerate_marked__(il2c_anchor_custom_marked_instance__, NULL);
+        g_CompactionAnchoring__ = false;
 
-        // Simply ignore if this instance didn't mark ACQUIRED.
-        if (il2c_unlikely__(pScheduledHeader->characteristic & IL2C_CHARACTERISTIC_ACQUIRED_MONITOR_LOCK))
+        uintptr_t moved = 0;
+        if (il2c_heap_select_evacuation_blocks__(IL2C_GC_EVACUATION_LIVE_PERCENT) >= 1)
         {
-            // Monitor lock discarded.
-            il2c_release_monitor_lock_from_objref__(pScheduledHeader);
+            moved = il2c_heap_evacuate__();
+            if (moved >= 1)
+            {
+                il2c_relocate_roots__();
+                il2c_heap_enumerate_marked__(il2c_relocate_instance__, NULL);
+            }
         }
 
-        // Heap discarded.
-        il2c_free((void*)pScheduledHeader);
+        il2c_heap_finish_evacuation__();
 
-        // Next
-        pScheduledHeader = pNext;
+        il2c_runtime_debug_log_format(
+            L"il2c_step3_compact__: moved={0:u}",
+            (uint32_t)moved);
     }
 
-    return remains;
+    il2c_exit_monitor_lock__(&g_FinalizerLock__);
 }
 
-#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
-static void il2c_enter_for_collect__(void)
+// Gives back all thread local allocation buffers to the shared heap before sweeping.
+static void il2c_retire_allocation_contexts__(void)
 {
     // It has to be invoked from inside for GC process.
     il2c_assert(g_ExecutingCollection__ >= 1);
@@ -456,7 +2641,8 @@ static void il2c_enter_for_collect__(void)
             {
                 il2c_assert(pRuntimeThread->thread.vptr0__ == &System_Threading_Thread_VTABLE__);
 
-                il2c_enter_monitor_lock__((void*)&pRuntimeThread->context.lockForCollect);
+                il2c_heap_retire_allocation_context__(
+                    (IL2C_HEAP_ALLOCATION_CONTEXT*)&pRuntimeThread->context.allocationContext);
             }
         }
 
@@ -464,11 +2650,43 @@ static void il2c_enter_for_collect__(void)
     }
 }
 
-static void il2c_exit_for_collect__(void)
+// Takes the GC lock. The thread waiting for the other collection (or the heap walking) enters the safe region,
+// because the collecting thread waits for it at the safepoint.
+static void il2c_enter_lock_for_collect__(void)
+{
+#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+    if (il2c_unlikely__(!il2c_try_enter_monitor_lock__(&g_GlobalLockForCollect__)))
+    {
+        const bool entered = il2c_enter_safe_region();
+        il2c_enter_monitor_lock__(&g_GlobalLockForCollect__);
+        il2c_leave_safe_region(entered);
+    }
+#else
+    il2c_enter_monitor_lock__(&g_GlobalLockForCollect__);
+#endif
+}
+
+#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+// Stops all mutators: Requests the safepoint and waits until all threads are PARKED or SAFE.
+// The parked threads block on g_GlobalLockForCollect__ until il2c_exit_for_collect__().
+static void il2c_enter_for_collect__(void)
 {
     // It has to be invoked from inside for GC process.
     il2c_assert(g_ExecutingCollection__ >= 1);
 
+    g_SafepointOwnerId__ = il2c_get_current_thread_id__();
+    il2c_ixchg(&g_SafepointRequested__, 1);
+
+    const void* pCurrentThreadContext = il2c_get_tls_value(g_TlsIndex__);
+
+    // The collecting thread is RUNNING, its native stack is scanned from here.
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+    if (il2c_likely__(pCurrentThreadContext != NULL))
+    {
+        il2c_save_native_stack__((IL2C_THREAD_CONTEXT*)pCurrentThreadContext);
+    }
+#endif
+
     IL2C_ROOT_REFERENCES* pRootReferences = g_pRootReferences__;
     while (il2c_likely__(pRootReferences != NULL))
     {
@@ -480,16 +2698,35 @@ static void il2c_exit_for_collect__(void)
         {
             // This slot is assigned.
             IL2C_RUNTIME_THREAD* pRuntimeThread = (IL2C_RUNTIME_THREAD*)*ppReference;
-            if (il2c_likely__(pRuntimeThread != NULL))
+            if (il2c_likely__((pRuntimeThread != NULL) &&
+                ((const void*)&pRuntimeThread->context != pCurrentThreadContext)))
             {
                 il2c_assert(pRuntimeThread->thread.vptr0__ == &System_Threading_Thread_VTABLE__);
 
-                il2c_exit_monitor_lock__((void*)&pRuntimeThread->context.lockForCollect);
+                // Back off: yields at first, sleeps if the thread doesn't reach the safepoint.
+                uint32_t retryCount = 0;
+                while (pRuntimeThread->context.safepointState == IL2C_SAFEPOINT_STATE_RUNNING)
+                {
+                    il2c_sleep((retryCount++ < 16) ? 0 : 1);
+                }
             }
         }
 
         pRootReferences = pRootReferences->pNext;
     }
+
+    // Read the execution frames after observed the states.
+    il2c_memory_barrier();
+}
+
+static void il2c_exit_for_collect__(void)
+{
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    // The parked threads resume after released g_GlobalLockForCollect__.
+    il2c_ixchg(&g_SafepointRequested__, 0);
+    g_SafepointOwnerId__ = 0;
 }
 #endif
 
@@ -517,82 +2754,199 @@ void il2c_collect__(void)
 #endif
 
     // Take GC locks.
-    il2c_enter_monitor_lock__(&g_GlobalLockForCollect__);
+    il2c_enter_lock_for_collect__();
 #if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
     il2c_enter_for_collect__();
 #endif
+    il2c_retire_allocation_contexts__();
+
+    const uint64_t beginTimestamp = il2c_get_pause_timestamp__();
+
+    // The last lazy sweeping has to be finished before marking.
+    il2c_heap_finish_sweep__();
 
 #if defined(IL2C_USE_LINE_INFORMATION)
     il2c_runtime_debug_log_format(
-        L"il2c_collect__: begin: {0:u}: Header=0x{1:p}, StaticFields=0x{2:p}, markIndex={3:x}, {4:s}({5:d})",
+        L"il2c_collect__: begin: {0:u}: StaticFields=0x{1:p}, {2:s}({3:d})",
         collectCount,
-        g_pBeginHeader__,
         g_pBeginStaticFields__,
-        g_CollectionMarkIndex__,
         pFile, line);
 #elif defined(_DEBUG)
     il2c_runtime_debug_log(
-        L"il2c_collect__: begin: {0:u}: Header=0x{1:p}, StaticFields=0x{2:p}, markIndex={3:x}",
+        L"il2c_collect__: begin: {0:u}: StaticFields=0x{1:p}",
         collectCount,
-        g_pBeginHeader__,
-        g_pBeginStaticFields__,
-        g_CollectionMarkIndex__);
+        g_pBeginStaticFields__);
 #else
     il2c_runtime_debug_log(L"il2c_collect__: begin");
 #endif
 
-    //////////////////////////////////////////////////
-    // GC Step 1:
+    // Begin next allocation period.
+    g_GCStatistics__.allocatedBytes += (uintptr_t)il2c_ixchg(&g_AllocatedBytesSinceCollect__, 0);
 
-    // Note: Traditional mark-sweep GC's first step is clearing markings.
-    //   The IL2C GC skips this step and mark/clear flag indicates with inverse arithmetic
-    //   between g_CollectionMarkIndex__ and characteristic's MARK_INDEX.
-    //   The instances characteristic MARK_INDEX will indicate last stats, so makes NOT MARKED if inversed this flag.
-    il2c_ixor(&g_CollectionMarkIndex__, IL2C_CHARACTERISTIC_MARK_INDEX);
+    // The explicit request (GC.Collect()) doesn't wait for the increments.
+    const bool requested = il2c_is_full_collection_requested__();
+    if (il2c_unlikely__(g_IncrementalMarking__ && requested))
+    {
+        il2c_end_incremental_mark__();
+    }
 
-    il2c_check_heap();
+    const bool incremental = g_IncrementalMarking__ ||
+        (!requested &&
+         (g_GCConfiguration__.flags & IL2C_GC_FLAG_INCREMENTAL) &&
+         il2c_is_full_collection_required__());
+    const bool full = incremental || requested || il2c_is_full_collection_required__();
+    const bool compaction = il2c_is_compaction_requested__() && full;
 
-    //////////////////////////////////////
-    // GC Step 2:
+    if (incremental)
+    {
+        // The incremental marking begins with same as GC Step 1, and traces the heap at the increments.
+        if (!g_IncrementalMarking__)
+        {
+            il2c_begin_incremental_mark__();
+        }
 
-    il2c_step2_mark_gcmark__(g_pBeginStaticFields__);
-    il2c_check_heap();
+        const bool marked = il2c_step_incremental_mark__();
+        il2c_check_heap();
 
-    il2c_step2_mark_gcmark_for_root_referfences__(g_pRootReferences__);
-    il2c_check_heap();
-    il2c_step2_mark_gcmark_for_root_referfences__(g_pFixedReferences__);
-    il2c_check_heap();
+        // The mutators resume until the next increment.
+        if (!marked)
+        {
+            il2c_account_pause__(beginTimestamp);
+#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+            il2c_exit_for_collect__();
+#endif
+            il2c_exit_monitor_lock__(&g_GlobalLockForCollect__);
+            il2c_idec(&g_ExecutingCollection__);
+            return;
+        }
+    }
+    else
+    {
+        //////////////////////////////////////////////////
+        // GC Step 1:
+
+        // Note: Traditional mark-sweep GC's first step is clearing markings.
+        //   The IL2C GC uses sticky mark bits: the surviving instances stay marked as the old generation,
+        //   and the new instances are allocated NOT MARKED (young generation.)
+        //   The minor collection skips this step, so it traces only young instances.
+        if (full)
+        {
+            il2c_heap_unmark_all__();
+            il2c_forget_remembered_set__();
+        }
+
+        il2c_check_heap();
+
+        //////////////////////////////////////
+        // GC Step 2:
+
+        // The roots are distributed to the mark workers, and they trace in parallel at il2c_finish_mark__().
+        IL2C_MARK_WORKER* pWorker = il2c_begin_mark__();
+
+        il2c_step2_mark_gcmark__(pWorker, g_pBeginStaticFields__);
+        il2c_check_heap();
+
+        il2c_step2_mark_gcmark_for_root_referfences__(pWorker, g_pRootReferences__, full);
+        il2c_check_heap();
+        il2c_step2_mark_gcmark_for_root_referfences__(pWorker, g_pFixedReferences__, full);
+        il2c_check_heap();
+
+        // Old to young references.
+        if (!full)
+        {
+            il2c_step2_mark_gcmark_for_remembered_set__(pWorker);
+            il2c_check_heap();
+        }
+
+        il2c_step2_mark_gcmark_for_finalizer_queue__(pWorker);
+        il2c_check_heap();
+
+        il2c_finish_mark__(pWorker);
+        il2c_check_heap();
+    }
 
     //////////////////////////////////////////////////
     // GC Step 3:
 
-    il2c_step3_sweep_garbage__();
+    const uintptr_t reservedFinalizers = il2c_step3_reserve_finalizers__();
+    il2c_check_heap();
+
+    // The reserved instances are moved too, they're in the finalizer queue.
+    if (compaction)
+    {
+        il2c_step3_compact__();
+        il2c_check_heap();
+    }
+
+    //////////////////////////////////////////////////
+    // GC Step 4:
+
+    // Note: The pause doesn't sweep the blocks. The allocator sweeps them on demand
+    //   and in the bounded chunks after the mutators resume (lazy sweeping),
+    //   or the sweeper thread sweeps them if enabled (background sweeping.)
+    //   The thresholds are updated when finished sweeping.
+    g_LastCollectionFull__ = full;
+    il2c_heap_begin_sweep__(full, il2c_is_background_sweeping__());
     il2c_check_heap();
 
+    //////////////////////////////////////////////////
+    // GC Step 5:
+
+    // Note: The finalizer thread calls the finalizers after the mutators resume if available,
+    //   so the slow finalizers don't extend the pause.
+    const bool finalizerThreadRunning = il2c_is_finalizer_thread_running__();
+    g_PendingRemains__ = finalizerThreadRunning ?
+        (uint32_t)reservedFinalizers :
+        (uint32_t)il2c_invoke_finalizers__();
+
 #if defined(IL2C_USE_LINE_INFORMATION)
     il2c_runtime_debug_log_format(
-        L"il2c_collect__: finished: {0:u}: pendingRemains={1:u}, {2:s}({3:d})",
+        L"il2c_collect__: finished: {0:u}: full={1:d}, pendingRemains={2:u}, {3:s}({4:d})",
         collectCount,
+        full,
         g_PendingRemains__,
         pFile,
         line);
 #elif defined(_DEBUG)
     il2c_runtime_debug_log_format(
-        L"il2c_collect__: finished: {0:u}: pendingRemains={1:u}",
+        L"il2c_collect__: finished: {0:u}: full={1:d}, pendingRemains={2:u}",
         collectCount,
+        full,
         g_PendingRemains__);
 #else
     il2c_runtime_debug_log_format(
-        L"il2c_collect__: finished: pendingRemains={0:u}",
+        L"il2c_collect__: finished: full={0:d}, pendingRemains={1:u}",
+        full,
         g_PendingRemains__);
 #endif
 
+    //////////////////////////////////////////////////
+    // GC Step 6:
+
+    // Note: The blocks emptied by this collection are released by the lazy sweeping later,
+    //   so they're trimmed at the following collections.
+    il2c_trim_heap__(full);
+
+    g_GCStatistics__.collections++;
+    if (full)
+    {
+        g_GCStatistics__.fullCollections++;
+    }
+    il2c_account_pause__(beginTimestamp);
+
     // Release GC locks.
 #if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
     il2c_exit_for_collect__();
 #endif
     il2c_exit_monitor_lock__(&g_GlobalLockForCollect__);
 
+    // The sweeper synchronizes with the allocator only.
+    il2c_wake_sweeper__();
+    if (finalizerThreadRunning && (reservedFinalizers >= 1))
+    {
+        il2c_wake_finalizer_thread__();
+    }
+
     il2c_idec(&g_ExecutingCollection__);
 }
 
@@ -612,52 +2966,74 @@ void il2c_collect_for_final_shutdown__(void)
 #endif
 
     // Take GC locks.
-    il2c_enter_monitor_lock__(&g_GlobalLockForCollect__);
+    il2c_enter_lock_for_collect__();
 #if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
     il2c_enter_for_collect__();
 #endif
+    il2c_retire_allocation_contexts__();
+    il2c_heap_finish_sweep__();
+
+    // Discard the unfinished incremental marking.
+    if (g_IncrementalMarking__)
+    {
+        il2c_end_incremental_mark__();
+    }
 
     il2c_check_heap();
 
 #if defined(_DEBUG)
     il2c_runtime_debug_log_format(
-        L"il2c_collect_for_final_shutdown__: begin: {0:u}: Header=0x{1:p}, StaticFields=0x{2:p}, markIndex={3:x}",
+        L"il2c_collect_for_final_shutdown__: begin: {0:u}: StaticFields=0x{1:p}",
         collectCount,
-        g_pBeginHeader__,
-        g_pBeginStaticFields__,
-        g_CollectionMarkIndex__);
+        g_pBeginStaticFields__);
 #else
     il2c_runtime_debug_log(
         L"il2c_collect_for_final_shutdown__: begin");
 #endif
 
+    // Resume the safepoint before unregistering the threads from the root references,
+    // because the thread instances are finalized at this collection.
+    // (The final collection doesn't race with the mutators.)
+#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+    il2c_exit_for_collect__();
+#endif
+
     // Exhaust all instances
     while (1)
     {
         //////////////////////////////////////////////////
         // GC Step 1:
 
-        // Note: Traditional mark-sweep GC's first step is clearing markings.
-        //   The IL2C GC skips this step and mark/clear flag indicates with inverse arithmetic
-        //   between g_CollectionMarkIndex__ and characteristic's MARK_INDEX.
-        //   The instances characteristic MARK_INDEX will indicate last stats, so makes NOT MARKED if inversed this flag.
-        il2c_ixor(&g_CollectionMarkIndex__, IL2C_CHARACTERISTIC_MARK_INDEX);
+        // Makes all instances NOT MARKED (includes old generation.)
+        il2c_heap_unmark_all__();
+        il2c_forget_remembered_set__();
 
         //////////////////////////////////////
         // GC Step 2:
 
         // The final GC step has to ignore both static fields, root references and fixed references.
         // Step 3 collects all instances if GC doesn't have collecting problems ;)
-        il2c_unregister_all_root_references_for_final_shutdown__(&g_pRootReferences__);
+        il2c_unregister_all_root_references_for_final_shutdown__(false);
         il2c_check_heap();
-        il2c_unregister_all_root_references_for_final_shutdown__(&g_pFixedReferences__);
+        il2c_unregister_all_root_references_for_final_shutdown__(true);
         il2c_check_heap();
 
         //////////////////////////////////////////////////
         // GC Step 3:
 
-        const uintptr_t remains = il2c_step3_sweep_garbage__();
+        il2c_step3_reserve_finalizers__();
+        il2c_check_heap();
+
+        //////////////////////////////////////////////////
+        // GC Step 4:
+
+        const uintptr_t remains = il2c_heap_sweep__(true, NULL);
         il2c_check_heap();
+
+        //////////////////////////////////////////////////
+        // GC Step 5:
+
+        il2c_invoke_finalizers__();
         if (remains == 0)
         {
             break;
@@ -667,6 +3043,21 @@ void il2c_collect_for_final_shutdown__(void)
     // Release monitor locks.
     il2c_release_all_monitor_lock_for_final_shutdown__();
 
+    if (g_ppFinalizerQueue__ != NULL)
+    {
+        il2c_free(g_ppFinalizerQueue__);
+        g_ppFinalizerQueue__ = NULL;
+        g_FinalizerQueueCapacity__ = 0;
+    }
+    if (g_ppFinalizables__ != NULL)
+    {
+        il2c_free(g_ppFinalizables__);
+        g_ppFinalizables__ = NULL;
+        g_FinalizableCount__ = 0;
+        g_FinalizableCapacity__ = 0;
+    }
+    il2c_destroy_monitor_lock__(&g_FinalizerLock__);
+
 #if defined(_DEBUG)
     il2c_runtime_debug_log_format(
         L"il2c_collect_for_final_shutdown__: finished: {0:u}",
@@ -676,6 +3067,180 @@ void il2c_collect_for_final_shutdown__(void)
         L"il2c_collect_for_final_shutdown__: finished");
 #endif
 
+    // Release GC lock.
+    il2c_exit_monitor_lock__(&g_GlobalLockForCollect__);
+
+    il2c_idec(&g_ExecutingCollection__);
+}
+
+/////////////////////////////////////////////////////////////
+// Heap walking
+
+static void il2c_walk_objref__(void* pReference)
+{
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(il2c_adjusted_reference(pReference));
+
+    // The const instances (ex: string literals) aren't placed on the heap.
+    if (il2c_unlikely__(pHeader->characteristic & IL2C_CHARACTERISTIC_CONST))
+    {
+        return;
+    }
+
+    const IL2C_HEAP_WALKER* pWalker = g_pHeapWalker__;
+    if (g_HeapWalkerRootKind__ != IL2C_HEAP_ROOT_NONE)
+    {
+        pWalker->pRoot(g_HeapWalkerRootKind__, pHeader, pWalker->pContext);
+    }
+    else
+    {
+        pWalker->pReference(pHeader, pWalker->pContext);
+    }
+}
+
+static void il2c_walk_slot__(void** ppReference)
+{
+    il2c_walk_objref__(*ppReference);
+}
+
+static void il2c_walk_instance__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    typedef void (*IL2C_MARK_HANDLER)(void* pReference);
+
+    ((void)pContext);
+
+    g_pHeapWalker__->pInstance(pHeader, g_pHeapWalker__->pContext);
+
+    if (pHeader->characteristic & IL2C_CHARACTERISTIC_POINTER_FREE)
+    {
+        return;
+    }
+
+    void* pReference = (void*)(pHeader + 1);
+    if (il2c_unlikely__((pHeader->type->flags & IL2C_TYPE_WITH_MARK_HANDLER) == IL2C_TYPE_WITH_MARK_HANDLER))
+    {
+        // The references are reported to il2c_default_mark_handler_for_objref__() while walking.
+        IL2C_MARK_HANDLER pMarkHandler = (IL2C_MARK_HANDLER)(pHeader->type->markTarget);
+        pMarkHandler(pReference);
+        return;
+    }
+
+    // The boxed value type shifts the offset for System_ValueType (same as il2c_trace_objref__.)
+    const uint8_t offset = (pHeader->type->flags & IL2C_TYPE_VALUE) ?
+        sizeof(System_ValueType) :
+        0;
+    il2c_visit_slots__(pReference, pHeader->type, offset, il2c_walk_slot__);
+}
+
+static void il2c_walk_root_references__(IL2C_ROOT_REFERENCES* pRootReferences, uint8_t rootKind)
+{
+    g_HeapWalkerRootKind__ = rootKind;
+
+    while (il2c_likely__(pRootReferences != NULL))
+    {
+        uint8_t index;
+        volatile System_Object* volatile* ppReference;
+        for (index = 0, ppReference = &pRootReferences->pReferences[0];
+            il2c_likely__(index < sizeof(pRootReferences->pReferences) / sizeof(void*));
+            index++, ppReference++)
+        {
+            if (*ppReference != NULL)
+            {
+                il2c_walk_objref__((void*)*ppReference);
+            }
+        }
+
+        pRootReferences = pRootReferences->pNext;
+    }
+}
+
+// Same roots as the marking (il2c_relocate_roots__ too.)
+static void il2c_walk_roots__(void)
+{
+    g_HeapWalkerRootKind__ = IL2C_HEAP_ROOT_STATIC_FIELD;
+    il2c_visit_tracking_information_slots__(g_pBeginStaticFields__, il2c_walk_slot__);
+
+    il2c_walk_root_references__(g_pRootReferences__, IL2C_HEAP_ROOT_ROOT_REFERENCE);
+    il2c_walk_root_references__(g_pFixedReferences__, IL2C_HEAP_ROOT_FIXED_REFERENCE);
+
+    // The execution frames and the caught exceptions at all threads.
+    // (They're reported as the references from the thread instance too.)
+    g_HeapWalkerRootKind__ = IL2C_HEAP_ROOT_EXECUTION_FRAME;
+    IL2C_ROOT_REFERENCES* pRootReferences = g_pRootReferences__;
+    while (il2c_likely__(pRootReferences != NULL))
+    {
+        uint8_t index;
+        volatile System_Object* volatile* ppReference;
+        for (index = 0, ppReference = &pRootReferences->pReferences[0];
+            il2c_likely__(index < sizeof(pRootReferences->pReferences) / sizeof(void*));
+            index++, ppReference++)
+        {
+            IL2C_RUNTIME_THREAD* pRuntimeThread = (IL2C_RUNTIME_THREAD*)*ppReference;
+            if (il2c_likely__(pRuntimeThread != NULL))
+            {
+                il2c_assert(pRuntimeThread->thread.vptr0__ == &System_Threading_Thread_VTABLE__);
+
+                il2c_visit_tracking_information_slots__(pRuntimeThread->context.pFrame, il2c_walk_slot__);
+
+                IL2C_EXCEPTION_FRAME* pUnwindTarget = pRuntimeThread->context.pUnwindTarget;
+                while (pUnwindTarget != NULL)
+                {
+                    if (pUnwindTarget->ex != NULL)
+                    {
+                        il2c_walk_objref__((void*)pUnwindTarget->ex);
+                    }
+                    pUnwindTarget = pUnwindTarget->pNext;
+                }
+            }
+        }
+
+        pRootReferences = pRootReferences->pNext;
+    }
+
+    g_HeapWalkerRootKind__ = IL2C_HEAP_ROOT_FINALIZER_QUEUE;
+    uintptr_t index;
+    for (index = g_FinalizerQueueHead__; index < g_FinalizerQueueCount__; index++)
+    {
+        il2c_walk_objref__((void*)g_ppFinalizerQueue__[index]);
+    }
+    if (g_pFinalizingReference__ != NULL)
+    {
+        il2c_walk_objref__((void*)g_pFinalizingReference__);
+    }
+
+    g_HeapWalkerRootKind__ = IL2C_HEAP_ROOT_NONE;
+}
+
+// Walks the roots and all instances while the mutators are stopped.
+// The walker doesn't collect: the instances allocated after the last collection may be unreachable,
+// so the consumer has to trace from the roots.
+void il2c_walk_heap__(const IL2C_HEAP_WALKER* pWalker)
+{
+    il2c_assert(pWalker != NULL);
+
+    // The collection requested while walking is skipped (same as reentrant.)
+    il2c_iinc(&g_ExecutingCollection__);
+
+    // Take GC locks.
+    il2c_enter_lock_for_collect__();
+#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+    il2c_enter_for_collect__();
+#endif
+    il2c_retire_allocation_contexts__();
+
+    // The garbage found by the last collection is freed before walking.
+    il2c_heap_finish_sweep__();
+
+    // The finalizer thread doesn't dequeue while walking.
+    il2c_enter_monitor_lock__(&g_FinalizerLock__);
+
+    g_pHeapWalker__ = pWalker;
+    il2c_walk_roots__();
+    il2c_heap_enumerate_marked__(il2c_walk_instance__, NULL);
+    il2c_heap_enumerate_unmarked__(true, il2c_walk_instance__, NULL);
+    g_pHeapWalker__ = NULL;
+
+    il2c_exit_monitor_lock__(&g_FinalizerLock__);
+
     // Release GC locks.
 #if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
     il2c_exit_for_collect__();
@@ -695,29 +3260,65 @@ void il2c_default_mark_handler_for_objref__(void* pReference)
     // It has to be invoked from inside for GC process.
     il2c_assert(g_ExecutingCollection__ >= 1);
 
-    System_Object * pAdjustedReference = il2c_adjusted_reference(pReference);
-    TRY_GET_HEADER(pHeader, pAdjustedReference)
+    // The custom mark handler reports while compacting.
+    if (il2c_unlikely__(g_CompactionAnchoring__))
     {
-        il2c_runtime_debug_log_format(
-            L"il2c_default_mark_handler_for_objref__ [1]: pReference=0x{0:p}, pAdjustedReference=0x{1:p}, type={2:s}, characteristic=0x{3:x}",
-            pReference,
-            pAdjustedReference,
-            pHeader->type->pTypeName,
-            pHeader->characteristic);
+        il2c_anchor_objref__(pReference);
+        return;
+    }
 
-        // Traverse recursively.
-        il2c_mark_handler_for_objref__(pAdjustedReference);
+    // The custom mark handler reports while walking the heap.
+    if (il2c_unlikely__(g_pHeapWalker__ != NULL))
+    {
+        il2c_walk_objref__(pReference);
+        return;
     }
-    else
+
+    il2c_mark_reference__(il2c_get_current_mark_worker__(), pReference);
+}
+
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+// Marks the initialized instances pointed from the words in [pBegin, pEnd) (includes the interior pointers.)
+static void il2c_mark_conservative_range__(const void* pBegin, const void* pEnd)
+{
+    const uintptr_t* p = (const uintptr_t*)
+        (((uintptr_t)pBegin + sizeof(uintptr_t) - 1U) & ~(uintptr_t)(sizeof(uintptr_t) - 1U));
+    for (; il2c_likely__((p + 1) <= (const uintptr_t*)pEnd); p++)
     {
-        il2c_runtime_debug_log_format(
-            L"il2c_default_mark_handler_for_objref__ [2]: pReference=0x{0:p}, pAdjustedReference=0x{1:p}, type={2:s}, characteristic=0x{3:x}",
-            pReference,
-            pAdjustedReference,
-            pHeader->type->pTypeName,
-            pHeader->characteristic);
+        IL2C_REF_HEADER* pHeader = il2c_heap_find_object__((void*)*p);
+        if (il2c_unlikely__((pHeader != NULL) &&
+            (pHeader->characteristic & IL2C_CHARACTERISTIC_INITIALIZED)))
+        {
+            il2c_default_mark_handler_for_objref__((System_Object*)(pHeader + 1));
+        }
+    }
+}
+
+void il2c_mark_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+
+    // It has to be invoked from inside for GC process.
+    il2c_assert(g_ExecutingCollection__ >= 1);
+
+    // The thread isn't started or has exited.
+    //   (Otherwise it's stopped at PARKED or SAFE, or it's the collecting thread.)
+    if (il2c_unlikely__((pThreadContext->pStackBase == NULL) || (pThreadContext->pStackPointer == NULL)))
+    {
+        return;
     }
+
+    il2c_runtime_debug_log_format(
+        L"il2c_mark_native_stack__: pThreadContext=0x{0:p}, pStackPointer=0x{1:p}, pStackBase=0x{2:p}",
+        pThreadContext,
+        pThreadContext->pStackPointer,
+        pThreadContext->pStackBase);
+
+    il2c_mark_conservative_range__(pThreadContext->pStackPointer, pThreadContext->pStackBase);
+    il2c_mark_conservative_range__(
+        (const void*)&pThreadContext->savedRegisters, (const void*)(&pThreadContext->savedRegisters + 1));
 }
+#endif
 
 void il2c_default_mark_handler_for_value_type__(void* pValue, IL2C_RUNTIME_TYPE valueType)
 {
@@ -728,8 +3329,20 @@ void il2c_default_mark_handler_for_value_type__(void* pValue, IL2C_RUNTIME_TYPE
     // It has to be invoked from inside for GC process.
     il2c_assert(g_ExecutingCollection__ >= 1);
 
+    // The custom mark handler reports while compacting.
+    if (il2c_unlikely__(g_CompactionAnchoring__))
+    {
+        il2c_visit_slots__(pValue, valueType, 0, il2c_anchor_slot__);
+        return;
+    }
+    if (il2c_unlikely__(g_pHeapWalker__ != NULL))
+    {
+        il2c_visit_slots__(pValue, valueType, 0, il2c_walk_slot__);
+        return;
+    }
+
     // Traverse recursively.
-    il2c_mark_handler_recursive__(pValue, valueType, 0);
+    il2c_mark_handler_recursive__(il2c_get_current_mark_worker__(), pValue, valueType, 0);
 }
 
 void il2c_default_mark_handler_for_tracking_information__(IL2C_GC_TRACKING_INFORMATION* pTrackingInformation)
@@ -739,6 +3352,17 @@ void il2c_default_mark_handler_for_tracking_information__(IL2C_GC_TRACKING_INFOR
     // It has to be invoked from inside for GC process.
     il2c_assert(g_ExecutingCollection__ >= 1);
 
+    // The execution frames are updated by the compaction (il2c_relocate_roots__.)
+    if (il2c_unlikely__(g_CompactionAnchoring__))
+    {
+        return;
+    }
+    if (il2c_unlikely__(g_pHeapWalker__ != NULL))
+    {
+        il2c_visit_tracking_information_slots__(pTrackingInformation, il2c_walk_slot__);
+        return;
+    }
+
     // Traverse recursively.
-    il2c_step2_mark_gcmark__(pTrackingInformation);
+    il2c_step2_mark_gcmark__(il2c_get_current_mark_worker__(), pTrackingInformation);
 }
@@ -0,0 +1,1724 @@
+#include <il2c_private.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//   Segment (IL2C_HEAP_SEGMENT_BLOCKS * IL2C_HEAP_BLOCK_SIZE)
+// +-----------------------+-----------------------+-----------------------+----
+// | Block (size class 0)  | Block (size class 3)  | Block (free)          | ...
+// +-----------------------+-----------------------+-----------------------+----
+//
+//   Block (IL2C_HEAP_BLOCK_SIZE, aligned)
+// +-----------------------+ <-- IL2C_HEAP_BLOCK
+// | Block header          |
+// +-----------------------+ <-- il2c_heap_cells_of_block__()
+// | Cell 0                |     IL2C_REF_HEADER + instance body (type == NULL if free)
+// +-----------------------+
+// | Cell 1                |
+// +-----------------------+
+// |          :            |
+// +-----------------------+ <-- pBump (cells never allocated are placed after here)
+// |          :            |
+// +-----------------------+ <-- pLimit
+//
+// The pointer-free instances (strings, primitive arrays and boxed primitives) are allocated
+// by the separated size classes, and the marker never scans them.
+//
+// The large instances (larger than IL2C_HEAP_MAX_SMALL_SIZE) are placed on the large object space,
+// each instance owns the pages directly mapped by the platform (IL2C_USE_PAGE_ALLOCATOR.)
+// These pages are zero-filled when mapped and returned to the OS just after swept.
+//
+// Trimming: The free blocks unused for the delay are decommitted after the collection (IL2C_USE_PAGE_DECOMMIT),
+// they stay in the segment and are committed again when the allocator takes them.
+// The segment is returned to the OS when all blocks are trimmed.
+
+#define IL2C_HEAP_GRANULE 8U
+
+// The count of the blocks swept by the allocator at refilling.
+#if !defined(IL2C_HEAP_LAZY_SWEEP_BLOCKS)
+#define IL2C_HEAP_LAZY_SWEEP_BLOCKS 2U
+#endif
+
+typedef struct IL2C_HEAP_SIZE_CLASS_DECL
+{
+    IL2C_MONITOR_LOCK lock;
+    IL2C_HEAP_BLOCK* pAvailable;    // Blocks contain free cells (allocate from the head)
+    IL2C_HEAP_BLOCK* pFull;         // Exhausted blocks
+    IL2C_HEAP_BLOCK* pUnswept;      // Blocks waiting for the lazy sweeping
+    uint32_t cellSize;
+} IL2C_HEAP_SIZE_CLASS;
+
+typedef struct IL2C_HEAP_SEGMENT_DECL IL2C_HEAP_SEGMENT;
+
+struct IL2C_HEAP_SEGMENT_DECL
+{
+    IL2C_HEAP_SEGMENT* pNext;
+    void* pRaw;
+    uint8_t* pBegin;
+    uint8_t* pEnd;
+    uint32_t trimmedBlocks;
+    uint8_t trimmed[IL2C_HEAP_SEGMENT_BLOCKS];  // The block is trimmed (not in the free blocks, may be decommitted)
+};
+
+#define IL2C_HEAP_SEGMENT_RAW_SIZE (IL2C_HEAP_SEGMENT_BLOCKS * IL2C_HEAP_BLOCK_SIZE + IL2C_HEAP_BLOCK_SIZE - 1U)
+
+// The address range of a segment or a large instance.
+typedef struct IL2C_HEAP_RANGE_DECL
+{
+    uint8_t* pBegin;
+    uint8_t* pEnd;
+    void* pOwner;       // IL2C_HEAP_SEGMENT* or IL2C_HEAP_LARGE_OBJECT*
+} IL2C_HEAP_RANGE;
+
+// The ranges sorted by the address, il2c_heap_find_object__() looks up by the binary search.
+typedef struct IL2C_HEAP_RANGE_INDEX_DECL
+{
+    IL2C_HEAP_RANGE* pRanges;
+    uint32_t count;
+    uint32_t capacity;
+} IL2C_HEAP_RANGE_INDEX;
+
+#if defined(IL2C_USE_MONOTONIC_CLOCK)
+#define il2c_heap_get_milliseconds__() (il2c_get_monotonic_microseconds__() / 1000U)
+#else
+#define il2c_heap_get_milliseconds__() ((uint64_t)0)
+#endif
+
+extern void il2c_release_monitor_lock_from_objref__(IL2C_REF_HEADER* pHeader);
+
+static IL2C_HEAP_SIZE_CLASS g_SizeClasses__[IL2C_HEAP_MAX_SIZE_CLASSES];
+static uint32_t g_SizeClassCount__ = 0;
+// The size classes from here are the pointer-free space.
+static uint32_t g_PointerFreeSizeClass__ = 0;
+static uint8_t g_SizeClassIndices__[IL2C_HEAP_MAX_SMALL_SIZE / IL2C_HEAP_GRANULE + 1];
+
+// Segments, free blocks and the large object space are guarded by it.
+static IL2C_MONITOR_LOCK g_HeapLock__;
+static IL2C_HEAP_SEGMENT* g_pSegments__ = NULL;
+static IL2C_HEAP_BLOCK* g_pFreeBlocks__ = NULL;
+static IL2C_HEAP_LARGE_OBJECT* g_pLargeObjects__ = NULL;
+static IL2C_HEAP_RANGE_INDEX g_SegmentIndex__ = { NULL, 0, 0 };
+static IL2C_HEAP_RANGE_INDEX g_LargeObjectIndex__ = { NULL, 0, 0 };
+
+// Committed vs used accounting, guarded by g_HeapLock__.
+static uintptr_t g_SegmentBlocks__ = 0;
+static uintptr_t g_FreeBlockCount__ = 0;
+static uintptr_t g_TrimmedBlocks__ = 0;
+static uintptr_t g_LargeObjectBytes__ = 0;
+
+#if defined(IL2C_USE_PAGE_DECOMMIT)
+#define il2c_heap_committed_blocks__() (g_SegmentBlocks__ - g_TrimmedBlocks__)
+#else
+// The trimmed blocks aren't returned to the OS until the segment is released.
+#define il2c_heap_committed_blocks__() (g_SegmentBlocks__)
+#endif
+
+// Lazy sweeping: The count of unswept blocks and the surviving/freed amounts, guarded by g_HeapLock__.
+static volatile uintptr_t g_UnsweptBlocks__ = 0;
+static uintptr_t g_SweptLiveBytes__ = 0;
+static uintptr_t g_SweptLiveObjects__ = 0;
+static uintptr_t g_SweptFreedBytes__ = 0;
+static uint32_t g_SweepCursor__ = 0;
+// The sweeper thread sweeps instead of the allocator's bounded chunks.
+static bool g_BackgroundSweeping__ = false;
+
+// The address range covers all segments and large objects (for the write barrier filter.)
+uint8_t* g_pHeapLowerBound__ = (uint8_t*)UINTPTR_MAX;
+uint8_t* g_pHeapUpperBound__ = NULL;
+
+/////////////////////////////////////////////////////////////
+// Heap initializer / shutdown
+
+static void il2c_heap_add_size_class__(uint32_t cellSize)
+{
+    il2c_assert(g_SizeClassCount__ < IL2C_HEAP_MAX_SIZE_CLASSES);
+    il2c_assert((cellSize % IL2C_HEAP_GRANULE) == 0);
+
+    IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[g_SizeClassCount__];
+    il2c_initialize_monitor_lock__(&pSizeClass->lock);
+    pSizeClass->pAvailable = NULL;
+    pSizeClass->pFull = NULL;
+    pSizeClass->pUnswept = NULL;
+    pSizeClass->cellSize = cellSize;
+
+    g_SizeClassCount__++;
+}
+
+void il2c_heap_initialize__(void)
+{
+    il2c_initialize_monitor_lock__(&g_HeapLock__);
+    g_pSegments__ = NULL;
+    g_pFreeBlocks__ = NULL;
+    g_pLargeObjects__ = NULL;
+    g_SegmentIndex__.count = 0;
+    g_LargeObjectIndex__.count = 0;
+    g_SegmentBlocks__ = 0;
+    g_FreeBlockCount__ = 0;
+    g_TrimmedBlocks__ = 0;
+    g_LargeObjectBytes__ = 0;
+    g_pHeapLowerBound__ = (uint8_t*)UINTPTR_MAX;
+    g_pHeapUpperBound__ = NULL;
+    g_UnsweptBlocks__ = 0;
+    g_SweptLiveBytes__ = 0;
+    g_SweptLiveObjects__ = 0;
+    g_SweptFreedBytes__ = 0;
+    g_SweepCursor__ = 0;
+    g_BackgroundSweeping__ = false;
+
+    // Size classes: 16, 24, ... 64 (step 8), and 4 classes per power of two (80, 96, 112, 128, 160 ...)
+    g_SizeClassCount__ = 0;
+    uint32_t cellSize;
+    for (cellSize = 16U; cellSize <= 64U; cellSize += IL2C_HEAP_GRANULE)
+    {
+        il2c_heap_add_size_class__(cellSize);
+    }
+    uint32_t base;
+    for (base = 64U; base < IL2C_HEAP_MAX_SMALL_SIZE; base *= 2U)
+    {
+        uint32_t step;
+        for (step = 1U; step <= 4U; step++)
+        {
+            il2c_heap_add_size_class__(base + base / 4U * step);
+        }
+    }
+
+    // Build the size to class lookup table.
+    uint32_t sizeClass = 0;
+    uint32_t index;
+    for (index = 0; index < sizeof(g_SizeClassIndices__); index++)
+    {
+        while (index * IL2C_HEAP_GRANULE > g_SizeClasses__[sizeClass].cellSize)
+        {
+            sizeClass++;
+        }
+        g_SizeClassIndices__[index] = (uint8_t)sizeClass;
+    }
+
+    // Same size classes for the pointer-free space.
+    g_PointerFreeSizeClass__ = g_SizeClassCount__;
+    for (sizeClass = 0; sizeClass < g_PointerFreeSizeClass__; sizeClass++)
+    {
+        il2c_heap_add_size_class__(g_SizeClasses__[sizeClass].cellSize);
+    }
+}
+
+/////////////////////////////////////////////////////////////
+// Range index
+
+// Inserts the range with keeping the address order. The caller has to hold the heap lock.
+static bool il2c_heap_range_index_insert__(
+    IL2C_HEAP_RANGE_INDEX* pIndex, uint8_t* pBegin, uint8_t* pEnd, void* pOwner)
+{
+    if (il2c_unlikely__(pIndex->count >= pIndex->capacity))
+    {
+        const uint32_t capacity = (pIndex->capacity >= 1) ? (pIndex->capacity * 2) : 16;
+#if defined(IL2C_USE_LINE_INFORMATION)
+        IL2C_HEAP_RANGE* pRanges = il2c_malloc(capacity * sizeof(IL2C_HEAP_RANGE), __FILE__, __LINE__);
+#else
+        IL2C_HEAP_RANGE* pRanges = il2c_malloc(capacity * sizeof(IL2C_HEAP_RANGE));
+#endif
+        if (il2c_unlikely__(pRanges == NULL))
+        {
+            return false;
+        }
+
+        if (pIndex->pRanges != NULL)
+        {
+            memcpy(pRanges, pIndex->pRanges, pIndex->count * sizeof(IL2C_HEAP_RANGE));
+            il2c_free(pIndex->pRanges);
+        }
+        pIndex->pRanges = pRanges;
+        pIndex->capacity = capacity;
+    }
+
+    // The newer range is usually placed at the higher address.
+    uint32_t index = pIndex->count;
+    while ((index >= 1) && (pIndex->pRanges[index - 1].pBegin > pBegin))
+    {
+        pIndex->pRanges[index] = pIndex->pRanges[index - 1];
+        index--;
+    }
+
+    pIndex->pRanges[index].pBegin = pBegin;
+    pIndex->pRanges[index].pEnd = pEnd;
+    pIndex->pRanges[index].pOwner = pOwner;
+    pIndex->count++;
+    return true;
+}
+
+// Finds the range contains the address. The caller has to hold the heap lock or be inside for GC process.
+static IL2C_HEAP_RANGE* il2c_heap_range_index_find__(IL2C_HEAP_RANGE_INDEX* pIndex, uint8_t* p)
+{
+    // Find the last range begins at or below the address.
+    uint32_t lower = 0;
+    uint32_t upper = pIndex->count;
+    while (lower < upper)
+    {
+        const uint32_t middle = lower + (upper - lower) / 2;
+        if (pIndex->pRanges[middle].pBegin <= p)
+        {
+            lower = middle + 1;
+        }
+        else
+        {
+            upper = middle;
+        }
+    }
+
+    if (lower == 0)
+    {
+        return NULL;
+    }
+
+    IL2C_HEAP_RANGE* pRange = &pIndex->pRanges[lower - 1];
+    return (p < pRange->pEnd) ? pRange : NULL;
+}
+
+static void il2c_heap_range_index_free__(IL2C_HEAP_RANGE_INDEX* pIndex)
+{
+    if (pIndex->pRanges != NULL)
+    {
+        il2c_free(pIndex->pRanges);
+    }
+    pIndex->pRanges = NULL;
+    pIndex->count = 0;
+    pIndex->capacity = 0;
+}
+
+static void il2c_heap_free_large__(IL2C_HEAP_LARGE_OBJECT* pLargeObject)
+{
+#if defined(IL2C_USE_PAGE_ALLOCATOR)
+    il2c_page_free__(pLargeObject, sizeof(IL2C_HEAP_LARGE_OBJECT) + pLargeObject->size);
+#else
+    il2c_free(pLargeObject);
+#endif
+}
+
+static void il2c_heap_free_segment__(IL2C_HEAP_SEGMENT* pSegment)
+{
+#if defined(IL2C_USE_PAGE_ALLOCATOR)
+    il2c_page_free__(pSegment->pRaw, IL2C_HEAP_SEGMENT_RAW_SIZE);
+#else
+    il2c_free(pSegment->pRaw);
+#endif
+    il2c_free(pSegment);
+}
+
+void il2c_heap_shutdown__(void)
+{
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    while (g_pLargeObjects__ != NULL)
+    {
+        IL2C_HEAP_LARGE_OBJECT* pNext = g_pLargeObjects__->pNext;
+        il2c_heap_free_large__(g_pLargeObjects__);
+        g_pLargeObjects__ = pNext;
+    }
+
+    while (g_pSegments__ != NULL)
+    {
+        IL2C_HEAP_SEGMENT* pNext = g_pSegments__->pNext;
+        il2c_heap_free_segment__(g_pSegments__);
+        g_pSegments__ = pNext;
+    }
+
+    il2c_heap_range_index_free__(&g_SegmentIndex__);
+    il2c_heap_range_index_free__(&g_LargeObjectIndex__);
+
+    g_pFreeBlocks__ = NULL;
+    g_SegmentBlocks__ = 0;
+    g_FreeBlockCount__ = 0;
+    g_TrimmedBlocks__ = 0;
+    g_LargeObjectBytes__ = 0;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    uint32_t index;
+    for (index = 0; index < g_SizeClassCount__; index++)
+    {
+        g_SizeClasses__[index].pAvailable = NULL;
+        g_SizeClasses__[index].pFull = NULL;
+        g_SizeClasses__[index].pUnswept = NULL;
+        il2c_destroy_monitor_lock__(&g_SizeClasses__[index].lock);
+    }
+    g_SizeClassCount__ = 0;
+    g_PointerFreeSizeClass__ = 0;
+
+    il2c_destroy_monitor_lock__(&g_HeapLock__);
+}
+
+/////////////////////////////////////////////////////////////
+// Block manipulators
+
+static void il2c_heap_extend_bounds__(uint8_t* pBegin, uint8_t* pEnd)
+{
+    if (pBegin < g_pHeapLowerBound__)
+    {
+        g_pHeapLowerBound__ = pBegin;
+    }
+    if (pEnd > g_pHeapUpperBound__)
+    {
+        g_pHeapUpperBound__ = pEnd;
+    }
+}
+
+static void il2c_heap_reset_block__(IL2C_HEAP_BLOCK* pBlock, uint32_t sizeClass)
+{
+    const uint32_t cellSize = g_SizeClasses__[sizeClass].cellSize;
+    uint8_t* pCells = il2c_heap_cells_of_block__(pBlock);
+
+    pBlock->pNext = NULL;
+    pBlock->pFreeList = NULL;
+    pBlock->pBump = pCells;
+    pBlock->pLimit = pCells +
+        ((IL2C_HEAP_BLOCK_SIZE - IL2C_HEAP_BLOCK_HEADER_SIZE) / cellSize) * cellSize;
+    pBlock->cellSize = cellSize;
+    pBlock->sizeClass = sizeClass;
+    pBlock->liveCells = 0;
+    pBlock->young = 1;
+    pBlock->anchored = 0;
+    pBlock->evacuating = 0;
+    memset((void*)pBlock->markBits, 0, sizeof pBlock->markBits);
+}
+
+// Takes back the trimmed block. The caller has to hold the heap lock.
+static IL2C_HEAP_BLOCK* il2c_heap_take_trimmed_block__(void)
+{
+    IL2C_HEAP_SEGMENT* pSegment = g_pSegments__;
+    while (pSegment->trimmedBlocks == 0)
+    {
+        pSegment = pSegment->pNext;
+    }
+
+    uint32_t index = 0;
+    while (!pSegment->trimmed[index])
+    {
+        index++;
+    }
+
+    IL2C_HEAP_BLOCK* pBlock = (IL2C_HEAP_BLOCK*)(pSegment->pBegin + index * IL2C_HEAP_BLOCK_SIZE);
+#if defined(IL2C_USE_PAGE_DECOMMIT)
+    if (il2c_unlikely__(!il2c_page_commit__((void*)pBlock, IL2C_HEAP_BLOCK_SIZE)))
+    {
+        return NULL;
+    }
+#endif
+
+    // The decommitted header is cleared.
+    pBlock->pSegment = pSegment;
+    pSegment->trimmed[index] = 0;
+    pSegment->trimmedBlocks--;
+    g_TrimmedBlocks__--;
+    return pBlock;
+}
+
+// Allocates new segment with block alignment. The caller has to hold the heap lock.
+static bool il2c_heap_add_segment__(void)
+{
+#if defined(IL2C_USE_PAGE_ALLOCATOR)
+    void* pRaw = il2c_page_allocate__(IL2C_HEAP_SEGMENT_RAW_SIZE);
+#elif defined(IL2C_USE_LINE_INFORMATION)
+    void* pRaw = il2c_malloc(IL2C_HEAP_SEGMENT_RAW_SIZE, __FILE__, __LINE__);
+#else
+    void* pRaw = il2c_malloc(IL2C_HEAP_SEGMENT_RAW_SIZE);
+#endif
+    if (il2c_unlikely__(pRaw == NULL))
+    {
+        return false;
+    }
+#if defined(IL2C_USE_LINE_INFORMATION)
+    IL2C_HEAP_SEGMENT* pSegment = il2c_malloc(sizeof(IL2C_HEAP_SEGMENT), __FILE__, __LINE__);
+#else
+    IL2C_HEAP_SEGMENT* pSegment = il2c_malloc(sizeof(IL2C_HEAP_SEGMENT));
+#endif
+    if (il2c_unlikely__(pSegment == NULL))
+    {
+#if defined(IL2C_USE_PAGE_ALLOCATOR)
+        il2c_page_free__(pRaw, IL2C_HEAP_SEGMENT_RAW_SIZE);
+#else
+        il2c_free(pRaw);
+#endif
+        return false;
+    }
+
+    memset(pSegment, 0, sizeof(IL2C_HEAP_SEGMENT));
+    pSegment->pRaw = pRaw;
+    pSegment->pBegin = (uint8_t*)
+        (((uintptr_t)pRaw + IL2C_HEAP_BLOCK_SIZE - 1U) & ~(IL2C_HEAP_BLOCK_SIZE - 1U));
+    pSegment->pEnd = pSegment->pBegin + IL2C_HEAP_SEGMENT_BLOCKS * IL2C_HEAP_BLOCK_SIZE;
+    if (il2c_unlikely__(!il2c_heap_range_index_insert__(
+        &g_SegmentIndex__, pSegment->pBegin, pSegment->pEnd, pSegment)))
+    {
+        il2c_heap_free_segment__(pSegment);
+        return false;
+    }
+
+    pSegment->pNext = g_pSegments__;
+    g_pSegments__ = pSegment;
+    il2c_heap_extend_bounds__(pSegment->pBegin, pSegment->pEnd);
+
+    // Split to the free blocks.
+    const uint64_t now = il2c_heap_get_milliseconds__();
+    uint8_t* p;
+    for (p = pSegment->pEnd - IL2C_HEAP_BLOCK_SIZE;
+        p >= pSegment->pBegin;
+        p -= IL2C_HEAP_BLOCK_SIZE)
+    {
+        IL2C_HEAP_BLOCK* pFreeBlock = (IL2C_HEAP_BLOCK*)p;
+        pFreeBlock->cellSize = 0;
+        pFreeBlock->releasedAt = now;
+        pFreeBlock->pSegment = pSegment;
+        pFreeBlock->pNext = g_pFreeBlocks__;
+        g_pFreeBlocks__ = pFreeBlock;
+    }
+
+    g_SegmentBlocks__ += IL2C_HEAP_SEGMENT_BLOCKS;
+    g_FreeBlockCount__ += IL2C_HEAP_SEGMENT_BLOCKS;
+    return true;
+}
+
+static IL2C_HEAP_BLOCK* il2c_heap_take_free_block__(uint32_t sizeClass)
+{
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    IL2C_HEAP_BLOCK* pBlock = g_pFreeBlocks__;
+    if (il2c_likely__(pBlock != NULL))
+    {
+        g_pFreeBlocks__ = pBlock->pNext;
+        g_FreeBlockCount__--;
+    }
+    else if (g_TrimmedBlocks__ >= 1)
+    {
+        pBlock = il2c_heap_take_trimmed_block__();
+    }
+    else if (il2c_likely__(il2c_heap_add_segment__()))
+    {
+        pBlock = g_pFreeBlocks__;
+        g_pFreeBlocks__ = pBlock->pNext;
+        g_FreeBlockCount__--;
+    }
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    if (il2c_unlikely__(pBlock == NULL))
+    {
+        return NULL;
+    }
+
+    il2c_heap_reset_block__(pBlock, sizeClass);
+    return pBlock;
+}
+
+static void il2c_heap_release_block__(IL2C_HEAP_BLOCK* pBlock)
+{
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    // The free block doesn't contain any cells.
+    pBlock->cellSize = 0;
+    pBlock->releasedAt = il2c_heap_get_milliseconds__();
+    pBlock->pNext = g_pFreeBlocks__;
+    g_pFreeBlocks__ = pBlock;
+    g_FreeBlockCount__++;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+}
+
+/////////////////////////////////////////////////////////////
+// Allocator
+
+static IL2C_REF_HEADER* il2c_heap_allocate_large__(IL2C_RUNTIME_TYPE type, uintptr_t size, bool pointerFree)
+{
+    const uintptr_t totalSize = sizeof(IL2C_HEAP_LARGE_OBJECT) + size;
+#if defined(IL2C_USE_PAGE_ALLOCATOR)
+    IL2C_HEAP_LARGE_OBJECT* pLargeObject = il2c_page_allocate__(totalSize);
+#elif defined(IL2C_USE_LINE_INFORMATION)
+    IL2C_HEAP_LARGE_OBJECT* pLargeObject = il2c_malloc(totalSize, __FILE__, __LINE__);
+#else
+    IL2C_HEAP_LARGE_OBJECT* pLargeObject = il2c_malloc(totalSize);
+#endif
+    if (il2c_unlikely__(pLargeObject == NULL))
+    {
+        return NULL;
+    }
+
+    pLargeObject->size = size;
+    pLargeObject->pPrev = NULL;
+
+    IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)(pLargeObject + 1);
+    pHeader->type = type;
+    pHeader->characteristic = pointerFree ?
+        (IL2C_CHARACTERISTIC_LARGE_OBJECT | IL2C_CHARACTERISTIC_POINTER_FREE) :
+        IL2C_CHARACTERISTIC_LARGE_OBJECT;
+    pLargeObject->marked = 0;
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    if (il2c_unlikely__(!il2c_heap_range_index_insert__(
+        &g_LargeObjectIndex__, (uint8_t*)pHeader, ((uint8_t*)pHeader) + size, pLargeObject)))
+    {
+        il2c_exit_monitor_lock__(&g_HeapLock__);
+        il2c_heap_free_large__(pLargeObject);
+        return NULL;
+    }
+
+    il2c_heap_extend_bounds__((uint8_t*)pHeader, ((uint8_t*)pHeader) + size);
+    g_LargeObjectBytes__ += totalSize;
+
+    pLargeObject->pNext = g_pLargeObjects__;
+    if (g_pLargeObjects__ != NULL)
+    {
+        g_pLargeObjects__->pPrev = pLargeObject;
+    }
+    g_pLargeObjects__ = pLargeObject;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    return pHeader;
+}
+
+static bool il2c_heap_sweep_unswept_block__(IL2C_HEAP_SIZE_CLASS* pSizeClass);
+
+static IL2C_HEAP_BLOCK* il2c_heap_refill_allocation_context__(
+    IL2C_HEAP_ALLOCATION_CONTEXT* pAllocationContext, IL2C_HEAP_SIZE_CLASS* pSizeClass, uint32_t sizeClass)
+{
+    il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+    // Give back the exhausted block.
+    IL2C_HEAP_BLOCK* pBlock = pAllocationContext->pBlocks[sizeClass];
+    if (pBlock != NULL)
+    {
+        pBlock->pNext = pSizeClass->pFull;
+        pSizeClass->pFull = pBlock;
+    }
+
+    // Own the available block, the unswept blocks are swept on demand.
+    pBlock = pSizeClass->pAvailable;
+    while (il2c_unlikely__(pBlock == NULL) && il2c_heap_sweep_unswept_block__(pSizeClass))
+    {
+        pBlock = pSizeClass->pAvailable;
+    }
+    if (il2c_likely__(pBlock != NULL))
+    {
+        pSizeClass->pAvailable = pBlock->pNext;
+        pBlock->pNext = NULL;
+        pBlock->young = 1;
+    }
+    else
+    {
+        pBlock = il2c_heap_take_free_block__(sizeClass);
+    }
+
+    pAllocationContext->pBlocks[sizeClass] = pBlock;
+
+    il2c_exit_monitor_lock__(&pSizeClass->lock);
+
+    return pBlock;
+}
+
+static IL2C_REF_HEADER* il2c_heap_allocate_from_block__(IL2C_HEAP_BLOCK* pBlock)
+{
+    // Swept free cell.
+    IL2C_REF_HEADER* pHeader = pBlock->pFreeList;
+    if (il2c_likely__(pHeader != NULL))
+    {
+        pBlock->pFreeList = *(IL2C_REF_HEADER**)(pHeader + 1);
+        return pHeader;
+    }
+
+    // Never allocated cell.
+    if (il2c_likely__(pBlock->pBump < pBlock->pLimit))
+    {
+        pHeader = (IL2C_REF_HEADER*)pBlock->pBump;
+        pBlock->pBump += pBlock->cellSize;
+        return pHeader;
+    }
+
+    return NULL;
+}
+
+// Allocates a cell and sets the header (not initialized and not marked.)
+// The instance body isn't cleared. Returns NULL if the heap is exhausted.
+// If pAllocationContext is given, the caller has to be the RUNNING thread owning it.
+// If pointerFree is true, the instance doesn't contain any objrefs and the marker doesn't scan it.
+IL2C_REF_HEADER* il2c_heap_allocate__(
+    IL2C_HEAP_ALLOCATION_CONTEXT* pAllocationContext, IL2C_RUNTIME_TYPE type, uintptr_t size, bool pointerFree)
+{
+    il2c_assert(type != NULL);
+    il2c_assert(size >= sizeof(IL2C_REF_HEADER) + sizeof(void*));
+
+    if (il2c_unlikely__(size > IL2C_HEAP_MAX_SMALL_SIZE))
+    {
+        return il2c_heap_allocate_large__(type, size, pointerFree);
+    }
+
+    const uint32_t sizeClass =
+        g_SizeClassIndices__[(size + IL2C_HEAP_GRANULE - 1U) / IL2C_HEAP_GRANULE] +
+        (pointerFree ? g_PointerFreeSizeClass__ : 0U);
+    const interlock_t characteristic = pointerFree ? IL2C_CHARACTERISTIC_POINTER_FREE : 0;
+    IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+    il2c_assert(pSizeClass->cellSize >= size);
+
+    IL2C_REF_HEADER* pHeader;
+
+    // Fast path: the thread local allocation buffer.
+    if (il2c_likely__(pAllocationContext != NULL))
+    {
+        IL2C_HEAP_BLOCK* pBlock = pAllocationContext->pBlocks[sizeClass];
+        while (1)
+        {
+            if (il2c_likely__(pBlock != NULL))
+            {
+                pHeader = il2c_heap_allocate_from_block__(pBlock);
+                if (il2c_likely__(pHeader != NULL))
+                {
+                    break;
+                }
+            }
+
+            // Slow path: refill from the shared heap, and spread the sweeping cost.
+            if (il2c_unlikely__(g_UnsweptBlocks__ >= 1) && !g_BackgroundSweeping__)
+            {
+                il2c_heap_sweep_pending__(IL2C_HEAP_LAZY_SWEEP_BLOCKS);
+            }
+            pBlock = il2c_heap_refill_allocation_context__(pAllocationContext, pSizeClass, sizeClass);
+            if (il2c_unlikely__(pBlock == NULL))
+            {
+                return NULL;
+            }
+        }
+
+        // The GC can't sweep this block because it's owned by the thread (and RUNNING.)
+        // The new instance is young generation (NOT MARKED: the sweeper frees only unmarked cells) and NOT INITIALIZED.
+        pHeader->type = type;
+        pHeader->characteristic = characteristic;
+
+        return pHeader;
+    }
+
+    // Shared path: the thread context isn't attached yet.
+    il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+    while (1)
+    {
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        if (il2c_unlikely__(pBlock == NULL) && il2c_heap_sweep_unswept_block__(pSizeClass))
+        {
+            continue;
+        }
+        if (il2c_unlikely__(pBlock == NULL))
+        {
+            pBlock = il2c_heap_take_free_block__(sizeClass);
+            if (il2c_unlikely__(pBlock == NULL))
+            {
+                il2c_exit_monitor_lock__(&pSizeClass->lock);
+                return NULL;
+            }
+            pSizeClass->pAvailable = pBlock;
+        }
+
+        pHeader = il2c_heap_allocate_from_block__(pBlock);
+        if (il2c_likely__(pHeader != NULL))
+        {
+            pBlock->young = 1;
+            break;
+        }
+
+        // This block is exhausted.
+        pSizeClass->pAvailable = pBlock->pNext;
+        pBlock->pNext = pSizeClass->pFull;
+        pSizeClass->pFull = pBlock;
+    }
+
+    // The header has to be set inside the lock, because the sweeper treats the cell free if type is NULL.
+    // The new instance is young generation (NOT MARKED: the sweeper frees only unmarked cells) and NOT INITIALIZED.
+    pHeader->type = type;
+    pHeader->characteristic = characteristic;
+
+    il2c_exit_monitor_lock__(&pSizeClass->lock);
+
+    return pHeader;
+}
+
+// Gives back the thread owned blocks to the shared heap.
+// It's called from GC (all mutators are stopped) and exiting thread.
+void il2c_heap_retire_allocation_context__(IL2C_HEAP_ALLOCATION_CONTEXT* pAllocationContext)
+{
+    il2c_assert(pAllocationContext != NULL);
+
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_BLOCK* pBlock = pAllocationContext->pBlocks[sizeClass];
+        if (il2c_likely__(pBlock == NULL))
+        {
+            continue;
+        }
+
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        if ((pBlock->pFreeList != NULL) || (pBlock->pBump < pBlock->pLimit))
+        {
+            pBlock->pNext = pSizeClass->pAvailable;
+            pSizeClass->pAvailable = pBlock;
+        }
+        else
+        {
+            pBlock->pNext = pSizeClass->pFull;
+            pSizeClass->pFull = pBlock;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+
+        pAllocationContext->pBlocks[sizeClass] = NULL;
+    }
+}
+
+/////////////////////////////////////////////////////////////
+// Enumerator
+
+#define IL2C_HEAP_IS_GARBAGE(pHeader) \
+    (((pHeader)->characteristic & IL2C_CHARACTERISTIC_INITIALIZED) && !il2c_is_marked__(pHeader))
+#define IL2C_HEAP_IS_ENUMERATING(pHeader, marked) \
+    (((pHeader)->characteristic & IL2C_CHARACTERISTIC_INITIALIZED) && ((il2c_is_marked__(pHeader) != 0) == (marked)))
+
+static void il2c_heap_enumerate__(bool full, bool marked, IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext)
+{
+    il2c_assert(pEnumerator != NULL);
+
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        bool available = true;
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (!available)
+                {
+                    break;
+                }
+                available = false;
+                pBlock = pSizeClass->pFull;
+                continue;
+            }
+
+            if (!full && !pBlock->young)
+            {
+                pBlock = pBlock->pNext;
+                continue;
+            }
+
+            const uint32_t cellSize = pBlock->cellSize;
+            uint8_t* pCell;
+            for (pCell = il2c_heap_cells_of_block__(pBlock); pCell < pBlock->pBump; pCell += cellSize)
+            {
+                IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)pCell;
+                if (il2c_likely__(pHeader->type != NULL) &&
+                    IL2C_HEAP_IS_ENUMERATING(pHeader, marked))
+                {
+                    pEnumerator(pHeader, pContext);
+                }
+            }
+
+            pBlock = pBlock->pNext;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    IL2C_HEAP_LARGE_OBJECT* pLargeObject = g_pLargeObjects__;
+    while (pLargeObject != NULL)
+    {
+        IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)(pLargeObject + 1);
+        if (IL2C_HEAP_IS_ENUMERATING(pHeader, marked))
+        {
+            pEnumerator(pHeader, pContext);
+        }
+        pLargeObject = pLargeObject->pNext;
+    }
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+}
+
+// Enumerates initialized but not marked instances.
+// The minor collection (not full) skips the blocks not containing young instances.
+// It has to be invoked from inside for GC process.
+void il2c_heap_enumerate_unmarked__(bool full, IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext)
+{
+    il2c_heap_enumerate__(full, false, pEnumerator, pContext);
+}
+
+// Enumerates all marked instances (the old generation too.)
+// It has to be invoked from inside for GC process.
+void il2c_heap_enumerate_marked__(IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext)
+{
+    il2c_heap_enumerate__(true, true, pEnumerator, pContext);
+}
+
+// Enumerates the marked instances from the cursor, and stops after visited the blocks (or the large instances.)
+// The cursor is the ordinal by the address order, the segment blocks and then the large instances.
+// The range added at the lower address shifts the rest forward, so the instance may be enumerated twice but never skipped.
+// Returns true if the cursor reached the end of heap.
+// It has to be invoked from inside for GC process.
+bool il2c_heap_enumerate_marked_bounded__(
+    uintptr_t* pCursor, uintptr_t maxBlocks, IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext)
+{
+    il2c_assert(pCursor != NULL);
+    il2c_assert(pEnumerator != NULL);
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    const uintptr_t segmentBlocks = (uintptr_t)g_SegmentIndex__.count * IL2C_HEAP_SEGMENT_BLOCKS;
+    uintptr_t cursor = *pCursor;
+    uintptr_t visited;
+    for (visited = 0; visited < maxBlocks; visited++, cursor++)
+    {
+        if (cursor < segmentBlocks)
+        {
+            IL2C_HEAP_SEGMENT* pSegment =
+                (IL2C_HEAP_SEGMENT*)g_SegmentIndex__.pRanges[cursor / IL2C_HEAP_SEGMENT_BLOCKS].pOwner;
+            const uintptr_t blockIndex = cursor % IL2C_HEAP_SEGMENT_BLOCKS;
+
+            // The trimmed block may be decommitted.
+            if (pSegment->trimmed[blockIndex])
+            {
+                continue;
+            }
+
+            // The free block doesn't contain any cells.
+            IL2C_HEAP_BLOCK* pBlock = (IL2C_HEAP_BLOCK*)(pSegment->pBegin + blockIndex * IL2C_HEAP_BLOCK_SIZE);
+            const uint32_t cellSize = pBlock->cellSize;
+            if (cellSize == 0)
+            {
+                continue;
+            }
+
+            uint8_t* pCell;
+            for (pCell = il2c_heap_cells_of_block__(pBlock); pCell < pBlock->pBump; pCell += cellSize)
+            {
+                IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)pCell;
+                if (il2c_likely__(pHeader->type != NULL) &&
+                    IL2C_HEAP_IS_ENUMERATING(pHeader, true))
+                {
+                    pEnumerator(pHeader, pContext);
+                }
+            }
+        }
+        else if ((cursor - segmentBlocks) < (uintptr_t)g_LargeObjectIndex__.count)
+        {
+            IL2C_HEAP_LARGE_OBJECT* pLargeObject =
+                (IL2C_HEAP_LARGE_OBJECT*)g_LargeObjectIndex__.pRanges[cursor - segmentBlocks].pOwner;
+            IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)(pLargeObject + 1);
+            if (IL2C_HEAP_IS_ENUMERATING(pHeader, true))
+            {
+                pEnumerator(pHeader, pContext);
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    const bool finished = cursor >= (segmentBlocks + (uintptr_t)g_LargeObjectIndex__.count);
+    *pCursor = cursor;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    return finished;
+}
+
+// Makes all instances NOT MARKED (the old generation too) before the full collection.
+// It only clears the side bitmaps, doesn't touch the instance headers.
+// It has to be invoked from inside for GC process.
+void il2c_heap_unmark_all__(void)
+{
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        bool available = true;
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (!available)
+                {
+                    break;
+                }
+                available = false;
+                pBlock = pSizeClass->pFull;
+                continue;
+            }
+
+            memset((void*)pBlock->markBits, 0, sizeof pBlock->markBits);
+
+            pBlock = pBlock->pNext;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    IL2C_HEAP_LARGE_OBJECT* pLargeObject = g_pLargeObjects__;
+    while (pLargeObject != NULL)
+    {
+        pLargeObject->marked = 0;
+        pLargeObject = pLargeObject->pNext;
+    }
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+}
+
+// Finds the instance contains the address. Returns NULL if the address isn't placed inside any instances.
+// It has to be invoked from inside for GC process.
+IL2C_REF_HEADER* il2c_heap_find_object__(void* pAddress)
+{
+    uint8_t* p = (uint8_t*)pAddress;
+    if ((p < g_pHeapLowerBound__) || (p >= g_pHeapUpperBound__))
+    {
+        return NULL;
+    }
+
+    IL2C_HEAP_RANGE* pRange = il2c_heap_range_index_find__(&g_SegmentIndex__, p);
+    if (pRange != NULL)
+    {
+        IL2C_HEAP_SEGMENT* pSegment = (IL2C_HEAP_SEGMENT*)pRange->pOwner;
+
+        // The trimmed block may be decommitted.
+        if (pSegment->trimmed[(uintptr_t)(p - pSegment->pBegin) / IL2C_HEAP_BLOCK_SIZE])
+        {
+            return NULL;
+        }
+
+        IL2C_HEAP_BLOCK* pBlock = (IL2C_HEAP_BLOCK*)((uintptr_t)p & ~(IL2C_HEAP_BLOCK_SIZE - 1U));
+        uint8_t* pCells = il2c_heap_cells_of_block__(pBlock);
+        if ((pBlock->cellSize == 0) || (p < pCells) || (p >= pBlock->pBump))
+        {
+            return NULL;
+        }
+
+        IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)
+            (pCells + (uintptr_t)(p - pCells) / pBlock->cellSize * pBlock->cellSize);
+        return (pHeader->type != NULL) ? pHeader : NULL;
+    }
+
+    pRange = il2c_heap_range_index_find__(&g_LargeObjectIndex__, p);
+    return (pRange != NULL) ? (IL2C_REF_HEADER*)(((IL2C_HEAP_LARGE_OBJECT*)pRange->pOwner) + 1) : NULL;
+}
+
+/////////////////////////////////////////////////////////////
+// Evacuation
+
+// The compaction (mostly-copying): The live instances on the sparse blocks are moved to the fresh blocks,
+// and the moved instance leaves the forwarding address at the old header.
+// The blocks containing the instances not movable (pinned, holding the monitor lock,
+// anchored by il2c_heap_anchor__()) aren't evacuated, so the collection doesn't move the others for nothing.
+
+// Returns 0 if the block contains the pinned cell, because the block is kept anyway.
+static uintptr_t il2c_heap_count_movable_live_cells__(IL2C_HEAP_BLOCK* pBlock)
+{
+    uintptr_t liveCells = 0;
+    const uint32_t cellSize = pBlock->cellSize;
+    uint8_t* pCell;
+    for (pCell = il2c_heap_cells_of_block__(pBlock); pCell < pBlock->pBump; pCell += cellSize)
+    {
+        IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)pCell;
+        if ((pHeader->type != NULL) && il2c_is_marked__(pHeader))
+        {
+            if (pHeader->characteristic & (IL2C_CHARACTERISTIC_PINNED | IL2C_CHARACTERISTIC_ACQUIRED_MONITOR_LOCK))
+            {
+                return 0;
+            }
+            liveCells++;
+        }
+    }
+    return liveCells;
+}
+
+// Selects the blocks which live cells are less than livePercent, and returns count of the selected blocks.
+// The size class is selected only if the evacuation reduces the blocks.
+// It has to be invoked from inside for GC process after the full marking and anchoring.
+uintptr_t il2c_heap_select_evacuation_blocks__(uint32_t livePercent)
+{
+    uintptr_t selectedBlocks = 0;
+
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        const uintptr_t cellsPerBlock = (IL2C_HEAP_BLOCK_SIZE - IL2C_HEAP_BLOCK_HEADER_SIZE) / pSizeClass->cellSize;
+        uintptr_t candidateBlocks = 0;
+        uintptr_t candidateLiveCells = 0;
+
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        bool available = true;
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (!available)
+                {
+                    break;
+                }
+                available = false;
+                pBlock = pSizeClass->pFull;
+                continue;
+            }
+
+            // The empty block is released by the sweeper.
+            const uintptr_t liveCells = pBlock->anchored ? 0 : il2c_heap_count_movable_live_cells__(pBlock);
+            if ((liveCells >= 1) && ((liveCells * 100U) <= (cellsPerBlock * livePercent)))
+            {
+                pBlock->evacuating = 1;
+                candidateBlocks++;
+                candidateLiveCells += liveCells;
+            }
+
+            pBlock = pBlock->pNext;
+        }
+
+        // Doesn't evacuate if the live cells need same blocks.
+        if ((candidateBlocks >= 1) &&
+            (((candidateLiveCells + cellsPerBlock - 1U) / cellsPerBlock) >= candidateBlocks))
+        {
+            for (pBlock = pSizeClass->pAvailable; pBlock != NULL; pBlock = pBlock->pNext)
+            {
+                pBlock->evacuating = 0;
+            }
+            for (pBlock = pSizeClass->pFull; pBlock != NULL; pBlock = pBlock->pNext)
+            {
+                pBlock->evacuating = 0;
+            }
+            candidateBlocks = 0;
+        }
+
+        selectedBlocks += candidateBlocks;
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    return selectedBlocks;
+}
+
+static uintptr_t il2c_heap_evacuate_block__(
+    IL2C_HEAP_SIZE_CLASS* pSizeClass, IL2C_HEAP_BLOCK* pBlock, IL2C_HEAP_BLOCK** ppDestination)
+{
+    uintptr_t moved = 0;
+    const uint32_t cellSize = pBlock->cellSize;
+    uint8_t* pCell;
+    for (pCell = il2c_heap_cells_of_block__(pBlock); pCell < pBlock->pBump; pCell += cellSize)
+    {
+        IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)pCell;
+        if ((pHeader->type == NULL) ||
+            !il2c_is_marked__(pHeader) ||
+            ((pHeader->characteristic &
+                (IL2C_CHARACTERISTIC_INITIALIZED | IL2C_CHARACTERISTIC_PINNED | IL2C_CHARACTERISTIC_ACQUIRED_MONITOR_LOCK)) !=
+                IL2C_CHARACTERISTIC_INITIALIZED))
+        {
+            continue;
+        }
+
+        // Take the fresh block.
+        IL2C_HEAP_BLOCK* pDestination = *ppDestination;
+        if ((pDestination == NULL) || (pDestination->pBump >= pDestination->pLimit))
+        {
+            if (pDestination != NULL)
+            {
+                pDestination->pNext = pSizeClass->pFull;
+                pSizeClass->pFull = pDestination;
+            }
+            pDestination = il2c_heap_take_free_block__(pBlock->sizeClass);
+            *ppDestination = pDestination;
+            if (il2c_unlikely__(pDestination == NULL))
+            {
+                // The rest instances stay in place.
+                break;
+            }
+        }
+
+        IL2C_REF_HEADER* pNewHeader = (IL2C_REF_HEADER*)pDestination->pBump;
+        pDestination->pBump += cellSize;
+
+        memcpy((void*)pNewHeader, (const void*)pHeader, cellSize);
+        il2c_ior(il2c_heap_mark_word__(pNewHeader), il2c_heap_mark_bit__(pNewHeader));
+
+        // The old cell isn't marked, so the enumerator ignores it.
+        il2c_iand(il2c_heap_mark_word__(pHeader), ~il2c_heap_mark_bit__(pHeader));
+        pHeader->type = (IL2C_RUNTIME_TYPE)pNewHeader;
+        pHeader->characteristic |= IL2C_CHARACTERISTIC_FORWARDED;
+
+        moved++;
+    }
+    return moved;
+}
+
+// Moves the live instances out of the evacuating blocks, and returns count of the moved instances.
+// The references to the moved instances have to be updated by il2c_heap_forwarded__()
+// before il2c_heap_finish_evacuation__().
+// It has to be invoked from inside for GC process.
+uintptr_t il2c_heap_evacuate__(void)
+{
+    uintptr_t moved = 0;
+
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        IL2C_HEAP_BLOCK* pDestination = NULL;
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        bool available = true;
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (!available)
+                {
+                    break;
+                }
+                available = false;
+                pBlock = pSizeClass->pFull;
+                continue;
+            }
+
+            if (pBlock->evacuating)
+            {
+                moved += il2c_heap_evacuate_block__(pSizeClass, pBlock, &pDestination);
+            }
+
+            pBlock = pBlock->pNext;
+        }
+
+        if (pDestination != NULL)
+        {
+            pDestination->pNext = pSizeClass->pAvailable;
+            pSizeClass->pAvailable = pDestination;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    return moved;
+}
+
+// Frees the old cells of the moved instances, they'll be reused after the sweeping.
+// And clears the anchors and the evacuating marks.
+// It has to be invoked from inside for GC process.
+void il2c_heap_finish_evacuation__(void)
+{
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        bool available = true;
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (!available)
+                {
+                    break;
+                }
+                available = false;
+                pBlock = pSizeClass->pFull;
+                continue;
+            }
+
+            if (pBlock->evacuating)
+            {
+                const uint32_t cellSize = pBlock->cellSize;
+                uint8_t* pCell;
+                for (pCell = il2c_heap_cells_of_block__(pBlock); pCell < pBlock->pBump; pCell += cellSize)
+                {
+                    IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)pCell;
+                    if (pHeader->characteristic & IL2C_CHARACTERISTIC_FORWARDED)
+                    {
+                        pHeader->type = NULL;
+                        pHeader->characteristic = 0;
+                    }
+                }
+            }
+            pBlock->anchored = 0;
+            pBlock->evacuating = 0;
+
+            pBlock = pBlock->pNext;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+}
+
+/////////////////////////////////////////////////////////////
+// Sweeper
+
+static uintptr_t il2c_heap_sweep_block__(IL2C_HEAP_BLOCK* pBlock, uintptr_t* pFreedCells)
+{
+    const uint32_t cellSize = pBlock->cellSize;
+    IL2C_REF_HEADER* pFreeList = NULL;
+    uintptr_t remains = 0;
+    uintptr_t freed = 0;
+
+    // Rebuild the free list from the linear scan.
+    uint8_t* pCell;
+    for (pCell = il2c_heap_cells_of_block__(pBlock); pCell < pBlock->pBump; pCell += cellSize)
+    {
+        IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)pCell;
+        if (il2c_likely__(pHeader->type != NULL))
+        {
+            const interlock_t characteristic = pHeader->characteristic;
+            if (il2c_likely__(!IL2C_HEAP_IS_GARBAGE(pHeader)))
+            {
+                remains++;
+                continue;
+            }
+
+            il2c_runtime_debug_log_format(
+                L"il2c_heap_sweep_block__: free: type={0:s}, pObject=0x{1:p}, characteristic=0x{2:x}",
+                pHeader->type->pTypeName,
+                pHeader + 1,
+                characteristic);
+
+            // Simply ignore if this instance didn't mark ACQUIRED.
+            if (il2c_unlikely__(characteristic & IL2C_CHARACTERISTIC_ACQUIRED_MONITOR_LOCK))
+            {
+                // Monitor lock discarded.
+                il2c_release_monitor_lock_from_objref__(pHeader);
+            }
+
+            pHeader->type = NULL;
+            pHeader->characteristic = 0;
+            freed++;
+        }
+
+        *(IL2C_REF_HEADER**)(pHeader + 1) = pFreeList;
+        pFreeList = pHeader;
+    }
+
+    pBlock->pFreeList = pFreeList;
+    pBlock->liveCells = (uint32_t)remains;
+    pBlock->young = 0;
+    *pFreedCells = freed;
+    return remains;
+}
+
+// Gives back the swept block to the size class, or to the free blocks if it's empty.
+// The caller has to hold the size class lock.
+static void il2c_heap_classify_swept_block__(
+    IL2C_HEAP_SIZE_CLASS* pSizeClass, IL2C_HEAP_BLOCK* pBlock, uintptr_t blockRemains)
+{
+    if (blockRemains == 0)
+    {
+        il2c_heap_release_block__(pBlock);
+    }
+    else if ((pBlock->pFreeList != NULL) || (pBlock->pBump < pBlock->pLimit))
+    {
+        pBlock->pNext = pSizeClass->pAvailable;
+        pSizeClass->pAvailable = pBlock;
+    }
+    else
+    {
+        pBlock->pNext = pSizeClass->pFull;
+        pSizeClass->pFull = pBlock;
+    }
+}
+
+// Sweeps one of the unswept blocks. Returns false if this size class doesn't have unswept blocks.
+// The caller has to hold the size class lock.
+static bool il2c_heap_sweep_unswept_block__(IL2C_HEAP_SIZE_CLASS* pSizeClass)
+{
+    IL2C_HEAP_BLOCK* pBlock = pSizeClass->pUnswept;
+    if (il2c_likely__(pBlock == NULL))
+    {
+        return false;
+    }
+    pSizeClass->pUnswept = pBlock->pNext;
+
+    uintptr_t freedCells;
+    const uintptr_t blockRemains = il2c_heap_sweep_block__(pBlock, &freedCells);
+    const uintptr_t liveBytes = blockRemains * pBlock->cellSize;
+    const uintptr_t freedBytes = freedCells * pBlock->cellSize;
+    il2c_heap_classify_swept_block__(pSizeClass, pBlock, blockRemains);
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+    g_SweptLiveBytes__ += liveBytes;
+    g_SweptLiveObjects__ += blockRemains;
+    g_SweptFreedBytes__ += freedBytes;
+    const bool finished = (--g_UnsweptBlocks__ == 0);
+    const uintptr_t sweptLiveBytes = g_SweptLiveBytes__;
+    const uintptr_t sweptLiveObjects = g_SweptLiveObjects__;
+    const uintptr_t sweptFreedBytes = g_SweptFreedBytes__;
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    // The last block: the surviving bytes of the last collection are fixed.
+    if (il2c_unlikely__(finished))
+    {
+        il2c_notify_swept__(sweptLiveBytes, sweptLiveObjects, sweptFreedBytes);
+    }
+    return true;
+}
+
+// Sweeps the unswept blocks up to the count, and returns true if the unswept blocks remain.
+// The allocator calls it for spreading the sweeping cost, or the sweeper thread calls it.
+bool il2c_heap_sweep_pending__(uintptr_t maxBlocks)
+{
+    uint32_t count;
+    for (count = 0; (count < g_SizeClassCount__) && (maxBlocks >= 1) && (g_UnsweptBlocks__ >= 1); count++)
+    {
+        // Rotate the size class, doesn't care the race condition.
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[g_SweepCursor__++ % g_SizeClassCount__];
+        if (pSizeClass->pUnswept == NULL)
+        {
+            continue;
+        }
+
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+        while ((maxBlocks >= 1) && il2c_heap_sweep_unswept_block__(pSizeClass))
+        {
+            maxBlocks--;
+        }
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    return g_UnsweptBlocks__ >= 1;
+}
+
+// Sweeps all unswept blocks. It has to be invoked before the next collection begins.
+void il2c_heap_finish_sweep__(void)
+{
+    uint32_t sizeClass;
+    for (sizeClass = 0; (sizeClass < g_SizeClassCount__) && (g_UnsweptBlocks__ >= 1); sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+        while (il2c_heap_sweep_unswept_block__(pSizeClass));
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    il2c_assert(g_UnsweptBlocks__ == 0);
+}
+
+static uintptr_t il2c_heap_sweep_large_objects__(uintptr_t* pLiveBytes, uintptr_t* pFreedBytes)
+{
+    uintptr_t remains = 0;
+    uintptr_t liveBytes = 0;
+    uintptr_t freedBytes = 0;
+    IL2C_HEAP_LARGE_OBJECT* pFreed = NULL;
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    // Walk on the index, the freed instances are dropped from it in the same pass.
+    uint32_t index;
+    for (index = 0; index < g_LargeObjectIndex__.count; index++)
+    {
+        IL2C_HEAP_LARGE_OBJECT* pLargeObject = (IL2C_HEAP_LARGE_OBJECT*)g_LargeObjectIndex__.pRanges[index].pOwner;
+        IL2C_HEAP_LARGE_OBJECT* pNext = pLargeObject->pNext;
+        IL2C_REF_HEADER* pHeader = (IL2C_REF_HEADER*)(pLargeObject + 1);
+        const interlock_t characteristic = pHeader->characteristic;
+        if (il2c_likely__(!IL2C_HEAP_IS_GARBAGE(pHeader)))
+        {
+            g_LargeObjectIndex__.pRanges[remains++] = g_LargeObjectIndex__.pRanges[index];
+            liveBytes += pLargeObject->size;
+        }
+        else
+        {
+            il2c_runtime_debug_log_format(
+                L"il2c_heap_sweep_large_objects__: free large: type={0:s}, pObject=0x{1:p}, characteristic=0x{2:x}",
+                pHeader->type->pTypeName,
+                pHeader + 1,
+                characteristic);
+
+            if (il2c_unlikely__(characteristic & IL2C_CHARACTERISTIC_ACQUIRED_MONITOR_LOCK))
+            {
+                il2c_release_monitor_lock_from_objref__(pHeader);
+            }
+
+            if (pLargeObject->pPrev != NULL)
+            {
+                pLargeObject->pPrev->pNext = pNext;
+            }
+            else
+            {
+                g_pLargeObjects__ = pNext;
+            }
+            if (pNext != NULL)
+            {
+                pNext->pPrev = pLargeObject->pPrev;
+            }
+
+            freedBytes += pLargeObject->size;
+            g_LargeObjectBytes__ -= sizeof(IL2C_HEAP_LARGE_OBJECT) + pLargeObject->size;
+            pLargeObject->pNext = pFreed;
+            pFreed = pLargeObject;
+        }
+    }
+
+    g_LargeObjectIndex__.count = (uint32_t)remains;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    // Return the pages to the OS outside of the heap lock.
+    while (pFreed != NULL)
+    {
+        IL2C_HEAP_LARGE_OBJECT* pNext = pFreed->pNext;
+        il2c_heap_free_large__(pFreed);
+        pFreed = pNext;
+    }
+
+    *pLiveBytes = liveBytes;
+    *pFreedBytes = freedBytes;
+    return remains;
+}
+
+// Begins the lazy sweeping: The blocks contain the unmarked instances are swept
+// on demand by the allocator (il2c_heap_sweep_pending__) after the mutators resume,
+// or by the sweeper thread if background is true,
+// and il2c_notify_swept__() is called when all blocks are swept.
+// The large objects are swept just now.
+// It has to be invoked from inside for GC process.
+void il2c_heap_begin_sweep__(bool full, bool background)
+{
+    il2c_assert(g_UnsweptBlocks__ == 0);
+
+    g_BackgroundSweeping__ = background;
+
+    uintptr_t unsweptBlocks = 0;
+    uintptr_t liveBytes;
+    uintptr_t freedBytes;
+    uintptr_t liveObjects = il2c_heap_sweep_large_objects__(&liveBytes, &freedBytes);
+
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        IL2C_HEAP_BLOCK* pFull = pSizeClass->pFull;
+        pSizeClass->pAvailable = NULL;
+        pSizeClass->pFull = NULL;
+
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (pFull == NULL)
+                {
+                    break;
+                }
+                pBlock = pFull;
+                pFull = NULL;
+            }
+
+            IL2C_HEAP_BLOCK* pNext = pBlock->pNext;
+
+            // The minor collection doesn't have to sweep the blocks only containing old instances.
+            if (full || pBlock->young)
+            {
+                pBlock->pNext = pSizeClass->pUnswept;
+                pSizeClass->pUnswept = pBlock;
+                unsweptBlocks++;
+            }
+            else
+            {
+                liveBytes += pBlock->liveCells * pBlock->cellSize;
+                liveObjects += pBlock->liveCells;
+                il2c_heap_classify_swept_block__(pSizeClass, pBlock, pBlock->liveCells);
+            }
+
+            pBlock = pNext;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+    g_SweptLiveBytes__ = liveBytes;
+    g_SweptLiveObjects__ = liveObjects;
+    g_SweptFreedBytes__ = freedBytes;
+    g_UnsweptBlocks__ = unsweptBlocks;
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    if (unsweptBlocks == 0)
+    {
+        il2c_notify_swept__(liveBytes, liveObjects, freedBytes);
+    }
+}
+
+// Frees the unmarked instances just now and returns count of the instance remains.
+// The minor collection (not full) skips the blocks not containing young instances,
+// because all instances in these blocks are old generation (marked.)
+// It has to be invoked from inside for GC process.
+uintptr_t il2c_heap_sweep__(bool full, uintptr_t* pLiveBytes)
+{
+    // The last lazy sweeping has to be finished.
+    il2c_heap_finish_sweep__();
+
+    uintptr_t liveBytes;
+    uintptr_t freedBytes;
+    uintptr_t remains = il2c_heap_sweep_large_objects__(&liveBytes, &freedBytes);
+
+    uint32_t sizeClass;
+    for (sizeClass = 0; sizeClass < g_SizeClassCount__; sizeClass++)
+    {
+        IL2C_HEAP_SIZE_CLASS* pSizeClass = &g_SizeClasses__[sizeClass];
+        il2c_enter_monitor_lock__(&pSizeClass->lock);
+
+        // Reclassify all blocks after swept.
+        IL2C_HEAP_BLOCK* pBlock = pSizeClass->pAvailable;
+        IL2C_HEAP_BLOCK* pFull = pSizeClass->pFull;
+        pSizeClass->pAvailable = NULL;
+        pSizeClass->pFull = NULL;
+
+        while (1)
+        {
+            if (pBlock == NULL)
+            {
+                if (pFull == NULL)
+                {
+                    break;
+                }
+                pBlock = pFull;
+                pFull = NULL;
+            }
+
+            IL2C_HEAP_BLOCK* pNext = pBlock->pNext;
+
+            uintptr_t freedCells;
+            const uintptr_t blockRemains = (full || pBlock->young) ?
+                il2c_heap_sweep_block__(pBlock, &freedCells) : pBlock->liveCells;
+            remains += blockRemains;
+            liveBytes += blockRemains * pBlock->cellSize;
+            il2c_heap_classify_swept_block__(pSizeClass, pBlock, blockRemains);
+
+            pBlock = pNext;
+        }
+
+        il2c_exit_monitor_lock__(&pSizeClass->lock);
+    }
+
+    if (pLiveBytes != NULL)
+    {
+        *pLiveBytes = liveBytes;
+    }
+    return remains;
+}
+
+/////////////////////////////////////////////////////////////
+// Trimming
+
+// Trims the free blocks released before the delay, and returns the segments all blocks trimmed to the OS.
+// Returns the bytes given back to the OS.
+// The pages are decommitted under the heap lock, because the allocator may take back the trimmed block.
+// It has to be invoked from inside for GC process.
+uintptr_t il2c_heap_trim__(uint32_t delayMilliseconds)
+{
+    const uint64_t now = il2c_heap_get_milliseconds__();
+    IL2C_HEAP_SEGMENT* pReleased = NULL;
+
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    const uintptr_t committedBlocks = il2c_heap_committed_blocks__();
+
+    IL2C_HEAP_BLOCK** ppBlock = &g_pFreeBlocks__;
+    while (*ppBlock != NULL)
+    {
+        IL2C_HEAP_BLOCK* pBlock = *ppBlock;
+        if ((now - pBlock->releasedAt) < delayMilliseconds)
+        {
+            ppBlock = &pBlock->pNext;
+            continue;
+        }
+
+        *ppBlock = pBlock->pNext;
+        g_FreeBlockCount__--;
+
+        IL2C_HEAP_SEGMENT* pSegment = (IL2C_HEAP_SEGMENT*)pBlock->pSegment;
+        pSegment->trimmed[(uintptr_t)((uint8_t*)pBlock - pSegment->pBegin) / IL2C_HEAP_BLOCK_SIZE] = 1;
+        pSegment->trimmedBlocks++;
+        g_TrimmedBlocks__++;
+
+#if defined(IL2C_USE_PAGE_DECOMMIT)
+        il2c_page_decommit__((void*)pBlock, IL2C_HEAP_BLOCK_SIZE);
+#endif
+    }
+
+    // Unlink the segments all blocks trimmed (the heap bounds aren't shrunk, it's the filter only.)
+    IL2C_HEAP_SEGMENT** ppSegment = &g_pSegments__;
+    while (*ppSegment != NULL)
+    {
+        IL2C_HEAP_SEGMENT* pSegment = *ppSegment;
+        if (pSegment->trimmedBlocks < IL2C_HEAP_SEGMENT_BLOCKS)
+        {
+            ppSegment = &pSegment->pNext;
+            continue;
+        }
+
+        *ppSegment = pSegment->pNext;
+        g_SegmentBlocks__ -= IL2C_HEAP_SEGMENT_BLOCKS;
+        g_TrimmedBlocks__ -= IL2C_HEAP_SEGMENT_BLOCKS;
+
+        pSegment->pNext = pReleased;
+        pReleased = pSegment;
+    }
+
+    // Drop the released segments from the index in one pass.
+    if (pReleased != NULL)
+    {
+        uint32_t count = 0;
+        uint32_t index;
+        for (index = 0; index < g_SegmentIndex__.count; index++)
+        {
+            IL2C_HEAP_RANGE* pRange = &g_SegmentIndex__.pRanges[index];
+            if (((IL2C_HEAP_SEGMENT*)pRange->pOwner)->trimmedBlocks < IL2C_HEAP_SEGMENT_BLOCKS)
+            {
+                g_SegmentIndex__.pRanges[count++] = *pRange;
+            }
+        }
+        g_SegmentIndex__.count = count;
+    }
+
+    const uintptr_t trimmedBytes = (committedBlocks - il2c_heap_committed_blocks__()) * IL2C_HEAP_BLOCK_SIZE;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+
+    // Return the segments to the OS outside of the heap lock.
+    while (pReleased != NULL)
+    {
+        IL2C_HEAP_SEGMENT* pNext = pReleased->pNext;
+        il2c_heap_free_segment__(pReleased);
+        pReleased = pNext;
+    }
+
+    return trimmedBytes;
+}
+
+// The committed bytes are the heap blocks not decommitted and the large instances,
+// the used bytes exclude the free blocks from them.
+void il2c_heap_get_committed_bytes__(uintptr_t* pCommittedBytes, uintptr_t* pUsedBytes)
+{
+    il2c_enter_monitor_lock__(&g_HeapLock__);
+
+    const uintptr_t committedBlocks = il2c_heap_committed_blocks__();
+    const uintptr_t usedBlocks = g_SegmentBlocks__ - g_TrimmedBlocks__ - g_FreeBlockCount__;
+    *pCommittedBytes = committedBlocks * IL2C_HEAP_BLOCK_SIZE + g_LargeObjectBytes__;
+    *pUsedBytes = usedBlocks * IL2C_HEAP_BLOCK_SIZE + g_LargeObjectBytes__;
+
+    il2c_exit_monitor_lock__(&g_HeapLock__);
+}
@@ -0,0 +1,578 @@
+#include <il2c_private.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Allocation profiler: The allocations are sampled at every sampling bytes (randomized) per thread,
+//   and the samples are attributed to the allocation site (type, file and line.)
+//   The interval is randomized, because the fixed interval aliases with the periodic allocation pattern.
+//   The file and line are available if IL2C_USE_LINE_INFORMATION (the debug build, or defined explicitly),
+//   otherwise the samples are attributed to the type only.
+//   Each sample represents the sampling bytes, so the report is the estimation of the allocations.
+
+#if defined(IL2C_USE_ALLOCATION_PROFILER)
+
+extern IL2C_TLS_INDEX g_TlsIndex__;
+
+#if !defined(IL2C_ALLOCATION_PROFILE_DEFAULT_SAMPLING_BYTES)
+#define IL2C_ALLOCATION_PROFILE_DEFAULT_SAMPLING_BYTES (512U * 1024U)
+#endif
+#if !defined(IL2C_ALLOCATION_PROFILE_DEFAULT_OUTPUT)
+#define IL2C_ALLOCATION_PROFILE_DEFAULT_OUTPUT "il2c_allocation_profile.txt"
+#endif
+
+typedef struct IL2C_ALLOCATION_SITE_DECL
+{
+    IL2C_RUNTIME_TYPE type;         // NULL if this entry is empty
+    const char* pFile;
+    int line;
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t objects;
+} IL2C_ALLOCATION_SITE;
+
+// 0 is disabled, the allocator checks it at every allocation.
+volatile uintptr_t g_AllocationSamplingBytes__ = 0;
+// The sampling bytes for the report (kept after stopped.)
+static uintptr_t g_ReportSamplingBytes__ = 0;
+
+// The allocation sites (open addressing), guarded by g_AllocationSitesLock__.
+static IL2C_MONITOR_LOCK g_AllocationSitesLock__;
+static IL2C_ALLOCATION_SITE* g_pAllocationSites__ = NULL;
+static uintptr_t g_AllocationSiteCount__ = 0;
+static uintptr_t g_AllocationSiteCapacity__ = 0;
+
+// Dumps at the shutdown if enabled by the environment variables.
+static const char* g_pAllocationProfileOutput__ = NULL;
+
+// xorshift32, guarded by g_AllocationSitesLock__.
+static uint32_t g_AllocationSampleRandom__ = 2463534242U;
+
+// Returns the next interval uniformly in [1, samplingBytes * 2), the average is the sampling bytes.
+// The caller has to hold g_AllocationSitesLock__.
+static intptr_t il2c_next_sample_interval__(uintptr_t samplingBytes)
+{
+    uint32_t x = g_AllocationSampleRandom__;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    g_AllocationSampleRandom__ = x;
+
+    const uint64_t range = (uint64_t)samplingBytes * 2U - 1U;
+    return (intptr_t)(1U + (uint64_t)x * range / ((uint64_t)UINT32_MAX + 1U));
+}
+
+static uintptr_t il2c_hash_allocation_site__(IL2C_RUNTIME_TYPE type, const char* pFile, int line)
+{
+    uintptr_t hash = (uintptr_t)type;
+    hash = (hash ^ (hash >> 7)) * 31U + (uintptr_t)pFile;
+    hash = (hash ^ (hash >> 7)) * 31U + (uintptr_t)line;
+    return hash ^ (hash >> 11);
+}
+
+// The caller has to hold g_AllocationSitesLock__.
+static IL2C_ALLOCATION_SITE* il2c_find_allocation_site__(
+    IL2C_ALLOCATION_SITE* pSites, uintptr_t capacity, IL2C_RUNTIME_TYPE type, const char* pFile, int line)
+{
+    uintptr_t index = il2c_hash_allocation_site__(type, pFile, line) & (capacity - 1);
+    while (1)
+    {
+        IL2C_ALLOCATION_SITE* pSite = &pSites[index];
+        if ((pSite->type == NULL) ||
+            ((pSite->type == type) && (pSite->pFile == pFile) && (pSite->line == line)))
+        {
+            return pSite;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+}
+
+// The caller has to hold g_AllocationSitesLock__. Returns false if couldn't allocate.
+static bool il2c_grow_allocation_sites__(void)
+{
+    const uintptr_t capacity = (g_AllocationSiteCapacity__ >= 1) ? (g_AllocationSiteCapacity__ * 2) : 256;
+#if defined(IL2C_USE_LINE_INFORMATION)
+    IL2C_ALLOCATION_SITE* pSites = il2c_malloc(capacity * sizeof(IL2C_ALLOCATION_SITE), __FILE__, __LINE__);
+#else
+    IL2C_ALLOCATION_SITE* pSites = il2c_malloc(capacity * sizeof(IL2C_ALLOCATION_SITE));
+#endif
+    if (il2c_unlikely__(pSites == NULL))
+    {
+        return false;
+    }
+    memset(pSites, 0, capacity * sizeof(IL2C_ALLOCATION_SITE));
+
+    uintptr_t index;
+    for (index = 0; index < g_AllocationSiteCapacity__; index++)
+    {
+        const IL2C_ALLOCATION_SITE* pSite = &g_pAllocationSites__[index];
+        if (pSite->type != NULL)
+        {
+            *il2c_find_allocation_site__(pSites, capacity, pSite->type, pSite->pFile, pSite->line) = *pSite;
+        }
+    }
+
+    if (g_pAllocationSites__ != NULL)
+    {
+        il2c_free(g_pAllocationSites__);
+    }
+    g_pAllocationSites__ = pSites;
+    g_AllocationSiteCapacity__ = capacity;
+    return true;
+}
+
+// Called by the allocator if the profiler is enabled.
+void il2c_sample_allocation__(IL2C_RUNTIME_TYPE type, uintptr_t size, const char* pFile, int line)
+{
+    // The thread context isn't attached when allocating the thread instance itself.
+    IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
+    const uintptr_t samplingBytes = g_AllocationSamplingBytes__;
+    if (il2c_unlikely__((pThreadContext == NULL) || (samplingBytes == 0)))
+    {
+        return;
+    }
+
+    // Only the allocating thread touches the counter.
+    intptr_t bytesUntilSample = pThreadContext->bytesUntilSample - (intptr_t)size;
+    if (il2c_likely__(bytesUntilSample > 0))
+    {
+        pThreadContext->bytesUntilSample = bytesUntilSample;
+        return;
+    }
+
+    il2c_enter_monitor_lock__(&g_AllocationSitesLock__);
+
+    // The large instance may cover some intervals.
+    uintptr_t samples = 0;
+    while (bytesUntilSample <= 0)
+    {
+        bytesUntilSample += il2c_next_sample_interval__(samplingBytes);
+        samples++;
+    }
+    pThreadContext->bytesUntilSample = bytesUntilSample;
+
+    // The sampled instance represents the instances allocated in the sampling bytes.
+    const uint64_t bytes = (uint64_t)samples * samplingBytes;
+    const uint64_t objects = (size >= samplingBytes) ? samples : (bytes / size);
+
+    // Keep the load factor under 50%.
+    if (il2c_likely__((g_AllocationSiteCount__ * 2 < g_AllocationSiteCapacity__) || il2c_grow_allocation_sites__()))
+    {
+        IL2C_ALLOCATION_SITE* pSite = il2c_find_allocation_site__(
+            g_pAllocationSites__, g_AllocationSiteCapacity__, type, pFile, line);
+        if (pSite->type == NULL)
+        {
+            pSite->type = type;
+            pSite->pFile = pFile;
+            pSite->line = line;
+            g_AllocationSiteCount__++;
+        }
+        pSite->samples += samples;
+        pSite->bytes += bytes;
+        pSite->objects += objects;
+    }
+
+    il2c_exit_monitor_lock__(&g_AllocationSitesLock__);
+}
+
+void il2c_start_allocation_profiler(uintptr_t samplingBytes)
+{
+    g_ReportSamplingBytes__ = (samplingBytes >= 1) ? samplingBytes : IL2C_ALLOCATION_PROFILE_DEFAULT_SAMPLING_BYTES;
+    g_AllocationSamplingBytes__ = g_ReportSamplingBytes__;
+}
+
+void il2c_stop_allocation_profiler(void)
+{
+    g_AllocationSamplingBytes__ = 0;
+}
+
+void il2c_reset_allocation_profile(void)
+{
+    il2c_enter_monitor_lock__(&g_AllocationSitesLock__);
+    if (g_pAllocationSites__ != NULL)
+    {
+        memset(g_pAllocationSites__, 0, g_AllocationSiteCapacity__ * sizeof(IL2C_ALLOCATION_SITE));
+    }
+    g_AllocationSiteCount__ = 0;
+    il2c_exit_monitor_lock__(&g_AllocationSitesLock__);
+}
+
+/////////////////////////////////////////////////////////////
+// Report writers
+
+static int il2c_compare_allocation_site_bytes__(const void* pLhs, const void* pRhs)
+{
+    const IL2C_ALLOCATION_SITE* pLhsSite = (const IL2C_ALLOCATION_SITE*)pLhs;
+    const IL2C_ALLOCATION_SITE* pRhsSite = (const IL2C_ALLOCATION_SITE*)pRhs;
+    return (pLhsSite->bytes < pRhsSite->bytes) ? 1 : ((pLhsSite->bytes > pRhsSite->bytes) ? -1 : 0);
+}
+
+// Copies the sites sorted by bytes, the caller has to free it.
+static IL2C_ALLOCATION_SITE* il2c_snapshot_allocation_sites__(uintptr_t* pCount)
+{
+    il2c_enter_monitor_lock__(&g_AllocationSitesLock__);
+
+    const uintptr_t count = g_AllocationSiteCount__;
+#if defined(IL2C_USE_LINE_INFORMATION)
+    IL2C_ALLOCATION_SITE* pSites = il2c_malloc((count + 1) * sizeof(IL2C_ALLOCATION_SITE), __FILE__, __LINE__);
+#else
+    IL2C_ALLOCATION_SITE* pSites = il2c_malloc((count + 1) * sizeof(IL2C_ALLOCATION_SITE));
+#endif
+    if (pSites != NULL)
+    {
+        uintptr_t index;
+        uintptr_t copied = 0;
+        for (index = 0; index < g_AllocationSiteCapacity__; index++)
+        {
+            if (g_pAllocationSites__[index].type != NULL)
+            {
+                pSites[copied++] = g_pAllocationSites__[index];
+            }
+        }
+        il2c_assert(copied == count);
+    }
+
+    il2c_exit_monitor_lock__(&g_AllocationSitesLock__);
+
+    if (pSites != NULL)
+    {
+        qsort(pSites, count, sizeof(IL2C_ALLOCATION_SITE), il2c_compare_allocation_site_bytes__);
+    }
+    *pCount = count;
+    return pSites;
+}
+
+static bool il2c_write_allocation_profile_text__(FILE* fp, const IL2C_ALLOCATION_SITE* pSites, uintptr_t count)
+{
+    uint64_t totalBytes = 0;
+    uint64_t totalSamples = 0;
+    uintptr_t index;
+    for (index = 0; index < count; index++)
+    {
+        totalBytes += pSites[index].bytes;
+        totalSamples += pSites[index].samples;
+    }
+
+    fprintf(fp, "# IL2C allocation profile: sampling=%lu bytes, samples=%llu, estimated=%llu bytes\n",
+        (unsigned long)g_ReportSamplingBytes__,
+        (unsigned long long)totalSamples,
+        (unsigned long long)totalBytes);
+    fprintf(fp, "#%15s %12s %10s %6s  %s\n", "bytes", "objects", "samples", "%", "type @ site");
+
+    for (index = 0; index < count; index++)
+    {
+        const IL2C_ALLOCATION_SITE* pSite = &pSites[index];
+        fprintf(fp, "%16llu %12llu %10llu %6.2f  %s",
+            (unsigned long long)pSite->bytes,
+            (unsigned long long)pSite->objects,
+            (unsigned long long)pSite->samples,
+            (totalBytes >= 1) ? ((double)pSite->bytes * 100.0 / (double)totalBytes) : 0.0,
+            pSite->type->pTypeName);
+        if (pSite->pFile != NULL)
+        {
+            fprintf(fp, " @ %s:%d", pSite->pFile, pSite->line);
+        }
+        fputc('\n', fp);
+    }
+
+    return ferror(fp) == 0;
+}
+
+// The pprof format is the protocol buffers message (perftools.profiles.Profile, not compressed.)
+typedef struct IL2C_PROFILE_BUFFER_DECL
+{
+    uint8_t* pBuffer;
+    uintptr_t size;
+    uintptr_t capacity;
+    bool failed;
+} IL2C_PROFILE_BUFFER;
+
+static void il2c_profile_buffer_append__(IL2C_PROFILE_BUFFER* pBuffer, const void* pData, uintptr_t size)
+{
+    if (il2c_unlikely__(pBuffer->failed))
+    {
+        return;
+    }
+
+    if (pBuffer->size + size > pBuffer->capacity)
+    {
+        uintptr_t capacity = (pBuffer->capacity >= 1) ? (pBuffer->capacity * 2) : 4096;
+        while (capacity < pBuffer->size + size)
+        {
+            capacity *= 2;
+        }
+#if defined(IL2C_USE_LINE_INFORMATION)
+        uint8_t* p = il2c_malloc(capacity, __FILE__, __LINE__);
+#else
+        uint8_t* p = il2c_malloc(capacity);
+#endif
+        if (il2c_unlikely__(p == NULL))
+        {
+            pBuffer->failed = true;
+            return;
+        }
+        if (pBuffer->pBuffer != NULL)
+        {
+            memcpy(p, pBuffer->pBuffer, pBuffer->size);
+            il2c_free(pBuffer->pBuffer);
+        }
+        pBuffer->pBuffer = p;
+        pBuffer->capacity = capacity;
+    }
+
+    memcpy(pBuffer->pBuffer + pBuffer->size, pData, size);
+    pBuffer->size += size;
+}
+
+static void il2c_profile_buffer_varint__(IL2C_PROFILE_BUFFER* pBuffer, uint64_t value)
+{
+    uint8_t bytes[10];
+    uintptr_t size = 0;
+    do
+    {
+        bytes[size++] = (uint8_t)((value & 0x7fU) | ((value >= 0x80U) ? 0x80U : 0));
+        value >>= 7;
+    } while (value != 0);
+    il2c_profile_buffer_append__(pBuffer, bytes, size);
+}
+
+// Wire type 0 (varint)
+static void il2c_profile_buffer_uint__(IL2C_PROFILE_BUFFER* pBuffer, uint32_t field, uint64_t value)
+{
+    il2c_profile_buffer_varint__(pBuffer, (uint64_t)field << 3);
+    il2c_profile_buffer_varint__(pBuffer, value);
+}
+
+// Wire type 2 (length delimited: strings, packed values and messages)
+static void il2c_profile_buffer_bytes__(IL2C_PROFILE_BUFFER* pBuffer, uint32_t field, const void* pData, uintptr_t size)
+{
+    il2c_profile_buffer_varint__(pBuffer, ((uint64_t)field << 3) | 2U);
+    il2c_profile_buffer_varint__(pBuffer, size);
+    il2c_profile_buffer_append__(pBuffer, pData, size);
+}
+
+// Appends the message and clears it for reusing.
+static void il2c_profile_buffer_message__(IL2C_PROFILE_BUFFER* pBuffer, uint32_t field, IL2C_PROFILE_BUFFER* pMessage)
+{
+    il2c_profile_buffer_bytes__(pBuffer, field, pMessage->pBuffer, pMessage->size);
+    pBuffer->failed |= pMessage->failed;
+    pMessage->size = 0;
+}
+
+// Appends the string to the string table, and returns the index.
+static uint64_t il2c_profile_string__(IL2C_PROFILE_BUFFER* pStrings, uint64_t* pIndex, const char* pString)
+{
+    il2c_profile_buffer_bytes__(pStrings, 6, pString, strlen(pString));
+    return (*pIndex)++;
+}
+
+static bool il2c_write_allocation_profile_pprof__(FILE* fp, const IL2C_ALLOCATION_SITE* pSites, uintptr_t count)
+{
+    IL2C_PROFILE_BUFFER profile = { NULL, 0, 0, false };
+    IL2C_PROFILE_BUFFER strings = { NULL, 0, 0, false };
+    IL2C_PROFILE_BUFFER message = { NULL, 0, 0, false };
+    IL2C_PROFILE_BUFFER inner = { NULL, 0, 0, false };
+    uint64_t stringIndex = 0;
+
+    // The string table begins with the empty string.
+    il2c_profile_string__(&strings, &stringIndex, "");
+
+    // Profile.sample_type (ValueType: type, unit)
+    il2c_profile_buffer_uint__(&message, 1, il2c_profile_string__(&strings, &stringIndex, "alloc_objects"));
+    il2c_profile_buffer_uint__(&message, 2, il2c_profile_string__(&strings, &stringIndex, "count"));
+    il2c_profile_buffer_message__(&profile, 1, &message);
+    const uint64_t allocSpace = il2c_profile_string__(&strings, &stringIndex, "alloc_space");
+    const uint64_t bytesUnit = il2c_profile_string__(&strings, &stringIndex, "bytes");
+    il2c_profile_buffer_uint__(&message, 1, allocSpace);
+    il2c_profile_buffer_uint__(&message, 2, bytesUnit);
+    il2c_profile_buffer_message__(&profile, 1, &message);
+
+    // Each site has 2 frames: the allocated type (leaf) and the allocation site.
+    uintptr_t index;
+    for (index = 0; index < count; index++)
+    {
+        const IL2C_ALLOCATION_SITE* pSite = &pSites[index];
+        const uint64_t typeId = (uint64_t)index * 2 + 1;
+        const uint64_t siteId = typeId + 1;
+        const char* pFile = (pSite->pFile != NULL) ? pSite->pFile : "(unknown)";
+
+        // Profile.function (id, name, system_name, filename)
+        const uint64_t typeNameIndex = il2c_profile_string__(&strings, &stringIndex, pSite->type->pTypeName);
+        il2c_profile_buffer_uint__(&message, 1, typeId);
+        il2c_profile_buffer_uint__(&message, 2, typeNameIndex);
+        il2c_profile_buffer_uint__(&message, 3, typeNameIndex);
+        il2c_profile_buffer_message__(&profile, 5, &message);
+
+        // The translated function name isn't available, the site is named by the file and line.
+        char siteName[256];
+        snprintf(siteName, sizeof siteName, "%s:%d", pFile, pSite->line);
+        const uint64_t siteNameIndex = il2c_profile_string__(&strings, &stringIndex, siteName);
+        const uint64_t fileNameIndex = il2c_profile_string__(&strings, &stringIndex, pFile);
+        il2c_profile_buffer_uint__(&message, 1, siteId);
+        il2c_profile_buffer_uint__(&message, 2, siteNameIndex);
+        il2c_profile_buffer_uint__(&message, 3, siteNameIndex);
+        il2c_profile_buffer_uint__(&message, 4, fileNameIndex);
+        il2c_profile_buffer_message__(&profile, 5, &message);
+
+        // Profile.location (id, line: Line (function_id, line))
+        il2c_profile_buffer_uint__(&message, 1, typeId);
+        il2c_profile_buffer_uint__(&inner, 1, typeId);
+        il2c_profile_buffer_message__(&message, 4, &inner);
+        il2c_profile_buffer_message__(&profile, 4, &message);
+
+        il2c_profile_buffer_uint__(&message, 1, siteId);
+        il2c_profile_buffer_uint__(&inner, 1, siteId);
+        il2c_profile_buffer_uint__(&inner, 2, (uint64_t)(int64_t)pSite->line);
+        il2c_profile_buffer_message__(&message, 4, &inner);
+        il2c_profile_buffer_message__(&profile, 4, &message);
+
+        // Profile.sample (location_id: packed, value: packed)
+        il2c_profile_buffer_varint__(&inner, typeId);
+        il2c_profile_buffer_varint__(&inner, siteId);
+        il2c_profile_buffer_message__(&message, 1, &inner);
+        il2c_profile_buffer_varint__(&inner, pSite->objects);
+        il2c_profile_buffer_varint__(&inner, pSite->bytes);
+        il2c_profile_buffer_message__(&message, 2, &inner);
+        il2c_profile_buffer_message__(&profile, 2, &message);
+    }
+
+    // Profile.period_type, period and default_sample_type
+    il2c_profile_buffer_uint__(&message, 1, il2c_profile_string__(&strings, &stringIndex, "space"));
+    il2c_profile_buffer_uint__(&message, 2, bytesUnit);
+    il2c_profile_buffer_message__(&profile, 11, &message);
+    il2c_profile_buffer_uint__(&profile, 12, g_ReportSamplingBytes__);
+    il2c_profile_buffer_uint__(&profile, 14, allocSpace);
+
+    // Profile.string_table
+    il2c_profile_buffer_append__(&profile, strings.pBuffer, strings.size);
+
+    const bool succeeded =
+        !profile.failed && !strings.failed && !message.failed && !inner.failed &&
+        (fwrite(profile.pBuffer, 1, profile.size, fp) == profile.size);
+
+    if (profile.pBuffer != NULL) il2c_free(profile.pBuffer);
+    if (strings.pBuffer != NULL) il2c_free(strings.pBuffer);
+    if (message.pBuffer != NULL) il2c_free(message.pBuffer);
+    if (inner.pBuffer != NULL) il2c_free(inner.pBuffer);
+
+    return succeeded;
+}
+
+bool il2c_dump_allocation_profile(const char* pPath, uint32_t format)
+{
+    il2c_assert(pPath != NULL);
+
+    uintptr_t count;
+    IL2C_ALLOCATION_SITE* pSites = il2c_snapshot_allocation_sites__(&count);
+    if (il2c_unlikely__(pSites == NULL))
+    {
+        return false;
+    }
+
+    bool succeeded = false;
+    FILE* fp = fopen(pPath, (format == IL2C_ALLOCATION_PROFILE_FORMAT_PPROF) ? "wb" : "w");
+    if (fp != NULL)
+    {
+        succeeded = (format == IL2C_ALLOCATION_PROFILE_FORMAT_PPROF) ?
+            il2c_write_allocation_profile_pprof__(fp, pSites, count) :
+            il2c_write_allocation_profile_text__(fp, pSites, count);
+        succeeded = (fclose(fp) == 0) && succeeded;
+    }
+
+    il2c_free(pSites);
+    return succeeded;
+}
+
+/////////////////////////////////////////////////////////////
+
+static bool il2c_has_suffix__(const char* pString, const char* pSuffix)
+{
+    const size_t length = strlen(pString);
+    const size_t suffixLength = strlen(pSuffix);
+    return (length >= suffixLength) && (strcmp(pString + length - suffixLength, pSuffix) == 0);
+}
+
+void il2c_initialize_allocation_profiler__(void)
+{
+    il2c_initialize_monitor_lock__(&g_AllocationSitesLock__);
+
+    g_AllocationSamplingBytes__ = 0;
+    g_ReportSamplingBytes__ = 0;
+    g_pAllocationSites__ = NULL;
+    g_AllocationSiteCount__ = 0;
+    g_AllocationSiteCapacity__ = 0;
+    g_pAllocationProfileOutput__ = NULL;
+
+#if defined(IL2C_USE_GETENV)
+    // IL2C_ALLOCATION_PROFILE=<sampling bytes, 0 is default>
+    // IL2C_ALLOCATION_PROFILE_OUTPUT=<path, *.pb or *.pprof is the pprof format, otherwise the text>
+    if (getenv("IL2C_ALLOCATION_PROFILE") != NULL)
+    {
+        il2c_start_allocation_profiler(il2c_get_environment_size__("IL2C_ALLOCATION_PROFILE"));
+
+        g_pAllocationProfileOutput__ = getenv("IL2C_ALLOCATION_PROFILE_OUTPUT");
+        if (g_pAllocationProfileOutput__ == NULL)
+        {
+            g_pAllocationProfileOutput__ = IL2C_ALLOCATION_PROFILE_DEFAULT_OUTPUT;
+        }
+    }
+#endif
+}
+
+void il2c_shutdown_allocation_profiler__(void)
+{
+    if (g_pAllocationProfileOutput__ != NULL)
+    {
+        il2c_dump_allocation_profile(
+            g_pAllocationProfileOutput__,
+            (il2c_has_suffix__(g_pAllocationProfileOutput__, ".pb") ||
+             il2c_has_suffix__(g_pAllocationProfileOutput__, ".pprof")) ?
+                IL2C_ALLOCATION_PROFILE_FORMAT_PPROF :
+                IL2C_ALLOCATION_PROFILE_FORMAT_TEXT);
+        g_pAllocationProfileOutput__ = NULL;
+    }
+
+    g_AllocationSamplingBytes__ = 0;
+    if (g_pAllocationSites__ != NULL)
+    {
+        il2c_free(g_pAllocationSites__);
+        g_pAllocationSites__ = NULL;
+    }
+    g_AllocationSiteCount__ = 0;
+    g_AllocationSiteCapacity__ = 0;
+
+    il2c_destroy_monitor_lock__(&g_AllocationSitesLock__);
+}
+
+#else
+
+// This platform doesn't write the report file.
+
+void il2c_start_allocation_profiler(uintptr_t samplingBytes)
+{
+    ((void)samplingBytes);
+}
+
+void il2c_stop_allocation_profiler(void)
+{
+}
+
+void il2c_reset_allocation_profile(void)
+{
+}
+
+bool il2c_dump_allocation_profile(const char* pPath, uint32_t format)
+{
+    ((void)pPath);
+    ((void)format);
+    return false;
+}
+
+void il2c_initialize_allocation_profiler__(void)
+{
+}
+
+void il2c_shutdown_allocation_profiler__(void)
+{
+}
+
+#endif
@@ -0,0 +1,412 @@
+#include <il2c_private.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Heap snapshot: Writes all instances on the heap and the roots while the mutators are stopped (il2c_walk_heap__.)
+//   The snapshot doesn't collect before walking, so it contains the unreachable instances allocated
+//   after the last collection. The analyzer (IL2C.HeapAnalyzer) traces from the roots.
+//
+// File format (all integers are little endian):
+//   Header:    "IL2CHEAP" (8 bytes), uint32 version (1), uint32 pointer size
+//   Records:   uint8 tag and the payload
+//     'T':     uint64 type id, uint32 name length, name (UTF-8, not terminated)
+//              The type record is written before the first instance of the type.
+//     'R':     uint8 root kind (IL2C_HEAP_ROOT_*), uint64 instance address
+//     'O':     uint64 instance address, uint64 type id, uint64 size (includes the header),
+//              uint32 reference count, uint64 referred instance address * reference count
+//     'E':     uint64 instance count, uint64 root count (the last record)
+//   The same instance may be reported by the multiple roots.
+
+#if defined(IL2C_USE_FILE_IO)
+
+#define IL2C_HEAP_SNAPSHOT_VERSION 1U
+
+#if !defined(IL2C_HEAP_SNAPSHOT_DEFAULT_OUTPUT)
+#define IL2C_HEAP_SNAPSHOT_DEFAULT_OUTPUT "il2c_heap.snapshot"
+#endif
+
+typedef struct IL2C_HEAP_SNAPSHOT_WRITER_DECL
+{
+    FILE* fp;
+    bool failed;
+
+    // The instance reporting now, the references are buffered until the next instance.
+    IL2C_REF_HEADER* pInstance;
+    IL2C_RUNTIME_TYPE instanceType;
+    uintptr_t instanceSize;
+    uint64_t* pReferences;
+    uintptr_t referenceCount;
+    uintptr_t referenceCapacity;
+
+    // The types already written (open addressing.)
+    IL2C_RUNTIME_TYPE* pTypes;
+    uintptr_t typeCount;
+    uintptr_t typeCapacity;
+
+    uint64_t instances;
+    uint64_t roots;
+} IL2C_HEAP_SNAPSHOT_WRITER;
+
+static void il2c_snapshot_write__(IL2C_HEAP_SNAPSHOT_WRITER* pWriter, const void* pData, uintptr_t size)
+{
+    if (il2c_likely__(!pWriter->failed) &&
+        il2c_unlikely__(fwrite(pData, 1, size, pWriter->fp) != size))
+    {
+        pWriter->failed = true;
+    }
+}
+
+static void il2c_snapshot_write_uint8__(IL2C_HEAP_SNAPSHOT_WRITER* pWriter, uint8_t value)
+{
+    il2c_snapshot_write__(pWriter, &value, 1);
+}
+
+static void il2c_snapshot_write_uint32__(IL2C_HEAP_SNAPSHOT_WRITER* pWriter, uint32_t value)
+{
+    uint8_t bytes[4];
+    uintptr_t index;
+    for (index = 0; index < sizeof bytes; index++, value >>= 8)
+    {
+        bytes[index] = (uint8_t)value;
+    }
+    il2c_snapshot_write__(pWriter, bytes, sizeof bytes);
+}
+
+static void il2c_snapshot_write_uint64__(IL2C_HEAP_SNAPSHOT_WRITER* pWriter, uint64_t value)
+{
+    uint8_t bytes[8];
+    uintptr_t index;
+    for (index = 0; index < sizeof bytes; index++, value >>= 8)
+    {
+        bytes[index] = (uint8_t)value;
+    }
+    il2c_snapshot_write__(pWriter, bytes, sizeof bytes);
+}
+
+// Grows the array to contain the count + 1 elements, returns false if failed.
+static bool il2c_snapshot_reserve__(void** ppArray, uintptr_t* pCapacity, uintptr_t count, uintptr_t elementSize)
+{
+    if (il2c_likely__(count < *pCapacity))
+    {
+        return true;
+    }
+
+    const uintptr_t capacity = (*pCapacity >= 1) ? (*pCapacity * 2) : 64;
+#if defined(IL2C_USE_LINE_INFORMATION)
+    void* p = il2c_malloc(capacity * elementSize, __FILE__, __LINE__);
+#else
+    void* p = il2c_malloc(capacity * elementSize);
+#endif
+    if (il2c_unlikely__(p == NULL))
+    {
+        return false;
+    }
+
+    memset(p, 0, capacity * elementSize);
+    if (*ppArray != NULL)
+    {
+        memcpy(p, *ppArray, count * elementSize);
+        il2c_free(*ppArray);
+    }
+    *ppArray = p;
+    *pCapacity = capacity;
+    return true;
+}
+
+static IL2C_RUNTIME_TYPE* il2c_snapshot_find_type__(
+    IL2C_RUNTIME_TYPE* pTypes, uintptr_t capacity, IL2C_RUNTIME_TYPE type)
+{
+    uintptr_t hash = (uintptr_t)type;
+    uintptr_t index = (hash ^ (hash >> 7) ^ (hash >> 13)) & (capacity - 1);
+    while ((pTypes[index] != NULL) && (pTypes[index] != type))
+    {
+        index = (index + 1) & (capacity - 1);
+    }
+    return &pTypes[index];
+}
+
+static void il2c_snapshot_write_type__(IL2C_HEAP_SNAPSHOT_WRITER* pWriter, IL2C_RUNTIME_TYPE type)
+{
+    if (il2c_likely__(pWriter->pTypes != NULL))
+    {
+        if (il2c_likely__(*il2c_snapshot_find_type__(pWriter->pTypes, pWriter->typeCapacity, type) == type))
+        {
+            return;
+        }
+    }
+
+    // Keep the load factor below 50%.
+    if (il2c_unlikely__((pWriter->typeCount + 1) * 2 > pWriter->typeCapacity))
+    {
+        const uintptr_t capacity = (pWriter->typeCapacity >= 1) ? (pWriter->typeCapacity * 2) : 256;
+#if defined(IL2C_USE_LINE_INFORMATION)
+        IL2C_RUNTIME_TYPE* pTypes = il2c_malloc(capacity * sizeof(IL2C_RUNTIME_TYPE), __FILE__, __LINE__);
+#else
+        IL2C_RUNTIME_TYPE* pTypes = il2c_malloc(capacity * sizeof(IL2C_RUNTIME_TYPE));
+#endif
+        if (il2c_unlikely__(pTypes == NULL))
+        {
+            pWriter->failed = true;
+            return;
+        }
+
+        memset(pTypes, 0, capacity * sizeof(IL2C_RUNTIME_TYPE));
+        uintptr_t index;
+        for (index = 0; index < pWriter->typeCapacity; index++)
+        {
+            if (pWriter->pTypes[index] != NULL)
+            {
+                *il2c_snapshot_find_type__(pTypes, capacity, pWriter->pTypes[index]) = pWriter->pTypes[index];
+            }
+        }
+
+        if (pWriter->pTypes != NULL)
+        {
+            il2c_free(pWriter->pTypes);
+        }
+        pWriter->pTypes = pTypes;
+        pWriter->typeCapacity = capacity;
+    }
+
+    *il2c_snapshot_find_type__(pWriter->pTypes, pWriter->typeCapacity, type) = type;
+    pWriter->typeCount++;
+
+    const uint32_t nameLength = (uint32_t)strlen(type->pTypeName);
+    il2c_snapshot_write_uint8__(pWriter, 'T');
+    il2c_snapshot_write_uint64__(pWriter, (uint64_t)(uintptr_t)type);
+    il2c_snapshot_write_uint32__(pWriter, nameLength);
+    il2c_snapshot_write__(pWriter, type->pTypeName, nameLength);
+}
+
+static void il2c_snapshot_flush_instance__(IL2C_HEAP_SNAPSHOT_WRITER* pWriter)
+{
+    IL2C_REF_HEADER* pHeader = pWriter->pInstance;
+    if (pHeader == NULL)
+    {
+        return;
+    }
+
+    il2c_snapshot_write_type__(pWriter, pWriter->instanceType);
+
+    il2c_snapshot_write_uint8__(pWriter, 'O');
+    il2c_snapshot_write_uint64__(pWriter, (uint64_t)(uintptr_t)pHeader);
+    il2c_snapshot_write_uint64__(pWriter, (uint64_t)(uintptr_t)pWriter->instanceType);
+    il2c_snapshot_write_uint64__(pWriter, (uint64_t)pWriter->instanceSize);
+    il2c_snapshot_write_uint32__(pWriter, (uint32_t)pWriter->referenceCount);
+
+    uintptr_t index;
+    for (index = 0; index < pWriter->referenceCount; index++)
+    {
+        il2c_snapshot_write_uint64__(pWriter, pWriter->pReferences[index]);
+    }
+
+    pWriter->pInstance = NULL;
+    pWriter->referenceCount = 0;
+    pWriter->instances++;
+}
+
+static void il2c_snapshot_root__(uint8_t rootKind, IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    IL2C_HEAP_SNAPSHOT_WRITER* pWriter = (IL2C_HEAP_SNAPSHOT_WRITER*)pContext;
+
+    il2c_snapshot_write_uint8__(pWriter, 'R');
+    il2c_snapshot_write_uint8__(pWriter, rootKind);
+    il2c_snapshot_write_uint64__(pWriter, (uint64_t)(uintptr_t)pHeader);
+    pWriter->roots++;
+}
+
+static void il2c_snapshot_instance__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    IL2C_HEAP_SNAPSHOT_WRITER* pWriter = (IL2C_HEAP_SNAPSHOT_WRITER*)pContext;
+
+    il2c_snapshot_flush_instance__(pWriter);
+    pWriter->pInstance = pHeader;
+    pWriter->instanceType = pHeader->type;
+    pWriter->instanceSize = il2c_heap_size_of__(pHeader);
+}
+
+static void il2c_snapshot_reference__(IL2C_REF_HEADER* pHeader, void* pContext)
+{
+    IL2C_HEAP_SNAPSHOT_WRITER* pWriter = (IL2C_HEAP_SNAPSHOT_WRITER*)pContext;
+
+    if (il2c_unlikely__(!il2c_snapshot_reserve__(
+        (void**)&pWriter->pReferences, &pWriter->referenceCapacity, pWriter->referenceCount, sizeof(uint64_t))))
+    {
+        pWriter->failed = true;
+        return;
+    }
+
+    pWriter->pReferences[pWriter->referenceCount++] = (uint64_t)(uintptr_t)pHeader;
+}
+
+bool il2c_dump_heap_snapshot(const char* pPath)
+{
+    il2c_assert(pPath != NULL);
+
+    FILE* fp = fopen(pPath, "wb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+
+    IL2C_HEAP_SNAPSHOT_WRITER writer;
+    memset(&writer, 0, sizeof writer);
+    writer.fp = fp;
+
+    il2c_snapshot_write__(&writer, "IL2CHEAP", 8);
+    il2c_snapshot_write_uint32__(&writer, IL2C_HEAP_SNAPSHOT_VERSION);
+    il2c_snapshot_write_uint32__(&writer, (uint32_t)sizeof(void*));
+
+    const IL2C_HEAP_WALKER walker = {
+        il2c_snapshot_root__,
+        il2c_snapshot_instance__,
+        il2c_snapshot_reference__,
+        &writer };
+    il2c_walk_heap__(&walker);
+
+    // The last instance is written after the mutators resume (doesn't touch the heap.)
+    il2c_snapshot_flush_instance__(&writer);
+    il2c_snapshot_write_uint8__(&writer, 'E');
+    il2c_snapshot_write_uint64__(&writer, writer.instances);
+    il2c_snapshot_write_uint64__(&writer, writer.roots);
+
+    il2c_runtime_debug_log_format(
+        L"il2c_dump_heap_snapshot: instances={0:u}, roots={1:u}, failed={2:d}",
+        (uint32_t)writer.instances,
+        (uint32_t)writer.roots,
+        writer.failed);
+
+    if (writer.pReferences != NULL)
+    {
+        il2c_free(writer.pReferences);
+    }
+    if (writer.pTypes != NULL)
+    {
+        il2c_free(writer.pTypes);
+    }
+
+    const bool succeeded = !writer.failed;
+    return (fclose(fp) == 0) && succeeded;
+}
+
+/////////////////////////////////////////////////////////////
+// Signal trigger: The signal handler only wakes the snapshot thread up,
+//   because the snapshot takes the locks and allocates (not async signal safe.)
+
+#if defined(IL2C_USE_SIGNAL) && defined(SIGUSR2) && defined(IL2C_USE_SEMAPHORE) && defined(IL2C_USE_GETENV)
+
+static intptr_t g_HeapSnapshotThreadHandle__ = 0;
+static IL2C_SEMAPHORE g_HeapSnapshotSemaphore__;
+static volatile bool g_HeapSnapshotShutdown__ = false;
+static const char* g_pHeapSnapshotOutput__ = NULL;
+static void (*g_SIGUSR2_saved)(int);
+
+static void il2c_SIGUSR2_handler(int sig)
+{
+    ((void)sig);
+    il2c_release_semaphore__(&g_HeapSnapshotSemaphore__);
+}
+
+static IL2C_THREAD_ENTRY_POINT_RESULT_TYPE il2c_heap_snapshot_entry_point__(
+    IL2C_THREAD_ENTRY_POINT_PARAMETER_TYPE parameter)
+{
+    ((void)parameter);
+
+    uint32_t sequence = 0;
+    while (1)
+    {
+        il2c_wait_semaphore__(&g_HeapSnapshotSemaphore__);
+        if (il2c_unlikely__(g_HeapSnapshotShutdown__))
+        {
+            break;
+        }
+
+        char path[4096];
+        snprintf(path, sizeof path, "%s.%u", g_pHeapSnapshotOutput__, (unsigned int)sequence++);
+        il2c_dump_heap_snapshot(path);
+    }
+
+    IL2C_THREAD_ENTRY_POINT_RETURN(0);
+}
+
+void il2c_initialize_heap_snapshot__(void)
+{
+    g_HeapSnapshotThreadHandle__ = 0;
+    g_HeapSnapshotShutdown__ = false;
+
+    // IL2C_HEAP_SNAPSHOT_SIGNAL=1
+    // IL2C_HEAP_SNAPSHOT_OUTPUT=<path prefix>
+    if (il2c_get_environment_size__("IL2C_HEAP_SNAPSHOT_SIGNAL") == 0)
+    {
+        return;
+    }
+
+    g_pHeapSnapshotOutput__ = getenv("IL2C_HEAP_SNAPSHOT_OUTPUT");
+    if (g_pHeapSnapshotOutput__ == NULL)
+    {
+        g_pHeapSnapshotOutput__ = IL2C_HEAP_SNAPSHOT_DEFAULT_OUTPUT;
+    }
+
+    il2c_initialize_semaphore__(&g_HeapSnapshotSemaphore__);
+
+    const intptr_t threadHandle = il2c_create_thread__(il2c_heap_snapshot_entry_point__, NULL);
+    if (il2c_unlikely__((threadHandle == 0) || (threadHandle == -1)))
+    {
+        il2c_destroy_semaphore__(&g_HeapSnapshotSemaphore__);
+        return;
+    }
+
+    g_HeapSnapshotThreadHandle__ = threadHandle;
+    il2c_resume_thread__(threadHandle);
+
+    g_SIGUSR2_saved = signal(SIGUSR2, il2c_SIGUSR2_handler);
+}
+
+void il2c_shutdown_heap_snapshot__(void)
+{
+    if (g_HeapSnapshotThreadHandle__ != 0)
+    {
+        signal(SIGUSR2, g_SIGUSR2_saved);
+
+        g_HeapSnapshotShutdown__ = true;
+        il2c_release_semaphore__(&g_HeapSnapshotSemaphore__);
+
+        il2c_join_thread__(g_HeapSnapshotThreadHandle__);
+        il2c_close_thread_handle__(g_HeapSnapshotThreadHandle__);
+        il2c_destroy_semaphore__(&g_HeapSnapshotSemaphore__);
+
+        g_HeapSnapshotThreadHandle__ = 0;
+    }
+}
+
+#else
+
+void il2c_initialize_heap_snapshot__(void)
+{
+}
+
+void il2c_shutdown_heap_snapshot__(void)
+{
+}
+
+#endif
+
+#else
+
+// This platform doesn't write the snapshot file.
+
+bool il2c_dump_heap_snapshot(const char* pPath)
+{
+    ((void)pPath);
+    return false;
+}
+
+void il2c_initialize_heap_snapshot__(void)
+{
+}
+
+void il2c_shutdown_heap_snapshot__(void)
+{
+}
+
+#endif
@@ -4,6 +4,10 @@
 
 IL2C_TLS_INDEX g_TlsIndex__;
 
+// The collecting thread sets them while holding g_GlobalLockForCollect__.
+volatile interlock_t g_SafepointRequested__ = 0;
+volatile int32_t g_SafepointOwnerId__ = 0;
+
 /////////////////////////////////////////////////////////////
 // Thread context functions
 
@@ -17,15 +21,21 @@ IL2C_THREAD_CONTEXT* il2c_acquire_thread_context__(void)
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
     if (il2c_unlikely__(pThreadContext == NULL))
     {
+        // The collection doesn't begin while attaching, because the thread instance has to be
+        // registered before the next marking (or the lazy sweeping frees it.)
+        il2c_enter_monitor_lock__(&g_GlobalLockForCollect__);
+
 #if defined(IL2C_USE_LINE_INFORMATION)
         IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
             il2c_typeof(System_Threading_Thread),
             sizeof(IL2C_RUNTIME_THREAD),
+            false,
             pFile, line);
 #else
         IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
             il2c_typeof(System_Threading_Thread),
-            sizeof(IL2C_RUNTIME_THREAD));
+            sizeof(IL2C_RUNTIME_THREAD),
+            false);
 #endif
 
         IL2C_RUNTIME_THREAD* pRuntimeThread = (IL2C_RUNTIME_THREAD*)(pHeader + 1);
@@ -35,7 +45,8 @@ IL2C_THREAD_CONTEXT* il2c_acquire_thread_context__(void)
 
         pThreadContext->rawHandle = il2c_get_current_thread__();
         pThreadContext->id = il2c_get_current_thread_id__();
-        il2c_initialize_monitor_lock__((void*)&pThreadContext->lockForCollect);
+        pThreadContext->safepointState = IL2C_SAFEPOINT_STATE_SAFE;
+        il2c_attach_native_stack__(pThreadContext);
 
         // Save IL2C_THREAD_CONTEXT into tls.
         il2c_set_tls_value(g_TlsIndex__, (void*)pThreadContext);
@@ -48,6 +59,13 @@ IL2C_THREAD_CONTEXT* il2c_acquire_thread_context__(void)
 
         // Marked instance is initialized. (and will handle by GC)
         il2c_ior(&pHeader->characteristic, IL2C_CHARACTERISTIC_INITIALIZED);
+
+        il2c_exit_monitor_lock__(&g_GlobalLockForCollect__);
+
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+        // The translated code doesn't link the execution frames.
+        il2c_leave_safe_region__(pThreadContext);
+#endif
     }
 
     return pThreadContext;
@@ -66,13 +84,15 @@ System_Threading_Thread* il2c_new_thread__(System_Delegate* start)
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         il2c_typeof(System_Threading_Thread),
         sizeof(IL2C_RUNTIME_CREATED_THREAD),
+        false,
         pFile, line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
         pFile, line);
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         il2c_typeof(System_Threading_Thread),
-        sizeof(IL2C_RUNTIME_CREATED_THREAD));
+        sizeof(IL2C_RUNTIME_CREATED_THREAD),
+        false);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -84,10 +104,174 @@ System_Threading_Thread* il2c_new_thread__(System_Delegate* start)
      
     // Initialize thread context.
     pRuntimeThread->context.id = il2c_get_current_thread_id__();
-    il2c_initialize_monitor_lock__((void*)&pRuntimeThread->context.lockForCollect);
+    pRuntimeThread->context.safepointState = IL2C_SAFEPOINT_STATE_SAFE;
 
     // Marked instance is initialized. (and will handle by GC)
     il2c_ior(&pHeader->characteristic, IL2C_CHARACTERISTIC_INITIALIZED);
 
     return (System_Threading_Thread*)&pRuntimeThread->thread;
 }
+
+/////////////////////////////////////////////////////////////
+// Safepoint functions
+
+// Blocks while the GC is stopping the mutators. The thread context has to be RUNNING.
+void il2c_park_at_safepoint__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+    il2c_assert(pThreadContext->safepointState == IL2C_SAFEPOINT_STATE_RUNNING);
+
+    // The collecting thread calls the finalizers (and the custom mark handlers) at the inside of the collection.
+    if (il2c_unlikely__(il2c_get_current_thread_id__() == g_SafepointOwnerId__))
+    {
+        return;
+    }
+
+    il2c_save_native_stack__(pThreadContext);
+
+    while (1)
+    {
+        // The GC reads the execution frames after observed PARKED (il2c_ixchg is the full barrier.)
+        il2c_ixchg(&pThreadContext->safepointState, IL2C_SAFEPOINT_STATE_PARKED);
+
+        // The collecting thread holds it until the mutators resume.
+        il2c_enter_monitor_lock__(&g_GlobalLockForCollect__);
+        il2c_exit_monitor_lock__(&g_GlobalLockForCollect__);
+
+        // The next collection may begin before marked RUNNING, then it has observed PARKED:
+        // Have to check the request again after marked.
+        il2c_ixchg(&pThreadContext->safepointState, IL2C_SAFEPOINT_STATE_RUNNING);
+        if (il2c_likely__(g_SafepointRequested__ == 0))
+        {
+            break;
+        }
+    }
+}
+
+// Returns true if entered (the thread context was RUNNING.)
+bool il2c_enter_safe_region__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+
+    if (pThreadContext->safepointState != IL2C_SAFEPOINT_STATE_RUNNING)
+    {
+        return false;
+    }
+
+    // Publish the execution frames before the GC observes SAFE.
+    il2c_save_native_stack__(pThreadContext);
+    il2c_ixchg(&pThreadContext->safepointState, IL2C_SAFEPOINT_STATE_SAFE);
+    return true;
+}
+
+void il2c_leave_safe_region__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+    il2c_assert(pThreadContext->safepointState == IL2C_SAFEPOINT_STATE_SAFE);
+
+    // Same as il2c_park_at_safepoint__(): The GC observes RUNNING or this thread observes the request.
+    il2c_ixchg(&pThreadContext->safepointState, IL2C_SAFEPOINT_STATE_RUNNING);
+    if (il2c_unlikely__(g_SafepointRequested__ != 0))
+    {
+        il2c_park_at_safepoint__(pThreadContext);
+    }
+}
+
+// The exiting thread gives back the thread local allocation buffers, and the GC doesn't wait for it after that.
+void il2c_retire_thread_context__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+
+    // The thread has unlinked the bottom frame (SAFE), or holds RUNNING without the execution frames.
+    if (pThreadContext->safepointState != IL2C_SAFEPOINT_STATE_RUNNING)
+    {
+        il2c_leave_safe_region__(pThreadContext);
+    }
+
+    il2c_enter_giant_lock__();
+    il2c_heap_retire_allocation_context__(
+        (IL2C_HEAP_ALLOCATION_CONTEXT*)&pThreadContext->allocationContext);
+    il2c_exit_giant_lock__();
+
+    // The native stack will be released.
+    il2c_detach_native_stack__(pThreadContext);
+    il2c_enter_safe_region__(pThreadContext);
+}
+
+void il2c_safepoint__(void)
+{
+    // The thread isn't attached or doesn't have any execution frames.
+    IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
+    if (il2c_likely__((pThreadContext != NULL) &&
+        (pThreadContext->safepointState == IL2C_SAFEPOINT_STATE_RUNNING)))
+    {
+        il2c_park_at_safepoint__(pThreadContext);
+    }
+}
+
+bool il2c_enter_safe_region(void)
+{
+    IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
+    return (pThreadContext != NULL) && il2c_enter_safe_region__(pThreadContext);
+}
+
+void il2c_leave_safe_region(bool entered)
+{
+    if (entered)
+    {
+        IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
+        il2c_assert(pThreadContext != NULL);
+
+        il2c_leave_safe_region__(pThreadContext);
+    }
+}
+
+void il2c_detach_current_thread(void)
+{
+    // NOTE: The auto attached Thread class instance isn't freed when before shutdown,
+    //   calling the managed code again attaches the new instance.
+    IL2C_THREAD_CONTEXT* pThreadContext = il2c_get_tls_value(g_TlsIndex__);
+    if (pThreadContext != NULL)
+    {
+        il2c_retire_thread_context__(pThreadContext);
+        il2c_set_tls_value(g_TlsIndex__, NULL);
+    }
+}
+
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+/////////////////////////////////////////////////////////////
+// Native stack functions
+
+void il2c_attach_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+
+    pThreadContext->pStackBase = il2c_get_current_thread_stack_base__();
+    pThreadContext->pStackPointer = NULL;
+}
+
+// Returns the address below the caller's frame (includes the callee saved registers spilled by the caller.)
+static __attribute__((noinline, noclone)) void* il2c_get_stack_pointer__(void)
+{
+    return __builtin_frame_address(0);
+}
+
+// The objrefs held by the translated code are in the native stack (the callers' frames)
+// or in the registers, so the registers are saved and the stack is scanned from below this frame.
+__attribute__((noinline)) void il2c_save_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+
+    il2c_save_registers__((IL2C_SAVED_REGISTERS*)&pThreadContext->savedRegisters);
+    pThreadContext->pStackPointer = il2c_get_stack_pointer__();
+}
+
+void il2c_detach_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext)
+{
+    il2c_assert(pThreadContext != NULL);
+    il2c_assert(pThreadContext->safepointState == IL2C_SAFEPOINT_STATE_RUNNING);
+
+    pThreadContext->pStackBase = NULL;
+    pThreadContext->pStackPointer = NULL;
+}
+#endif
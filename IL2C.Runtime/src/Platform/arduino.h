@@ -19,6 +19,7 @@ extern "C" {
 #define IL2C_USE_TWTOI
 #define IL2C_USE_WTOI
 #define IL2C_USE_FREERTOS
+#define IL2C_GC_DEFAULT_ALLOCATION_BUDGET (16U * 1024U)
 //#define IL2C_USE_PTHREAD
 //#define IL2C_USE_NO_THREADING
 
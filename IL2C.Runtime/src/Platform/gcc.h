@@ -34,11 +34,13 @@ extern "C" {
 #define il2c_ixor(pDest, newValue) __sync_fetch_and_xor((interlock_t*)(pDest), (interlock_t)(newValue))
 #define il2c_iinc(pDest) __sync_add_and_fetch((interlock_t*)(pDest), 1)
 #define il2c_idec(pDest) __sync_sub_and_fetch((interlock_t*)(pDest), 1)
+#define il2c_iadd(pDest, value) __sync_add_and_fetch((interlock_t*)(pDest), (interlock_t)(value))
 #define il2c_ixchg(pDest, newValue) __sync_lock_test_and_set((interlock_t*)(pDest), (interlock_t)(newValue))
 #define il2c_ixchgptr(ppDest, pNewValue) __sync_lock_test_and_set((void**)(ppDest), (void*)(pNewValue))
 #define il2c_icmpxchg(pDest, newValue, comperandValue) __sync_val_compare_and_swap((interlock_t*)(pDest), (interlock_t)(comperandValue), (interlock_t)(newValue))
 #define il2c_icmpxchgptr(ppDest, pNewValue, pComperandValue) __sync_val_compare_and_swap((void**)(ppDest), (void*)(pComperandValue), (void*)(pNewValue))
 #define il2c_memory_barrier() __sync_synchronize()
+#define il2c_prefetch(p) __builtin_prefetch((const void*)(p))
 
 #endif
 
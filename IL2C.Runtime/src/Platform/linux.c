@@ -1,3 +1,8 @@
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+// pthread_getattr_np()
+#define _GNU_SOURCE
+#endif
+
 #include <il2c_private.h>
 
 //////////////////////////////////////////////////
@@ -28,6 +33,37 @@ void il2c_sleep(uint32_t milliseconds)
     }
 }
 
+uint64_t il2c_get_monotonic_microseconds__(void)
+{
+    struct timespec tm;
+    clock_gettime(CLOCK_MONOTONIC, &tm);
+    return (uint64_t)tm.tv_sec * 1000000U + (uint64_t)tm.tv_nsec / 1000U;
+}
+
+void* il2c_page_allocate__(size_t size)
+{
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (p != MAP_FAILED) ? p : NULL;
+}
+
+#if defined(IL2C_USE_NATIVE_STACK_SCAN)
+// The stack grows down, returns the highest address.
+void* il2c_get_current_thread_stack_base__(void)
+{
+    pthread_attr_t attr;
+    void* pStackAddress = NULL;
+    size_t stackSize = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0)
+    {
+        pthread_attr_getstack(&attr, &pStackAddress, &stackSize);
+        pthread_attr_destroy(&attr);
+    }
+    il2c_assert(pStackAddress != NULL);
+
+    return (uint8_t*)pStackAddress + stackSize;
+}
+#endif
+
 #if defined(IL2C_USE_RUNTIME_DEBUG_LOG)
 void il2c_runtime_debug_log(const wchar_t* message)
 {
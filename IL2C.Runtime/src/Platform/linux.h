@@ -16,6 +16,8 @@ extern "C" {
 
 #define IL2C_USE_PTHREAD
 #define IL2C_USE_ITOW
+#define IL2C_USE_GETENV
+#define IL2C_USE_FILE_IO
 
 #include "heap.h"
 
@@ -28,6 +30,8 @@ extern "C" {
 #define IL2C_USE_SIGNAL
 #include <signal.h>
 
+#include <sys/mman.h>
+
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/syscall.h>
@@ -38,6 +42,28 @@ extern "C" {
 
 extern void il2c_sleep(uint32_t milliseconds);
 
+// The heap segments and the large object space are backed by the anonymous pages (zero-filled when mapped.)
+#define IL2C_USE_PAGE_ALLOCATOR
+extern void* il2c_page_allocate__(size_t size);
+#define il2c_page_free__(p, size) munmap((p), (size))
+// MADV_FREE is lazy (the pages are counted until the memory pressure), so uses MADV_DONTNEED.
+#define IL2C_USE_PAGE_DECOMMIT
+#define il2c_page_decommit__(p, size) ((void)madvise((p), (size), MADV_DONTNEED))
+#define il2c_page_commit__(p, size) ((void)(p), (void)(size), true)
+#define il2c_get_processor_count__() ((uint32_t)sysconf(_SC_NPROCESSORS_ONLN))
+
+#define IL2C_USE_MONOTONIC_CLOCK
+extern uint64_t il2c_get_monotonic_microseconds__(void);
+
+// The conservative stack scanning: getcontext() saves the registers (includes the callee saved registers.)
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN) && (defined(__x86_64__) || defined(__aarch64__))
+#define IL2C_USE_NATIVE_STACK_SCAN
+#include <ucontext.h>
+typedef ucontext_t IL2C_SAVED_REGISTERS;
+#define il2c_save_registers__(pRegisters) ((void)getcontext(pRegisters))
+extern void* il2c_get_current_thread_stack_base__(void);
+#endif
+
 #endif
 
 #ifdef __cplusplus
@@ -26,11 +26,18 @@ extern "C" {
 #define il2c_ixor(pDest, newValue) _InterlockedXor((interlock_t*)(pDest), (interlock_t)(newValue))
 #define il2c_iinc(pDest) _InterlockedIncrement((interlock_t*)(pDest))
 #define il2c_idec(pDest) _InterlockedDecrement((interlock_t*)(pDest))
+#define il2c_iadd(pDest, value) (_InterlockedExchangeAdd((interlock_t*)(pDest), (interlock_t)(value)) + (interlock_t)(value))
 #define il2c_ixchg(pDest, newValue) _InterlockedExchange((interlock_t*)(pDest), (interlock_t)(newValue))
 #define il2c_ixchgptr(ppDest, pNewValue) _InterlockedExchangePointer((void**)(ppDest), (void*)(pNewValue))
 #define il2c_icmpxchg(pDest, newValue, comperandValue) _InterlockedCompareExchange((interlock_t*)(pDest), (interlock_t)(newValue), (interlock_t)(comperandValue))
 #define il2c_icmpxchgptr(ppDest, pNewValue, pComperandValue) _InterlockedCompareExchangePointer((void**)(ppDest), (void*)(pNewValue), (void*)(pComperandValue))
 #define il2c_memory_barrier() MemoryBarrier()
+#if defined(_M_IX86) || defined(_M_X64)
+#include <xmmintrin.h>
+#define il2c_prefetch(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define il2c_prefetch(p) ((void)(p))
+#endif
 
 #endif
 
@@ -55,4 +55,13 @@ void il2c_initialize_monitor_lock__(IL2C_MONITOR_LOCK* pLock)
     pthread_mutex_init(pLock, &attr);
 }
 
+void il2c_wait_semaphore__(IL2C_SEMAPHORE* pSemaphore)
+{
+    // Retry if interrupted by the signal.
+    while (sem_wait(pSemaphore) != 0)
+    {
+        il2c_assert(errno == EINTR);
+    }
+}
+
 #endif
@@ -46,6 +46,16 @@ extern void il2c_initialize_monitor_lock__(IL2C_MONITOR_LOCK* pLock);
 #define il2c_exit_monitor_lock__(pLock) pthread_mutex_unlock(pLock)
 #define il2c_destroy_monitor_lock__(pLock) pthread_mutex_destroy(pLock)
 
+#define IL2C_USE_SEMAPHORE
+#include <errno.h>
+#include <semaphore.h>
+
+typedef sem_t IL2C_SEMAPHORE;
+#define il2c_initialize_semaphore__(pSemaphore) sem_init(pSemaphore, 0, 0)
+extern void il2c_wait_semaphore__(IL2C_SEMAPHORE* pSemaphore);
+#define il2c_release_semaphore__(pSemaphore) sem_post(pSemaphore)
+#define il2c_destroy_semaphore__(pSemaphore) sem_destroy(pSemaphore)
+
 #endif
 
 #ifdef __cplusplus
@@ -33,6 +33,23 @@ void il2c_shutdown(void)
 //////////////////////////////////////////////////
 // Win32 API threading support
 
+uint32_t il2c_get_processor_count__(void)
+{
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return (uint32_t)systemInfo.dwNumberOfProcessors;
+}
+
+uint64_t il2c_get_monotonic_microseconds__(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000U +
+        (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000U / (uint64_t)frequency.QuadPart;
+}
+
 intptr_t il2c_get_current_thread__(void)
 {
     HANDLE processHandle = GetCurrentProcess();
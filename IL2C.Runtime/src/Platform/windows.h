@@ -17,6 +17,9 @@ extern "C" {
 #define WIN32_LEAN_AND_MEAN
 #define _CRT_SECURE_NO_WARNINGS 1
 
+#define IL2C_USE_GETENV
+#define IL2C_USE_FILE_IO
+
 #include "heap.h"
 
 #include <windows.h>
@@ -38,6 +41,14 @@ extern "C" {
 
 #define il2c_sleep(milliseconds) Sleep((DWORD)milliseconds)
 
+// The heap segments and the large object space are backed by the committed pages (zero-filled when committed.)
+#define IL2C_USE_PAGE_ALLOCATOR
+#define il2c_page_allocate__(size) VirtualAlloc(NULL, (size), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE)
+#define il2c_page_free__(p, size) ((void)(size), (void)VirtualFree((p), 0, MEM_RELEASE))
+#define IL2C_USE_PAGE_DECOMMIT
+#define il2c_page_decommit__(p, size) ((void)VirtualFree((p), (size), MEM_DECOMMIT))
+#define il2c_page_commit__(p, size) (VirtualAlloc((p), (size), MEM_COMMIT, PAGE_READWRITE) != NULL)
+
 //////////////////////////////////////////////////
 // Win32 API threading support
 
@@ -67,6 +78,18 @@ typedef CRITICAL_SECTION IL2C_MONITOR_LOCK;
 #define il2c_exit_monitor_lock__(pLock) LeaveCriticalSection(pLock)
 #define il2c_destroy_monitor_lock__(pLock) DeleteCriticalSection(pLock)
 
+#define IL2C_USE_SEMAPHORE
+typedef HANDLE IL2C_SEMAPHORE;
+#define il2c_initialize_semaphore__(pSemaphore) (*(pSemaphore) = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL))
+#define il2c_wait_semaphore__(pSemaphore) WaitForSingleObject(*(pSemaphore), INFINITE)
+#define il2c_release_semaphore__(pSemaphore) ReleaseSemaphore(*(pSemaphore), 1, NULL)
+#define il2c_destroy_semaphore__(pSemaphore) CloseHandle(*(pSemaphore))
+
+extern uint32_t il2c_get_processor_count__(void);
+
+#define IL2C_USE_MONOTONIC_CLOCK
+extern uint64_t il2c_get_monotonic_microseconds__(void);
+
 #endif
 
 #ifdef __cplusplus
@@ -71,11 +71,16 @@ System_Array* il2c_new_array__(
 
     // -1 is "uint8_t Item[1]"
     const uintptr_t size = (uintptr_t)sizeof(System_Array) + ((uintptr_t)length) * elementSize;
+
+    // The array of the pointer-free value type (ex: byte[]) is never scanned by the GC.
+    const bool pointerFree =
+        (elementType->flags & (IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE)) == (IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE);
     
 #if defined(IL2C_USE_LINE_INFORMATION)
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         il2c_typeof(System_Array),
         size,
+        pointerFree,
         pFile,
         line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -83,7 +88,8 @@ System_Array* il2c_new_array__(
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         il2c_typeof(System_Array),
-        size);
+        size,
+        pointerFree);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -109,6 +115,12 @@ static void System_Array_MarkHandler__(System_Array* arr)
     il2c_assert(arr != NULL);
     il2c_assert(arr->vptr0__ == &System_Array_VTABLE__);
 
+    // The pointer-free array isn't traced, but the mark handler can be invoked directly.
+    if ((arr->elementType__->flags & (IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE)) == (IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE))
+    {
+        return;
+    }
+
     intptr_t index;
     if (arr->elementType__->flags & IL2C_TYPE_VALUE)
     {
@@ -69,7 +69,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_Boolean);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Boolean,
     "System.Boolean",
-    IL2C_TYPE_UNSIGNED_INTEGER,
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Boolean),
     System_ValueType,
     0, 0)
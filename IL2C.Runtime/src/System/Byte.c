@@ -67,7 +67,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_Byte);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Byte,
     "System.Byte",
-    IL2C_TYPE_UNSIGNED_INTEGER,
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Byte),
     System_ValueType,
     0, 0)
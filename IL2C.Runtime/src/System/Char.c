@@ -61,7 +61,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_Char);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Char,
     "System.Char",
-    IL2C_TYPE_UNSIGNED_INTEGER,
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Char),
     System_ValueType,
     0, 0)
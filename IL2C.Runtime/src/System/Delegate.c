@@ -92,6 +92,7 @@ System_Delegate* System_Delegate_Combine__System_Delegate_System_Delegate(System
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         pHeaderA->type,
         size,
+        false,
         __FILE__,
         __LINE__);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -99,7 +100,8 @@ System_Delegate* System_Delegate_Combine__System_Delegate_System_Delegate(System
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         pHeaderA->type,
-        size);
+        size,
+        false);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -178,6 +180,7 @@ System_Delegate* System_Delegate_Remove__System_Delegate_System_Delegate(System_
             IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
                 pHeaderSource->type,
                 size,
+                false,
                 __FILE__,
                 __LINE__);
             IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -185,7 +188,8 @@ System_Delegate* System_Delegate_Remove__System_Delegate_System_Delegate(System_
 #else
             IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
                 pHeaderSource->type,
-                size);
+                size,
+                false);
             IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -229,6 +233,7 @@ System_Delegate* il2c_new_delegate__(
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         delegateType,
         sizeof(System_Delegate),
+        false,
         pFile,
         line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -236,7 +241,8 @@ System_Delegate* il2c_new_delegate__(
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         delegateType,
-        sizeof(System_Delegate));
+        sizeof(System_Delegate),
+        false);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
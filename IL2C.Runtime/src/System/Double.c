@@ -70,7 +70,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_Double);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Double,
     "System.Double",
-    IL2C_TYPE_VALUE,
+    IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Double),
     System_ValueType,
     0, 0)
@@ -14,6 +14,7 @@ void System_Exception__ctor__System_String(System_Exception* this__, System_Stri
 
     // The message argument doesn't check
     this__->message__ = message;
+    il2c_write_barrier(this__);
 }
 
 System_String* System_Exception_get_Message(System_Exception* this__)
@@ -1,8 +1,6 @@
 #include "il2c_private.h"
 #include <System/GC.h>
 
-extern volatile uint32_t g_PendingRemains__;
-
 /////////////////////////////////////////////////////////////
 // System.GC
 
@@ -25,20 +23,75 @@ void System_GC_ReRegisterForFinalize__System_Object(System_Object* obj)
     IL2C_REF_HEADER* pHeader = il2c_get_header__(obj);
 
     // TODO: Check overriding finalizer.
-    il2c_iand(&pHeader->characteristic, ~IL2C_CHARACTERISTIC_FINALIZER_CALLED);
+    // The collection dropped it from the finalizable list if the finalizer was called or suppressed.
+    if (il2c_iand(&pHeader->characteristic, ~IL2C_CHARACTERISTIC_FINALIZER_CALLED) &
+        IL2C_CHARACTERISTIC_FINALIZER_CALLED)
+    {
+        il2c_register_finalizable__(obj);
+    }
 }
 
 void System_GC_Collect(void)
 {
+    il2c_request_full_collection__();
+    il2c_request_compaction__();
+    il2c_collect();
+}
+
+void System_GC_Collect__System_Int32(int32_t generation)
+{
+    // Generation 0 is the minor collection.
+    if (generation >= 1)
+    {
+        il2c_request_full_collection__();
+        il2c_request_compaction__();
+    }
     il2c_collect();
 }
 
 void System_GC_WaitForPendingFinalizers(void)
 {
-    while (g_PendingRemains__ >= 1)
+    il2c_wait_for_pending_finalizers__();
+}
+
+int32_t System_GC_CollectionCount__System_Int32(int32_t generation)
+{
+    // TODO: ArgumentOutOfRangeException
+    il2c_assert(generation >= 0);
+
+    IL2C_GC_STATISTICS statistics;
+    il2c_get_gc_statistics(&statistics);
+
+    // Generation 0 counts the full collections too, and the full collection collects generation 1 and later.
+    return (int32_t)((generation == 0) ? statistics.collections : statistics.fullCollections);
+}
+
+int64_t System_GC_GetTotalMemory__System_Boolean(bool forceFullCollection)
+{
+    if (forceFullCollection)
     {
-        il2c_collect();
+        System_GC_Collect();
+        System_GC_WaitForPendingFinalizers();
+
+        // The surviving bytes are fixed after swept.
+        il2c_heap_sweep_pending__(UINTPTR_MAX);
     }
+
+    IL2C_GC_STATISTICS statistics;
+    il2c_get_gc_statistics(&statistics);
+
+    return (int64_t)statistics.heapBytes;
+}
+
+int64_t System_GC_GetTotalAllocatedBytes__System_Boolean(bool precise)
+{
+    // The allocator accounts each allocation, so it's always precise.
+    ((void)precise);
+
+    IL2C_GC_STATISTICS statistics;
+    il2c_get_gc_statistics(&statistics);
+
+    return (int64_t)statistics.allocatedBytes;
 }
 
 /////////////////////////////////////////////////
@@ -65,7 +65,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_Int16);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Int16,
     "System.Int16",
-    IL2C_TYPE_INTEGER,
+    IL2C_TYPE_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Int16),
     System_ValueType,
     0, 0)
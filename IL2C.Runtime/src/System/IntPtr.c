@@ -52,7 +52,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_IntPtr);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_IntPtr,
     "System.IntPtr",
-    IL2C_TYPE_INTEGER,
+    IL2C_TYPE_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_IntPtr),
     System_ValueType,
     0, 0)
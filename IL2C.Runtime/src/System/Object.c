@@ -15,6 +15,13 @@ int32_t System_Object_GetHashCode(System_Object* this__)
 {
     il2c_assert(this__ != NULL);
 
+    // The hash code is the address, so the compaction can't move this instance.
+    IL2C_REF_HEADER* pHeader = il2c_get_header__(this__);
+    if (il2c_unlikely__((pHeader->characteristic & (IL2C_CHARACTERISTIC_PINNED | IL2C_CHARACTERISTIC_CONST)) == 0))
+    {
+        il2c_ior(&pHeader->characteristic, IL2C_CHARACTERISTIC_PINNED);
+    }
+
     return (int32_t)(intptr_t)this__;
 }
 
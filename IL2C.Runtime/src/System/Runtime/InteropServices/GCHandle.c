@@ -4,33 +4,36 @@
 /////////////////////////////////////////////////////////////
 // System.Runtime.InteropServices.GCHandle
 
+// The GCHandle value is the root reference handle (the slot index based, zero is not allocated.)
+
 System_Object* System_Runtime_InteropServices_GCHandle_get_Target(System_Runtime_InteropServices_GCHandle* this__)
 {
     il2c_assert(this__ != NULL);
-    return (System_Object*)*this__;
+
+    // TODO: InvalidOperationException
+    il2c_assert(*this__ != 0);
+
+    return il2c_get_root_reference__((uintptr_t)*this__, true);
 }
 
 void System_Runtime_InteropServices_GCHandle_set_Target__System_Object(System_Runtime_InteropServices_GCHandle* this__, System_Object* value)
 {
-    System_Runtime_InteropServices_GCHandle_Free(this__);
+    il2c_assert(this__ != NULL);
 
-    if (value != NULL)
-    {
-        il2c_register_root_reference__(value, true);
-    }
+    // TODO: InvalidOperationException
+    il2c_assert(*this__ != 0);
 
-    *this__ = (intptr_t)value;
+    il2c_set_root_reference__((uintptr_t)*this__, value, true);
 }
 
 void System_Runtime_InteropServices_GCHandle_Free(System_Runtime_InteropServices_GCHandle* this__)
 {
     il2c_assert(this__ != NULL);
 
-    System_Object* pObject = (System_Object*)*this__;
-    if (pObject != NULL)
-    {
-        il2c_unregister_root_reference__(pObject, true);
-    }
+    // TODO: InvalidOperationException
+    il2c_assert(*this__ != 0);
+
+    il2c_unregister_root_reference__((uintptr_t)*this__, true);
 
     *this__ = 0;
 }
@@ -40,29 +43,23 @@ intptr_t System_Runtime_InteropServices_GCHandle_AddrOfPinnedObject(System_Runti
     il2c_assert(this__ != NULL);
 
     // TODO: It has to reinterpret for required pointer. ex: System_String --> string_body__
-    return (intptr_t)*this__;
+    return (intptr_t)System_Runtime_InteropServices_GCHandle_get_Target(this__);
 }
 
 System_Runtime_InteropServices_GCHandle System_Runtime_InteropServices_GCHandle_Alloc__System_Object(System_Object* value)
 {
-    // intptr_t aliased
-    return (System_Runtime_InteropServices_GCHandle)value;
+    return System_Runtime_InteropServices_GCHandle_Alloc__System_Object_System_Runtime_InteropServices_GCHandleType(
+        value, System_Runtime_InteropServices_GCHandleType_Normal);
 }
 
 System_Runtime_InteropServices_GCHandle System_Runtime_InteropServices_GCHandle_Alloc__System_Object_System_Runtime_InteropServices_GCHandleType(
     System_Object* value, System_Runtime_InteropServices_GCHandleType type)
 {
-    if ((type == System_Runtime_InteropServices_GCHandleType_Normal) ||
-        (type == System_Runtime_InteropServices_GCHandleType_Pinned))
-    {
-        if (value != NULL)
-        {
-            il2c_register_root_reference__(value, true);
-        }
-    }
-
-    // intptr_t aliased
-    return (System_Runtime_InteropServices_GCHandle)value;
+    // TODO: Weak handles (GCHandleType.Weak and WeakTrackResurrection aren't declared.)
+    il2c_assert((type == System_Runtime_InteropServices_GCHandleType_Normal) ||
+        (type == System_Runtime_InteropServices_GCHandleType_Pinned));
+
+    return (System_Runtime_InteropServices_GCHandle)il2c_register_root_reference__(value, true);
 }
 
 int32_t System_Runtime_InteropServices_GCHandle_GetHashCode(System_Runtime_InteropServices_GCHandle* this__)
@@ -109,7 +106,7 @@ System_Runtime_InteropServices_GCHandle_VTABLE_DECL__ System_Runtime_InteropServ
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Runtime_InteropServices_GCHandle,
     "System.Runtime.InteropServices.GCHandle",
-    IL2C_TYPE_VALUE,
+    IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Runtime_InteropServices_GCHandle),
     System_ValueType,
     0, 0)
@@ -7,7 +7,7 @@
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Runtime_InteropServices_NativePointer,
     "System.Runtime.InteropServices.NativePointer",
-    IL2C_TYPE_VALUE,
+    IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Runtime_InteropServices_NativePointer),
     System_ValueType,
     0, 0)
@@ -67,7 +67,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_SByte);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_SByte,
     "System.SByte",
-    IL2C_TYPE_INTEGER,
+    IL2C_TYPE_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_SByte),
     System_ValueType,
     0, 0)
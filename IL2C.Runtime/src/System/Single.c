@@ -70,7 +70,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_Single);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_Single,
     "System.Single",
-    IL2C_TYPE_VALUE,
+    IL2C_TYPE_VALUE | IL2C_TYPE_POINTER_FREE,
     sizeof(System_Single),
     System_ValueType,
     0, 0)
@@ -44,6 +44,7 @@ static System_String* new_string_internal__(uintptr_t byteSize)
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         il2c_typeof(System_String),
         bodySize,
+        true,
         pFile,
         line);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__(
@@ -51,7 +52,8 @@ static System_String* new_string_internal__(uintptr_t byteSize)
 #else
     IL2C_REF_HEADER* pHeader = il2c_get_uninitialized_object_internal__(
         il2c_typeof(System_String),
-        bodySize);
+        bodySize,
+        true);
     IL2C_THREAD_CONTEXT* pThreadContext = il2c_acquire_thread_context__();
 #endif
 
@@ -581,7 +583,7 @@ System_String* System_String_Concat__System_String_System_String_System_String(S
     memcpy(((uint8_t*)(pString->string_body__)) + str0Size, str1->string_body__, str1Size);
     memcpy(((uint8_t*)(pString->string_body__)) + str0Size + str1Size, str2->string_body__, str2Size + sizeof(wchar_t));
 
-    il2c_return_with_objref(pString);
+    return pString;
 }
 
 System_String* System_String_Substring__System_Int32(System_String* this__, int32_t startIndex)
@@ -611,7 +613,7 @@ System_String* System_String_Substring__System_Int32(System_String* this__, int3
 
     memcpy((wchar_t*)(pString->string_body__), this__->string_body__ + startIndex, newSize);
 
-    il2c_return_with_objref(pString);
+    return pString;
 }
 
 System_String* System_String_Substring__System_Int32_System_Int32(System_String* this__, int32_t startIndex, int32_t length)
@@ -643,7 +645,7 @@ System_String* System_String_Substring__System_Int32_System_Int32(System_String*
     memcpy((wchar_t*)(pString->string_body__), this__->string_body__ + startIndex, newSize);
     ((wchar_t*)(pString->string_body__))[length] = L'\0';
 
-    il2c_return_with_objref(pString);
+    return pString;
 }
 
 wchar_t System_String_get_Chars__System_Int32(System_String* this__, int32_t index)
@@ -1113,7 +1115,7 @@ System_String_VTABLE_DECL__ System_String_VTABLE__ = {
 IL2C_RUNTIME_TYPE_BEGIN(
     System_String,
     "System.String",
-    IL2C_TYPE_REFERENCE | IL2C_TYPE_VARIABLE,
+    IL2C_TYPE_REFERENCE | IL2C_TYPE_VARIABLE | IL2C_TYPE_POINTER_FREE,
     0,
     System_Object,
     0, 0)
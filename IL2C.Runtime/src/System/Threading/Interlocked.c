@@ -5,7 +5,15 @@
 
 void* System_Threading_Interlocked_CompareExchange_6(void* location1, void* value, void* comparand)
 {
-    return il2c_icmpxchgptr(location1, value, comparand);
+    void* pCurrent = il2c_icmpxchgptr(location1, value, comparand);
+
+    // The location may be the field in the heap (ex: the event field), it's stored only if exchanged.
+    if (pCurrent == comparand)
+    {
+        il2c_write_barrier_for_address(location1);
+    }
+
+    return pCurrent;
 }
 
 /////////////////////////////////////////////////
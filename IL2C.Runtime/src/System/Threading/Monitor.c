@@ -285,6 +285,19 @@ void il2c_release_all_monitor_lock_for_final_shutdown__(void)
 /////////////////////////////////////////////////////////////
 // System.Threading.Monitor
 
+// The owner may be stopped at the safepoint, so the GC can't wait for the contended thread.
+static void il2c_enter_monitor_lock_in_safe_region__(IL2C_MONITOR_LOCK* pLock)
+{
+    if (il2c_likely__(il2c_try_enter_monitor_lock__(pLock)))
+    {
+        return;
+    }
+
+    const bool entered = il2c_enter_safe_region();
+    il2c_enter_monitor_lock__(pLock);
+    il2c_leave_safe_region(entered);
+}
+
 void System_Threading_Monitor_Enter__System_Object(System_Object* obj)
 {
     // TODO: ArgumentNullException
@@ -293,7 +306,7 @@ void System_Threading_Monitor_Enter__System_Object(System_Object* obj)
     IL2C_MONITOR_LOCK* pLock = il2c_acquire_monitor_lock_from_objref__(obj, true);
     il2c_assert(pLock != NULL);
 
-    il2c_enter_monitor_lock__(pLock);
+    il2c_enter_monitor_lock_in_safe_region__(pLock);
 }
 
 void System_Threading_Monitor_Enter__System_Object_System_Boolean_REF(System_Object* obj, bool* lockTaken)
@@ -306,7 +319,7 @@ void System_Threading_Monitor_Enter__System_Object_System_Boolean_REF(System_Obj
     IL2C_MONITOR_LOCK* pLock = il2c_acquire_monitor_lock_from_objref__(obj, true);
     il2c_assert(pLock != NULL);
 
-    il2c_enter_monitor_lock__(pLock);
+    il2c_enter_monitor_lock_in_safe_region__(pLock);
 
     // TODO: DANGER SECTION: cannot interrupt thread at this line.
 
@@ -16,16 +16,6 @@ void System_Threading_Thread_Finalize(System_Threading_Thread* this__)
     {
         il2c_close_thread_handle__(pRuntimeThread->context.rawHandle);
 
-#if !defined(IL2C_USE_RUNTIME_GIANT_LOCK)
-        // HACK: The finalizer is called from GC processes,
-        //   so the lock already acquired at beginning collection (il2c_enter_for_collect__).
-        //   And, all instance's lock except thread are freeing at il2c_exit_for_collect__(),
-        //   but the thread instance will free and cannot find in it.
-        il2c_exit_monitor_lock__((void*)&pRuntimeThread->context.lockForCollect);
-#endif
-
-        il2c_destroy_monitor_lock__((void*)&pRuntimeThread->context.lockForCollect);
-
 #if defined(_DEBUG)
         pRuntimeThread->context.rawHandle = -1;
         pRuntimeThread->context.id = 0;
@@ -60,6 +50,7 @@ static IL2C_THREAD_ENTRY_POINT_RESULT_TYPE System_Threading_Thread_InternalEntry
 
     // Set real thread id.
     pRuntimeThread->context.id = il2c_get_current_thread_id__();
+    il2c_attach_native_stack__(&pRuntimeThread->context);
 
     // Save IL2C_THREAD_CONTEXT into tls.
     il2c_set_tls_value(g_TlsIndex__, (void*)&pRuntimeThread->context.pFrame);
@@ -96,8 +87,11 @@ exit:
     il2c_set_tls_value(g_TlsIndex__, NULL);
 #endif
 
+    // Give back the thread local allocation buffers.
+    il2c_retire_thread_context__(&pRuntimeThread->context);
+
     // Unregister GC root tracking.
-    il2c_unregister_root_reference__((void*)pRuntimeThread, false);
+    il2c_unregister_root_reference__(pRuntimeThread->rootReferenceHandle, false);
 
     IL2C_THREAD_ENTRY_POINT_RETURN(0);
 }
@@ -117,6 +111,7 @@ static IL2C_THREAD_ENTRY_POINT_RESULT_TYPE System_Threading_Thread_InternalEntry
 
     // Set real thread id.
     pRuntimeThread->context.id = il2c_get_current_thread_id__();
+    il2c_attach_native_stack__(&pRuntimeThread->context);
 
     // Save IL2C_THREAD_CONTEXT into tls.
     il2c_set_tls_value(g_TlsIndex__, (void*)&pRuntimeThread->context.pFrame);
@@ -153,8 +148,11 @@ exit:
     il2c_set_tls_value(g_TlsIndex__, NULL);
 #endif
 
+    // Give back the thread local allocation buffers.
+    il2c_retire_thread_context__(&pRuntimeThread->context);
+
     // Unregister GC root tracking.
-    il2c_unregister_root_reference__((void*)pRuntimeThread, false);
+    il2c_unregister_root_reference__(pRuntimeThread->rootReferenceHandle, false);
 
     IL2C_THREAD_ENTRY_POINT_RETURN(0);
 }
@@ -172,7 +170,7 @@ void System_Threading_Thread_Start(System_Threading_Thread* this__)
     il2c_assert(pRuntimeThread->context.rawHandle == -1);
 
     // Register GC root tracking.
-    il2c_register_root_reference__(this__, false);
+    pRuntimeThread->rootReferenceHandle = il2c_register_root_reference__(this__, false);
 
     // Create (suspended if available) thread.
     intptr_t rawHandle = il2c_create_thread__(
@@ -199,10 +197,11 @@ void System_Threading_Thread_Start__System_Object(System_Threading_Thread* this_
     il2c_assert(pRuntimeThread->context.rawHandle == -1);
 
     // Register GC root tracking.
-    il2c_register_root_reference__(this__, false);
+    pRuntimeThread->rootReferenceHandle = il2c_register_root_reference__(this__, false);
 
     // Store parameter
     pRuntimeThread->parameter = parameter;
+    il2c_write_barrier(this__);
 
     // Create (suspended if available) thread.
     intptr_t rawHandle = il2c_create_thread__(
@@ -225,7 +224,9 @@ void System_Threading_Thread_Join(System_Threading_Thread* this__)
     il2c_assert(this__->start__ != NULL);
     il2c_assert(pRuntimeThread->context.rawHandle >= 0);
 
+    const bool entered = il2c_enter_safe_region();
     il2c_join_thread__(pRuntimeThread->context.rawHandle);
+    il2c_leave_safe_region(entered);
 }
 
 int32_t System_Threading_Thread_get_ManagedThreadId(System_Threading_Thread* this__)
@@ -251,7 +252,9 @@ System_Threading_Thread* System_Threading_Thread_get_CurrentThread(void)
 
 void System_Threading_Thread_Sleep__System_Int32(int millisecondsTimeout)
 {
+    const bool entered = il2c_enter_safe_region();
     il2c_sleep((uint32_t)millisecondsTimeout);
+    il2c_leave_safe_region(entered);
 }
 
 /////////////////////////////////////////////////
@@ -291,6 +294,11 @@ static void System_Threading_Thread_MarkHandler__(System_Threading_Thread* threa
     {
         il2c_default_mark_handler_for_tracking_information__(pRuntimeThread->context.pFrame);
     }
+
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+    // The translated code holds the objrefs in the native stack and the registers.
+    il2c_mark_native_stack__(&pRuntimeThread->context);
+#endif
 }
 
 System_Threading_Thread_VTABLE_DECL__ System_Threading_Thread_VTABLE__ = {
@@ -9,10 +9,22 @@ void System_Threading_ThreadStart_Invoke(System_Threading_ThreadStart* this__)
     il2c_assert(this__->vptr0__ == &System_Delegate_VTABLE__);
     il2c_assert(this__->count__ >= 1);
 
+    // The thread entry point calls it, the frame holds the delegate and the current target.
+    struct
+    {
+        const IL2C_EXECUTION_FRAME* pNext__;
+        const uint16_t objRefCount__;
+        const uint16_t valueCount__;
+        System_Threading_ThreadStart* pDelegate;
+        void* target;
+    } frame__ = { NULL, 2, 0, this__ };
+    il2c_link_execution_frame(&frame__);
+
     uintptr_t index = 0;
     do
     {
         IL2C_METHOD_TABLE* pMethodtbl = &this__->methodtbl__[index];
+        frame__.target = pMethodtbl->target;
         if (pMethodtbl->target != NULL)
             ((void (*)(void*))(pMethodtbl->methodPtr))(pMethodtbl->target);
         else
@@ -20,6 +32,8 @@ void System_Threading_ThreadStart_Invoke(System_Threading_ThreadStart* this__)
         index++;
     }
     while (il2c_unlikely__(index < this__->count__));
+
+    il2c_unlink_execution_frame(&frame__, NULL);
 }
 
 /////////////////////////////////////////////////
@@ -67,7 +67,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_UInt16);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_UInt16,
     "System.UInt16",
-    IL2C_TYPE_UNSIGNED_INTEGER, 
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_UInt16),
     System_ValueType, 0, 0)
 IL2C_RUNTIME_TYPE_END();
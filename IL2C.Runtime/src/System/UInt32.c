@@ -63,7 +63,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_UInt32);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_UInt32,
     "System.UInt32",
-    IL2C_TYPE_UNSIGNED_INTEGER,
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_UInt32),
     System_ValueType, 0, 0)
 IL2C_RUNTIME_TYPE_END();
@@ -63,7 +63,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_UInt64);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_UInt64,
     "System.UInt64",
-    IL2C_TYPE_UNSIGNED_INTEGER,
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_UInt64),
     System_ValueType,
     0, 0)
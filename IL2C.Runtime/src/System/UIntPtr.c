@@ -52,7 +52,7 @@ IL2C_DECLARE_TRAMPOLINE_VTABLE_FOR_VALUE_TYPE(System_UIntPtr);
 IL2C_RUNTIME_TYPE_BEGIN(
     System_UIntPtr,
     "System.UIntPtr",
-    IL2C_TYPE_UNSIGNED_INTEGER,
+    IL2C_TYPE_UNSIGNED_INTEGER | IL2C_TYPE_POINTER_FREE,
     sizeof(System_UIntPtr),
     System_ValueType,
     0, 0)
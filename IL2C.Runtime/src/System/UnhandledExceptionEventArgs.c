@@ -8,6 +8,7 @@ void System_UnhandledExceptionEventArgs__ctor__System_Object_System_Boolean(
 {
     this__->exception__ = exception;
     this__->isTerminating__ = isTerminating;
+    il2c_write_barrier(this__);
 }
 
 System_Object* System_UnhandledExceptionEventArgs_get_ExceptionObject(System_UnhandledExceptionEventArgs* this__)
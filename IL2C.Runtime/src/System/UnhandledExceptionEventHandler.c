@@ -10,10 +10,24 @@ void System_UnhandledExceptionEventHandler_Invoke(
     il2c_assert(this__->vptr0__ == &System_Delegate_VTABLE__);
     il2c_assert(this__->count__ >= 1);
 
+    // The runtime calls it, the frame holds the delegate, the current target and the arguments.
+    struct
+    {
+        const IL2C_EXECUTION_FRAME* pNext__;
+        const uint16_t objRefCount__;
+        const uint16_t valueCount__;
+        System_UnhandledExceptionEventHandler* pDelegate;
+        void* target;
+        System_Object* sender;
+        System_UnhandledExceptionEventArgs* e;
+    } frame__ = { NULL, 4, 0, this__, NULL, sender, e };
+    il2c_link_execution_frame(&frame__);
+
     uintptr_t index = 0;
     do
     {
         IL2C_METHOD_TABLE* pMethodtbl = &this__->methodtbl__[index];
+        frame__.target = pMethodtbl->target;
         if (pMethodtbl->target != NULL)
             ((void (*)(void*, System_Object*, System_UnhandledExceptionEventArgs*))(pMethodtbl->methodPtr))(pMethodtbl->target, sender, e);
         else
@@ -21,6 +35,8 @@ void System_UnhandledExceptionEventHandler_Invoke(
         index++;
     }
     while (il2c_likely__(index < this__->count__));
+
+    il2c_unlink_execution_frame(&frame__, NULL);
 }
 
 /////////////////////////////////////////////////
@@ -32,6 +32,15 @@ typedef volatile long interlock_t;
 #include "Platform/linux.h"
 #include "Platform/arduino.h"
 
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+#if !defined(IL2C_USE_NATIVE_STACK_SCAN)
+#error "IL2C_USE_CONSERVATIVE_STACK_SCAN is supported on GCC x86-64/AArch64 Linux only."
+#endif
+#if defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+#error "IL2C_USE_CONSERVATIVE_STACK_SCAN requires the safepoints, can't use with IL2C_USE_RUNTIME_GIANT_LOCK."
+#endif
+#endif
+
 #if defined(IL2C_USE_RUNTIME_DEBUG_LOG)
 extern void il2c_runtime_debug_log(const wchar_t* message);
 extern void il2c_runtime_debug_log_format(const wchar_t* format, ...);
@@ -67,10 +76,13 @@ typedef const struct IL2C_VALUE_DESCRIPTOR_DECL
 
 typedef volatile struct IL2C_ROOT_REFERENCES_DECL IL2C_ROOT_REFERENCES;
 
+#define IL2C_ROOT_REFERENCES_SLAB_SIZE 64
+
 struct IL2C_ROOT_REFERENCES_DECL
 {
     IL2C_ROOT_REFERENCES* pNext;
-    volatile System_Object* pReferences[3];
+    volatile System_Object* pReferences[IL2C_ROOT_REFERENCES_SLAB_SIZE];
+    uintptr_t freeHandles[IL2C_ROOT_REFERENCES_SLAB_SIZE];   // The free list (doesn't refer by the GC.)
 };
 
 typedef volatile struct IL2C_GC_TRACKING_INFORMATION_DECL
@@ -126,9 +138,13 @@ struct IL2C_RUNTIME_TYPE_DECL
 //};
 
 // IL2C_REF_HEADER_DECL.characteristic
+#define IL2C_CHARACTERISTIC_FORWARDED ((interlock_t)0x00800000UL)       // Moved by the compaction, the type field is the new header
+#define IL2C_CHARACTERISTIC_PINNED ((interlock_t)0x01000000UL)          // The compaction never moves (the identity hash code is taken)
+#define IL2C_CHARACTERISTIC_POINTER_FREE ((interlock_t)0x02000000UL)    // The instance doesn't contain any objrefs (never traced)
+#define IL2C_CHARACTERISTIC_REMEMBERED ((interlock_t)0x04000000UL)      // The old instance is in the remembered set
 #define IL2C_CHARACTERISTIC_ACQUIRED_MONITOR_LOCK ((interlock_t)0x08000000UL)
 #define IL2C_CHARACTERISTIC_FINALIZER_CALLED ((interlock_t)0x10000000UL)
-#define IL2C_CHARACTERISTIC_MARK_INDEX ((interlock_t)0x20000000UL)      // Mark index is only 0 or 1.
+#define IL2C_CHARACTERISTIC_LARGE_OBJECT ((interlock_t)0x20000000UL)    // Allocated by the large object space
 #define IL2C_CHARACTERISTIC_INITIALIZED ((interlock_t)0x40000000UL)     // GC will ignore sweeping if not initialized
 #define IL2C_CHARACTERISTIC_CONST ((interlock_t)0x80000000UL)
 
@@ -179,10 +195,154 @@ typeName##_VTABLE_DECL__ typeName##_VTABLE__ = { \
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <limits.h>
 
 ///////////////////////////////////////////////////
 // Internal runtime functions
 
+///////////////////////////////////////////////////
+// Managed heap
+
+// The managed heap is made from the segments (large pages) splitted into the blocks.
+// Each block stores same sized cells for one size class, and the GC sweeps the instances per block.
+// Larger instances than IL2C_HEAP_MAX_SMALL_SIZE are allocated by the large object space.
+
+#if !defined(IL2C_HEAP_BLOCK_SHIFT)
+#define IL2C_HEAP_BLOCK_SHIFT 16        // 64KB
+#endif
+#if !defined(IL2C_HEAP_SEGMENT_BLOCKS)
+#define IL2C_HEAP_SEGMENT_BLOCKS 16U    // 1MB
+#endif
+
+#define IL2C_HEAP_BLOCK_SIZE (((uintptr_t)1U) << IL2C_HEAP_BLOCK_SHIFT)
+#define IL2C_HEAP_MAX_SMALL_SIZE (IL2C_HEAP_BLOCK_SIZE / 8U)
+#define IL2C_HEAP_MAX_SIZE_CLASSES 80U    // Contains the pointer-free space
+
+// The smallest cell size, each cell owns at least one mark bit.
+#define IL2C_HEAP_MARK_GRANULE 16U
+#define IL2C_HEAP_MARK_WORD_BITS ((uintptr_t)(sizeof(interlock_t) * 8U))
+#define IL2C_HEAP_MARK_WORDS \
+    ((IL2C_HEAP_BLOCK_SIZE / IL2C_HEAP_MARK_GRANULE + IL2C_HEAP_MARK_WORD_BITS - 1U) / IL2C_HEAP_MARK_WORD_BITS)
+
+typedef struct IL2C_HEAP_BLOCK_DECL IL2C_HEAP_BLOCK;
+
+struct IL2C_HEAP_BLOCK_DECL
+{
+    IL2C_HEAP_BLOCK* pNext;
+    IL2C_REF_HEADER* pFreeList;     // Free cells (linked by the first body word)
+    uint8_t* pBump;                 // Never allocated cells are placed from here
+    uint8_t* pLimit;                // End of cells
+    uint32_t cellSize;
+    uint32_t sizeClass;
+    uint32_t liveCells;             // Surviving cells at the last sweep
+    uint32_t young;                 // Contains the instances allocated since the last collection
+    uint32_t anchored;              // Contains the instances referred from the untracked places (never evacuated)
+    uint32_t evacuating;            // The live instances are moved out by the compaction
+    uint64_t releasedAt;            // The free block: released time in milliseconds (for the trimming)
+    void* pSegment;                 // The segment owning this block (IL2C_HEAP_SEGMENT)
+    interlock_t markBits[IL2C_HEAP_MARK_WORDS];   // One mark bit per granule
+};
+
+#define IL2C_HEAP_BLOCK_HEADER_SIZE \
+    ((sizeof(IL2C_HEAP_BLOCK) + 15U) & ~((uintptr_t)15U))
+#define il2c_heap_cells_of_block__(pBlock) \
+    (((uint8_t*)(pBlock)) + IL2C_HEAP_BLOCK_HEADER_SIZE)
+#define il2c_heap_block_of__(pHeader) \
+    ((IL2C_HEAP_BLOCK*)((uintptr_t)(pHeader) & ~(IL2C_HEAP_BLOCK_SIZE - 1U)))
+
+typedef struct IL2C_HEAP_LARGE_OBJECT_DECL IL2C_HEAP_LARGE_OBJECT;
+
+// Placed before the IL2C_REF_HEADER.
+struct IL2C_HEAP_LARGE_OBJECT_DECL
+{
+    IL2C_HEAP_LARGE_OBJECT* pNext;
+    IL2C_HEAP_LARGE_OBJECT* pPrev;
+    uintptr_t size;
+    interlock_t marked;             // The large instance has own mark word instead of the bitmap
+};
+
+#define il2c_heap_large_object_of__(pHeader) \
+    (((IL2C_HEAP_LARGE_OBJECT*)(pHeader)) - 1)
+
+// The large instance body is already cleared if it's placed on the fresh pages.
+#if defined(IL2C_USE_PAGE_ALLOCATOR)
+#define il2c_heap_is_zero_filled__(pHeader) \
+    (((pHeader)->characteristic & IL2C_CHARACTERISTIC_LARGE_OBJECT) != 0)
+#else
+#define il2c_heap_is_zero_filled__(pHeader) false
+#endif
+
+// The mark bits aren't stored in the instance header but in the side table,
+// so the marker doesn't dirty the headers scattered across the heap.
+// Get the mark word and the bit for the instance (not const):
+//   The small instance: the bitmap word in the block header (the cells never share the granule.)
+//   The large instance: the mark word in the large object header.
+#define il2c_heap_mark_word__(pHeader) \
+    (il2c_unlikely__((pHeader)->characteristic & IL2C_CHARACTERISTIC_LARGE_OBJECT) ? \
+        &il2c_heap_large_object_of__(pHeader)->marked : \
+        &il2c_heap_block_of__(pHeader)->markBits[ \
+            (((uintptr_t)(pHeader) & (IL2C_HEAP_BLOCK_SIZE - 1U)) / IL2C_HEAP_MARK_GRANULE) / IL2C_HEAP_MARK_WORD_BITS])
+#define il2c_heap_mark_bit__(pHeader) \
+    (il2c_unlikely__((pHeader)->characteristic & IL2C_CHARACTERISTIC_LARGE_OBJECT) ? \
+        (interlock_t)1 : \
+        (interlock_t)(((interlock_t)1) << \
+            ((((uintptr_t)(pHeader) & (IL2C_HEAP_BLOCK_SIZE - 1U)) / IL2C_HEAP_MARK_GRANULE) % IL2C_HEAP_MARK_WORD_BITS)))
+
+// The compaction doesn't evacuate the block if the instance on it is anchored.
+#define il2c_heap_anchor__(pHeader) \
+    do { \
+        if (((pHeader)->characteristic & (IL2C_CHARACTERISTIC_LARGE_OBJECT | IL2C_CHARACTERISTIC_CONST)) == 0) \
+            il2c_heap_block_of__(pHeader)->anchored = 1; \
+    } while (0)
+// Get the current header of the instance (the moved instance leaves the new header at the type field.)
+#define il2c_heap_forwarded__(pHeader) \
+    (il2c_unlikely__((pHeader)->characteristic & IL2C_CHARACTERISTIC_FORWARDED) ? \
+        (IL2C_REF_HEADER*)((pHeader)->type) : \
+        (pHeader))
+// Get the allocated size of the instance (includes the header.)
+#define il2c_heap_size_of__(pHeader) \
+    (il2c_unlikely__((pHeader)->characteristic & IL2C_CHARACTERISTIC_LARGE_OBJECT) ? \
+        il2c_heap_large_object_of__(pHeader)->size : \
+        (uintptr_t)il2c_heap_block_of__(pHeader)->cellSize)
+
+// The const instance is always marked.
+#define il2c_is_marked__(pHeader) \
+    (((pHeader)->characteristic & IL2C_CHARACTERISTIC_CONST) || \
+     (*il2c_heap_mark_word__(pHeader) & il2c_heap_mark_bit__(pHeader)))
+
+// The thread local allocation buffers (hung off IL2C_THREAD_CONTEXT.)
+// Each size class has the block owned by the thread, and allocates from it without any locks (the GC retires them after stopped the thread.)
+typedef struct IL2C_HEAP_ALLOCATION_CONTEXT_DECL
+{
+    IL2C_HEAP_BLOCK* pBlocks[IL2C_HEAP_MAX_SIZE_CLASSES];
+} IL2C_HEAP_ALLOCATION_CONTEXT;
+
+// Callback for il2c_heap_enumerate_unmarked__() and il2c_heap_enumerate_marked__()
+typedef void (*IL2C_HEAP_ENUMERATOR)(IL2C_REF_HEADER* pHeader, void* pContext);
+
+extern void il2c_heap_initialize__(void);
+extern void il2c_heap_shutdown__(void);
+extern IL2C_REF_HEADER* il2c_heap_allocate__(
+    IL2C_HEAP_ALLOCATION_CONTEXT* pAllocationContext, IL2C_RUNTIME_TYPE type, uintptr_t size, bool pointerFree);
+extern void il2c_heap_retire_allocation_context__(IL2C_HEAP_ALLOCATION_CONTEXT* pAllocationContext);
+extern void il2c_heap_enumerate_unmarked__(bool full, IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext);
+extern void il2c_heap_enumerate_marked__(IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext);
+extern bool il2c_heap_enumerate_marked_bounded__(
+    uintptr_t* pCursor, uintptr_t maxBlocks, IL2C_HEAP_ENUMERATOR pEnumerator, void* pContext);
+extern void il2c_heap_unmark_all__(void);
+extern uint8_t* g_pHeapLowerBound__;
+extern uint8_t* g_pHeapUpperBound__;
+extern IL2C_REF_HEADER* il2c_heap_find_object__(void* pAddress);
+extern uintptr_t il2c_heap_sweep__(bool full, uintptr_t* pLiveBytes);
+extern uintptr_t il2c_heap_select_evacuation_blocks__(uint32_t livePercent);
+extern uintptr_t il2c_heap_evacuate__(void);
+extern void il2c_heap_finish_evacuation__(void);
+extern void il2c_heap_begin_sweep__(bool full, bool background);
+extern bool il2c_heap_sweep_pending__(uintptr_t maxBlocks);
+extern void il2c_heap_finish_sweep__(void);
+extern uintptr_t il2c_heap_trim__(uint32_t delayMilliseconds);
+extern void il2c_heap_get_committed_bytes__(uintptr_t* pCommittedBytes, uintptr_t* pUsedBytes);
+
 typedef volatile struct IL2C_RUNTIME_THREAD_BOTTOM_EXECUTION_FRAME /* IL2C_EXECUTION_FRAME */
 {
     IL2C_EXECUTION_FRAME* pNext__;
@@ -197,8 +357,16 @@ typedef volatile struct IL2C_THREAD_CONTEXT_DECL
     IL2C_EXCEPTION_FRAME* pUnwindTarget;
     intptr_t rawHandle;
     System_Object* pTemporaryReferenceAnchor;
-    IL2C_MONITOR_LOCK lockForCollect;
+    interlock_t safepointState;
     int32_t id;
+    IL2C_HEAP_ALLOCATION_CONTEXT allocationContext;
+    intptr_t bytesUntilSample;      // For the allocation profiler
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+    // The GC scans [pStackPointer, pStackBase) and the registers, they're saved before PARKED or SAFE.
+    void* pStackBase;
+    void* pStackPointer;
+    IL2C_SAVED_REGISTERS savedRegisters;
+#endif
 } IL2C_THREAD_CONTEXT;
 
 // The real thread structure.
@@ -214,13 +382,43 @@ typedef volatile struct IL2C_RUNTIME_CREATED_THREAD
     IL2C_THREAD_CONTEXT context;
     System_Object* parameter;
     IL2C_RUNTIME_THREAD_BOTTOM_EXECUTION_FRAME bottomFrame;
+    uintptr_t rootReferenceHandle;
 } IL2C_RUNTIME_CREATED_THREAD;
 
-#if defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+// Safepoint: The GC stops the mutators at the safepoints (the method entry, the loop back-edges and the allocation.)
+//   The thread touches its own execution frames and allocation context without any locks while RUNNING,
+//   the GC waits until all threads are PARKED or SAFE, and the parked threads block on g_GlobalLockForCollect__.
+//   The thread is SAFE when it hasn't any execution frames or blocking inside the safe region.
+#define IL2C_SAFEPOINT_STATE_SAFE 0         // Default: The GC doesn't wait for the thread.
+#define IL2C_SAFEPOINT_STATE_RUNNING 1
+#define IL2C_SAFEPOINT_STATE_PARKED 2
+
+extern bool il2c_enter_safe_region__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern void il2c_leave_safe_region__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern void il2c_park_at_safepoint__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern void il2c_retire_thread_context__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern volatile int32_t g_SafepointOwnerId__;
 extern IL2C_MONITOR_LOCK g_GlobalLockForCollect__;
-#define IL2C_THREAD_LOCK_TARGET(pThreadContext) (((void)pThreadContext->lockForCollect), (&g_GlobalLockForCollect__))
+
+// Conservative stack scanning: The translated code doesn't link the execution frames,
+//   so the attached thread is RUNNING until retired (except inside the safe region.)
+#if defined(IL2C_USE_CONSERVATIVE_STACK_SCAN)
+extern void il2c_attach_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern void il2c_save_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern void il2c_detach_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext);
+extern void il2c_mark_native_stack__(IL2C_THREAD_CONTEXT* pThreadContext);
+#else
+#define il2c_attach_native_stack__(pThreadContext) ((void)0)
+#define il2c_save_native_stack__(pThreadContext) ((void)0)
+#define il2c_detach_native_stack__(pThreadContext) ((void)0)
+#endif
+
+#if defined(IL2C_USE_RUNTIME_GIANT_LOCK)
+#define il2c_enter_giant_lock__() il2c_enter_monitor_lock__(&g_GlobalLockForCollect__)
+#define il2c_exit_giant_lock__() il2c_exit_monitor_lock__(&g_GlobalLockForCollect__)
 #else
-#define IL2C_THREAD_LOCK_TARGET(pThreadContext) (&pThreadContext->lockForCollect)
+#define il2c_enter_giant_lock__() ((void)0)
+#define il2c_exit_giant_lock__() ((void)0)
 #endif
 
 #if defined(IL2C_USE_LINE_INFORMATION)
@@ -231,14 +429,71 @@ extern IL2C_THREAD_CONTEXT* il2c_acquire_thread_context__(void);
 
 #if defined(IL2C_USE_LINE_INFORMATION)
 extern IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
-    IL2C_RUNTIME_TYPE type, uintptr_t bodySize, const char* pFile, int line);
+    IL2C_RUNTIME_TYPE type, uintptr_t bodySize, bool pointerFree, const char* pFile, int line);
 #else
 extern IL2C_REF_HEADER* il2c_get_uninitialized_object_internal__(
-    IL2C_RUNTIME_TYPE type, uintptr_t bodySize);
+    IL2C_RUNTIME_TYPE type, uintptr_t bodySize, bool pointerFree);
+#endif
+
+extern void il2c_initialize_gc_configuration__(void);
+extern bool il2c_consume_allocation_budget__(uintptr_t size);
+extern void il2c_initialize_generations__(void);
+extern void il2c_shutdown_generations__(void);
+extern void il2c_request_full_collection__(void);
+extern void il2c_request_compaction__(void);
+extern void il2c_notify_swept__(uintptr_t liveBytes, uintptr_t liveObjects, uintptr_t freedBytes);
+extern void il2c_initialize_mark_workers__(void);
+extern void il2c_shutdown_mark_workers__(void);
+extern void il2c_initialize_sweeper__(void);
+extern void il2c_shutdown_sweeper__(void);
+extern void il2c_initialize_finalizer__(void);
+extern void il2c_shutdown_finalizer__(void);
+extern void il2c_wait_for_pending_finalizers__(void);
+extern void il2c_register_finalizable__(System_Object* pAdjustedReference);
+#if defined(IL2C_USE_GETENV)
+extern uintptr_t il2c_get_environment_size__(const char* pName);
 #endif
 
-extern void il2c_register_root_reference__(void* pReference, bool isFixed);
-extern void il2c_unregister_root_reference__(void* pReference, bool isFixed);
+// Allocation profiler: The platform has to write the report file.
+#if defined(IL2C_USE_FILE_IO)
+#define IL2C_USE_ALLOCATION_PROFILER
+extern volatile uintptr_t g_AllocationSamplingBytes__;
+extern void il2c_sample_allocation__(IL2C_RUNTIME_TYPE type, uintptr_t size, const char* pFile, int line);
+#endif
+extern void il2c_initialize_allocation_profiler__(void);
+extern void il2c_shutdown_allocation_profiler__(void);
+
+// Heap walking: Enumerates the roots and the instances with their references while the mutators are stopped.
+#define IL2C_HEAP_ROOT_NONE 0U
+#define IL2C_HEAP_ROOT_STATIC_FIELD 1U
+#define IL2C_HEAP_ROOT_EXECUTION_FRAME 2U
+#define IL2C_HEAP_ROOT_ROOT_REFERENCE 3U
+#define IL2C_HEAP_ROOT_FIXED_REFERENCE 4U
+#define IL2C_HEAP_ROOT_FINALIZER_QUEUE 5U
+
+typedef struct IL2C_HEAP_WALKER_DECL
+{
+    // The instance is referred from the root.
+    void (*pRoot)(uint8_t rootKind, IL2C_REF_HEADER* pHeader, void* pContext);
+    // The instance, and the references from it are reported to pReference() after this.
+    void (*pInstance)(IL2C_REF_HEADER* pHeader, void* pContext);
+    void (*pReference)(IL2C_REF_HEADER* pHeader, void* pContext);
+    void* pContext;
+} IL2C_HEAP_WALKER;
+
+extern void il2c_walk_heap__(const IL2C_HEAP_WALKER* pWalker);
+
+// Heap snapshot: The platform has to write the snapshot file.
+extern void il2c_initialize_heap_snapshot__(void);
+extern void il2c_shutdown_heap_snapshot__(void);
+
+// The root reference handle is the index based (zero is invalid.)
+extern void il2c_initialize_root_references__(void);
+extern void il2c_shutdown_root_references__(void);
+extern uintptr_t il2c_register_root_reference__(void* pReference, bool isFixed);
+extern void il2c_unregister_root_reference__(uintptr_t handle, bool isFixed);
+extern System_Object* il2c_get_root_reference__(uintptr_t handle, bool isFixed);
+extern void il2c_set_root_reference__(uintptr_t handle, void* pReference, bool isFixed);
 
 extern void il2c_default_mark_handler_for_objref__(void* pReference);
 extern void il2c_default_mark_handler_for_value_type__(void* pValue, IL2C_RUNTIME_TYPE valueType);
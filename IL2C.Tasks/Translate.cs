@@ -38,6 +38,11 @@ namespace IL2C
             get; set;
         }
 
+        public bool EnableConservativeStackScanning
+        {
+            get; set;
+        }
+
         public string DebugInformation
         {
             get; set;
@@ -61,6 +66,7 @@ namespace IL2C
                 this.ReadSymbols,
                 this.EnableCpp,
                 this.EnableBundler,
+                this.EnableConservativeStackScanning,
                 debugInformation,
                 this.AssemblyPaths.
                     Select(path => path.ItemSpec.Trim()).
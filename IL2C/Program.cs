@@ -19,6 +19,7 @@ namespace IL2C
                 var readSymbols = true;
                 var enableBundler = false;
                 var enableCpp = false;
+                var enableConservativeStackScanning = false;
                 var help = false;
 
                 var options = new OptionSet()
@@ -28,6 +29,7 @@ namespace IL2C
                     { "no-read-symbols", "NO read symbol files", _ => readSymbols = false },
                     { "cpp", "Produce C++ extension files (apply extension *.cpp instead *.c, body will not change)", _ => enableCpp = true },
                     { "bundler", "Produce bundler source file", _ => enableBundler = true },
+                    { "conservative-stack-scan", "Don't link execution frames, the runtime scans the native stacks (requires IL2C_USE_CONSERVATIVE_STACK_SCAN)", _ => enableConservativeStackScanning = true },
                     { "h|help", "Print this help", _ => help = true },
                 };
 
@@ -48,6 +50,7 @@ namespace IL2C
                         readSymbols,
                         enableCpp,
                         enableBundler,
+                        enableConservativeStackScanning,
                         debugInformationOptions,
                         assemblyPaths);
                 }
@@ -10,6 +10,19 @@ namespace IL2C
         CauseBreak
     }
 
+    // It's same as IL2C_GC_FLAG_*, the test runs under il2c_configure_gc() if specified.
+    [Flags]
+    public enum TestCaseGCFlags
+    {
+        Default = 0x00,
+        Stress = 0x01,
+        DisableGenerational = 0x02,
+        BackgroundSweep = 0x04,
+        Compaction = 0x08,
+        Incremental = 0x10,
+        DisableTrim = 0x20
+    }
+
     // It's test case attribute contains expected value, method name and argument values at overall.
     [AttributeUsage(AttributeTargets.Class, AllowMultiple = true)]
     public sealed class TestCaseAttribute : Attribute
@@ -23,6 +36,8 @@ namespace IL2C
             this.Assert = TestCaseAsserts.PerfectMatch;
             this.IncludeBaseTypes = false;
             this.IncludeTypes = Type.EmptyTypes;
+            this.GCFlags = TestCaseGCFlags.Default;
+            this.GCMarkThreads = 0;
         }
 
         // This overload contains additional methods, those are used from the test method (first methodName is target.)
@@ -35,6 +50,8 @@ namespace IL2C
             this.Assert = TestCaseAsserts.PerfectMatch;
             this.IncludeBaseTypes = false;
             this.IncludeTypes = Type.EmptyTypes;
+            this.GCFlags = TestCaseGCFlags.Default;
+            this.GCMarkThreads = 0;
         }
 
         public string MethodName { get; }
@@ -45,5 +62,7 @@ namespace IL2C
         public TestCaseAsserts Assert { get; set; }
         public bool IncludeBaseTypes { get; set; }
         public Type[] IncludeTypes { get; set; }
+        public TestCaseGCFlags GCFlags { get; set; }
+        public int GCMarkThreads { get; set; }   // 0: default
     }
 }
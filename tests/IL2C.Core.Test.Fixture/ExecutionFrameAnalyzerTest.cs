@@ -0,0 +1,214 @@
+﻿using System;
+using System.Linq;
+
+using Mono.Cecil.Cil;
+using NUnit.Framework;
+
+using IL2C.Metadata;
+using IL2C.Translators;
+
+namespace IL2C
+{
+    // The target methods of the execution frame analyzer tests.
+    //   The objref locals are used twice, so they're the local variables on the release build too.
+    public sealed class ExecutionFrameAnalyzerTarget
+    {
+        public object Value;
+        public int Count;
+
+        public static int SurvivesCall(object value)
+        {
+            var str = value.ToString();
+            GC.Collect();
+            return str.Length + str.Length;
+        }
+
+        public static int SharesSlots(string value)
+        {
+            var first = value.Trim();
+            GC.Collect();
+            var length = first.Length + first.Length;
+            var second = value.ToUpper();
+            GC.Collect();
+            length += second.Length + second.Length;
+            var third = value.ToLower();
+            var fourth = value.ToUpperInvariant();
+            GC.Collect();
+            return length + third.Length + fourth.Length + third.Length + fourth.Length;
+        }
+
+        public static int NoObjRef(int value) =>
+            Math.Abs(value);
+
+        public int UsesThisAfterCall(int value)
+        {
+            GC.Collect();
+            return this.Count + value;
+        }
+
+        public static ExecutionFrameAnalyzerTarget Allocate() =>
+            new ExecutionFrameAnalyzerTarget();
+
+        public static ExecutionFrameAnalyzerTarget AllocatesInLoop(int count)
+        {
+            ExecutionFrameAnalyzerTarget head = null;
+            for (var index = 0; index < count; index++)
+            {
+                head = new ExecutionFrameAnalyzerTarget { Value = head };
+            }
+            return head;
+        }
+    }
+
+    [TestFixture]
+    [Parallelizable(ParallelScope.All)]
+    public sealed class ExecutionFrameAnalyzerTest
+    {
+        private static PreparedMethodInformation Prepare(string methodName)
+        {
+            var translateContext = new TranslateContext(typeof(ExecutionFrameAnalyzerTarget).Assembly, false);
+            var prepared = AssemblyPreparer.Prepare(
+                translateContext,
+                type => type.FriendlyName == typeof(ExecutionFrameAnalyzerTarget).FullName,
+                method => method.Name == methodName);
+            return prepared.Functions.Values.Single();
+        }
+
+        private static ICodeInformation[] GetCollectCalls(PreparedMethodInformation prepared) =>
+            prepared.Method.CodeStream.
+                Where(code => (code.OpCode.Code == Code.Call) &&
+                    (code.Operand is IMethodInformation method) &&
+                    (method.Name == nameof(GC.Collect))).
+                ToArray();
+
+        private static ILocalVariableInformation[] GetStringLocals(PreparedMethodInformation prepared) =>
+            prepared.Method.LocalVariables.
+                Where(variable => variable.TargetType.IsStringType).
+                ToArray();
+
+        private static ExecutionFrameSlot GetSlot(PreparedMethodInformation prepared, ILocalVariableInformation variable) =>
+            prepared.ObjRefSlots.Single(slot => slot.Variables.Contains(variable));
+
+        [Test]
+        public void ObjRefSurvivingCallKeepsSlot()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.SurvivesCall));
+
+            // The string lives across the GC.Collect(), so its slot isn't cleared there.
+            var str = GetStringLocals(prepared).Single();
+            var slot = GetSlot(prepared, str);
+            var collect = GetCollectCalls(prepared).Single();
+            Assert.IsFalse(
+                prepared.ObjRefSpills.TryGetValue(collect.Offset, out var spill) &&
+                spill.DeadSlots.Contains(slot));
+        }
+
+        [Test]
+        public void DisjointObjRefsShareSlot()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.SharesSlots));
+
+            // The first and second strings don't live at same time, but the third and fourth do.
+            var strs = GetStringLocals(prepared);
+            Assert.AreEqual(4, strs.Length);
+            Assert.AreSame(GetSlot(prepared, strs[0]), GetSlot(prepared, strs[1]));
+            Assert.AreNotSame(GetSlot(prepared, strs[2]), GetSlot(prepared, strs[3]));
+            Assert.IsTrue(prepared.ObjRefSlots.Any(slot => slot.IsShared));
+        }
+
+        [Test]
+        public void NoObjRefElidesExecutionFrame()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.NoObjRef));
+            Assert.IsFalse(prepared.RequiresExecutionFrame);
+            Assert.AreEqual(0, prepared.ObjRefSlots.Length);
+        }
+
+        [Test]
+        public void ObjRefSurvivingCallKeepsExecutionFrame()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.SurvivesCall));
+            Assert.IsTrue(prepared.RequiresExecutionFrame);
+        }
+
+        [Test]
+        public void ArgumentSurvivingCallElidesExecutionFrame()
+        {
+            // The caller holds the "this" argument, the method doesn't spill it.
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.UsesThisAfterCall));
+            Assert.IsFalse(prepared.RequiresExecutionFrame);
+            Assert.AreEqual(0, prepared.ObjRefSpills.Count);
+        }
+
+        [Test]
+        public void NewObjKeepsExecutionFrame()
+        {
+            // The slot holds the new instance while the constructor runs.
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.Allocate));
+            Assert.IsTrue(prepared.RequiresExecutionFrame);
+            Assert.IsTrue(prepared.ObjRefSlots.Any(slot =>
+                slot.Variables.Any(variable => variable.TargetType.Equals(prepared.Method.DeclaringType))));
+        }
+
+        [Test]
+        public void ObjRefSurvivingCallIsSpilled()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.SurvivesCall));
+
+            // The string is the C local variable, it's stored to the slot before the GC.Collect().
+            var str = GetStringLocals(prepared).Single();
+            var collect = GetCollectCalls(prepared).Single();
+            Assert.IsFalse(prepared.ResidentObjRefs.Contains(str));
+            Assert.IsTrue(prepared.ObjRefSpills[collect.Offset].Variables.Contains(str));
+        }
+
+        [Test]
+        public void SpilledObjRefsDontShareSlot()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.SharesSlots));
+
+            // The variables live at same GC point are spilled to the different slots,
+            // and these slots aren't cleared as the dead slots.
+            var collects = GetCollectCalls(prepared);
+            Assert.AreEqual(3, collects.Length);
+            foreach (var collect in collects)
+            {
+                var spill = prepared.ObjRefSpills[collect.Offset];
+                var slots = spill.Variables.
+                    Select(variable => GetSlot(prepared, variable)).
+                    ToArray();
+                Assert.AreEqual(slots.Length, slots.Distinct().Count());
+                Assert.IsFalse(spill.DeadSlots.Intersect(slots).Any());
+            }
+
+            var strs = GetStringLocals(prepared);
+            var lastSpill = prepared.ObjRefSpills[collects.Last().Offset];
+            Assert.IsTrue(lastSpill.Variables.Contains(strs[2]));
+            Assert.IsTrue(lastSpill.Variables.Contains(strs[3]));
+        }
+
+        [Test]
+        public void NewObjResultIsResident()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.Allocate));
+            var instance = prepared.ResidentObjRefs.Single();
+            Assert.AreEqual(prepared.Method.DeclaringType, instance.TargetType);
+            Assert.IsNotNull(GetSlot(prepared, instance));
+        }
+
+        [Test]
+        public void AllocationInLoopSpillsAtBackEdge()
+        {
+            var prepared = Prepare(nameof(ExecutionFrameAnalyzerTarget.AllocatesInLoop));
+            Assert.IsTrue(prepared.RequiresExecutionFrame);
+
+            // The list head lives across the safepoint poll at the backward branch.
+            // (The debug build declares the object initializer's temporary after it.)
+            var head = prepared.Method.LocalVariables.
+                First(variable => variable.TargetType.Equals(prepared.Method.DeclaringType));
+            var spill = prepared.ObjRefSpills.Values.Single(s => s.IsSafepointPoll);
+            Assert.IsTrue(spill.Variables.Contains(head));
+            Assert.IsNotNull(GetSlot(prepared, head));
+        }
+    }
+}
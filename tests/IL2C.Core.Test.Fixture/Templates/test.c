@@ -28,6 +28,7 @@ int main(int argc__, char** argv__)
     _crtBreakAlloc = -1;
 #endif
 
+    {configureGC}
     il2c_initialize();
 
     ////////////////////////
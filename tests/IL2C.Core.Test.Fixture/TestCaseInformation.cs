@@ -16,10 +16,13 @@ namespace IL2C
         public readonly object Expected;
         public readonly object[] Arguments;
         public readonly TestCaseAsserts Assert;
+        public readonly TestCaseGCFlags GCFlags;
+        public readonly int GCMarkThreads;
 
         public TestCaseInformation(
             string categoryName, string id, string name, string uniqueName, string description, object expected, TestCaseAsserts assert,
-            MethodInfo method, Type[] additionalTypes, MethodBase[] additionalMethods, object[] arguments)
+            MethodInfo method, Type[] additionalTypes, MethodBase[] additionalMethods, object[] arguments,
+            TestCaseGCFlags gcFlags, int gcMarkThreads)
         {
             this.CategoryName = categoryName;
             this.Id = id;
@@ -32,6 +35,8 @@ namespace IL2C
             this.Expected = expected;
             this.Arguments = arguments;
             this.Assert = assert;
+            this.GCFlags = gcFlags;
+            this.GCMarkThreads = gcMarkThreads;
         }
 
         public override string ToString()
@@ -227,6 +227,7 @@ namespace IL2C
                 translateContext,
                 prepared,
                 true,
+                false,
                 DebugInformationOptions.CommentOnly);
 
             // Step 1-5: Write source code into a file from template.
@@ -312,10 +313,20 @@ namespace IL2C
                 Any(entry => (entry.SymbolName == "_actual") && entry.TargetType.IsReferenceType) ?
                     "frame__._actual" :
                     "_actual";
+            // The GC configuration is applied at il2c_initialize() if the test case requires.
+            var configureGC =
+                ((caseInfo.GCFlags != TestCaseGCFlags.Default) || (caseInfo.GCMarkThreads >= 1)) ?
+                    string.Format(
+                        "{{ IL2C_GC_CONFIGURATION configuration = {{ 0 }}; configuration.flags = 0x{0:x}U; configuration.markThreads = {1}U; il2c_configure_gc(&configuration); }}",
+                        (int)caseInfo.GCFlags,
+                        caseInfo.GCMarkThreads) :
+                    string.Empty;
+
             var replaceValues = new Dictionary<string, object>
             {
                 { "assemblyName", targetMethod.DeclaringType.DeclaringModule.DeclaringAssembly.Name},
                 { "testName", targetMethod.FriendlyName},
+                { "configureGC", configureGC },
                 { "type", targetMethod.ReturnType.CLanguageTypeName},
                 { "constants", string.Join(" ", constants.
                     Select(entry => string.Format("{0} {1} = {2};",
@@ -92,7 +92,9 @@ namespace IL2C
                 additionalMethods,
                 caseAttribute.Arguments.
                     Zip(method.GetParameters().Select(p => p.ParameterType), (arg, type) => ConvertToArgumentType(arg, type)).
-                    ToArray());
+                    ToArray(),
+                caseAttribute.GCFlags,
+                caseAttribute.GCMarkThreads);
 
         private static IEnumerable<Type> TraverseTypes(Type targetType, bool includeBaseTypes) =>
             includeBaseTypes ?
@@ -73,6 +73,22 @@ namespace IL2C.RuntimeSystems
         }
     }
 
+    public class SlowFinalizerImplemented
+    {
+        private FinalizerCalleeHolder holder;
+
+        public SlowFinalizerImplemented(FinalizerCalleeHolder holder)
+        {
+            this.holder = holder;
+        }
+
+        ~SlowFinalizerImplemented()
+        {
+            Thread.Sleep(10);
+            holder.Called++;
+        }
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     public class FinalzerImplementedWithPinned
     {
@@ -151,6 +167,30 @@ namespace IL2C.RuntimeSystems
 
     public delegate string DelegateMarkHandlerForObjRefTestDelegate(string b);
 
+    public sealed class CompactionTarget
+    {
+        private readonly string str;
+
+        public CompactionTarget(string str) => this.str = str;
+
+        public string CollectAndCombine(string v)
+        {
+            // The compaction may evacuate this instance, "this" has to be valid after the collection.
+            GC.Collect();
+            return str + v;
+        }
+    }
+
+    public sealed class OldInstanceHolder
+    {
+        public ObjRefInsideObjRefType Value;
+    }
+
+    public sealed class DeepLinkedListNode
+    {
+        public DeepLinkedListNode Next;
+    }
+
     public sealed class ConcurrentCollectClosure
     {
         private bool abort;
@@ -175,6 +215,47 @@ namespace IL2C.RuntimeSystems
             this.Value = value * 2;
     }
 
+    public sealed class ConcurrentSweepClosure
+    {
+        private readonly int count;
+        private int failed;
+
+        public ConcurrentSweepClosure(int count) =>
+            this.count = count;
+
+        public int Failed =>
+            failed;
+
+        public void Run()
+        {
+            for (var round = 0; round < 10; round++)
+            {
+                // The garbages are swept while allocating the next list.
+                DeepLinkedListNode head = null;
+                for (var index = 0; index < count; index++)
+                {
+                    var node = new DeepLinkedListNode();
+                    node.Next = head;
+                    head = node;
+                    new DeepLinkedListNode();
+                }
+
+                GC.Collect();
+
+                var length = 0;
+                while (head != null)
+                {
+                    length++;
+                    head = head.Next;
+                }
+                if (length != count)
+                {
+                    failed++;
+                }
+            }
+        }
+    }
+
     [Description("These tests are verified the IL2C manages tracing the object references and collect garbages from the heap memory.")]
     [TestCase("ABCDEF", "ObjRefInsideObjRef", IncludeTypes = new[] { typeof(ObjRefInsideObjRefType) })]
     [TestCase("ABCDEF", "ObjRefInsideValueType", IncludeTypes = new[] { typeof(ObjRefInsideValueTypeType) })]
@@ -192,12 +273,24 @@ namespace IL2C.RuntimeSystems
     [TestCase(1, new[] { "CallFinalizerByCollectWithGeneration", "RunCallFinalizer" }, 0, IncludeTypes = new[] { typeof(FinalzerImplemented), typeof(FinalizerCalleeHolder) })]
     [TestCase(1, new[] { "CallFinalizerByCollectWithGeneration", "RunCallFinalizer" }, 1, IncludeTypes = new[] { typeof(FinalzerImplemented), typeof(FinalizerCalleeHolder) })]
     [TestCase(1, new[] { "CallFinalizerByCollectWithGeneration", "RunCallFinalizer" }, 2, IncludeTypes = new[] { typeof(FinalzerImplemented), typeof(FinalizerCalleeHolder) })]
+    [TestCase(10, new[] { "WaitForSlowFinalizers", "RunSlowFinalizers" }, 10, IncludeTypes = new[] { typeof(SlowFinalizerImplemented), typeof(FinalizerCalleeHolder) })]
     [TestCase(0, new[] { "DontCallFinalizerByCollectWithPinned", "RunDontCallFinalizerWithPinned" }, IncludeTypes = new[] { typeof(FinalzerImplementedWithPinned), typeof(FinalizerCalleeHolder) })]
     [TestCase(123, new[] { "DontCollectWithResurrect", "RunDontCollectWithResurrect" }, 123, IncludeTypes = new[] { typeof(FinalzerImplementedWithResurrect) })]
     [TestCase(2, new[] { "CallFinalizerByCollectWithReRegister", "RunCallFinalizerWithReRegister" }, IncludeTypes = new[] { typeof(FinalzerImplementedWithReRegister), typeof(FinalizerCalleeHolder) })]
     [TestCase(0, new[] { "SuppressFinalize", "RunCallFinalizerWithSuppressed" }, IncludeTypes = new[] { typeof(FinalzerImplemented), typeof(FinalizerCalleeHolder) })]
     [TestCase(1, new[] { "ReRegisterForFinalize", "RunCallFinalizerWithSuppressedAndReRegistered" }, IncludeTypes = new[] { typeof(FinalzerImplemented), typeof(FinalizerCalleeHolder) })]
+    [TestCase("ABCDEF", "OldToYoungReferenceByField", "ABC", "DEF", IncludeTypes = new[] { typeof(OldInstanceHolder), typeof(ObjRefInsideObjRefType) })]
+    [TestCase("ABCDEF", "OldToYoungReferenceByArray", "ABC", "DEF", IncludeTypes = new[] { typeof(ObjRefInsideObjRefType) })]
+    [TestCase("ABCDEF", new[] { "OldToYoungReferenceByManagedReference", "StoreByManagedReference" }, "ABC", "DEF", IncludeTypes = new[] { typeof(OldInstanceHolder), typeof(ObjRefInsideObjRefType) })]
+    [TestCase(1000000, "DeepLinkedList", 1000000, IncludeTypes = new[] { typeof(DeepLinkedListNode) })]
     [TestCase(2000000, "ConcurrentCollect", 10, 1000000, IncludeTypes = new[] { typeof(ConcurrentCollectClosure), typeof(ConcurrentCollectValueHolder) })]
+    [TestCase(0, "AllocateWhileSweeping", 4, 100000, IncludeTypes = new[] { typeof(ConcurrentSweepClosure), typeof(DeepLinkedListNode) })]
+    [TestCase(0, "AllocateWhileSweeping", 4, 100000, IncludeTypes = new[] { typeof(ConcurrentSweepClosure), typeof(DeepLinkedListNode) }, GCFlags = TestCaseGCFlags.BackgroundSweep)]
+    [TestCase("ABCDEF", new[] { "CompactionWithThisReference", "MakeCompactionTarget" }, "ABC", "DEF", IncludeTypes = new[] { typeof(CompactionTarget), typeof(DelegateMarkHandlerForObjRefTestDelegate) }, GCFlags = TestCaseGCFlags.Compaction)]
+    [TestCase(100000, "WideGraphByParallelMarking", 100000, IncludeTypes = new[] { typeof(DeepLinkedListNode) }, GCMarkThreads = 4)]
+    [TestCase(50000, "IncrementalMarkingWhileMutating", 50000, 8, IncludeTypes = new[] { typeof(DeepLinkedListNode) }, GCFlags = TestCaseGCFlags.Incremental | TestCaseGCFlags.DisableGenerational)]
+    [TestCase(true, "CollectionCount")]
+    [TestCase(true, "GetTotalMemory", 100000)]
     public sealed class GarbageCollection
     {
         [MethodImpl(MethodImplOptions.ForwardRef)]
@@ -303,6 +396,26 @@ namespace IL2C.RuntimeSystems
             var implemented = new FinalzerImplemented(holder);
         }
 
+        private static void RunSlowFinalizers(FinalizerCalleeHolder holder, int count)
+        {
+            for (var index = 0; index < count; index++)
+            {
+                var implemented = new SlowFinalizerImplemented(holder);
+            }
+        }
+
+        public static int WaitForSlowFinalizers(int count)
+        {
+            var holder = new FinalizerCalleeHolder();
+            RunSlowFinalizers(holder, count);
+
+            // The finalizers run outside of the collection, so WaitForPendingFinalizers has to block until finished.
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            return holder.Called;
+        }
+
         public static int CallFinalizerByCollect()
         {
             var holder = new FinalizerCalleeHolder();
@@ -416,6 +529,74 @@ namespace IL2C.RuntimeSystems
             return holder.Called;
         }
 
+        public static string OldToYoungReferenceByField(string a, string b)
+        {
+            // Promote to the old generation.
+            var holder = new OldInstanceHolder();
+            GC.Collect();
+
+            // The minor collection has to trace the young instance from the old instance.
+            holder.Value = new ObjRefInsideObjRefType(a + b);
+            GC.Collect(0);
+            GC.WaitForPendingFinalizers();
+
+            return holder.Value.Value;
+        }
+
+        public static string OldToYoungReferenceByArray(string a, string b)
+        {
+            // Promote to the old generation.
+            var holder = new ObjRefInsideObjRefType[1];
+            GC.Collect();
+
+            // The minor collection has to trace the young instance from the old array.
+            holder[0] = new ObjRefInsideObjRefType(a + b);
+            GC.Collect(0);
+            GC.WaitForPendingFinalizers();
+
+            return holder[0].Value;
+        }
+
+        private static void StoreByManagedReference(ref ObjRefInsideObjRefType target, string value) =>
+            target = new ObjRefInsideObjRefType(value);
+
+        public static string OldToYoungReferenceByManagedReference(string a, string b)
+        {
+            // Promote to the old generation.
+            var holder = new OldInstanceHolder();
+            GC.Collect();
+
+            // The minor collection has to trace the young instance from the old instance.
+            StoreByManagedReference(ref holder.Value, a + b);
+            GC.Collect(0);
+            GC.WaitForPendingFinalizers();
+
+            return holder.Value.Value;
+        }
+
+        public static int DeepLinkedList(int count)
+        {
+            // The marker doesn't consume the native stack by the list length.
+            DeepLinkedListNode head = null;
+            for (var index = 0; index < count; index++)
+            {
+                var node = new DeepLinkedListNode();
+                node.Next = head;
+                head = node;
+            }
+
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            var result = 0;
+            while (head != null)
+            {
+                result++;
+                head = head.Next;
+            }
+            return result;
+        }
+
         public static int ConcurrentCollect(int count, int increments)
         {
             var target = new ConcurrentCollectClosure();
@@ -445,5 +626,145 @@ namespace IL2C.RuntimeSystems
 
             return result;
         }
+
+        public static int AllocateWhileSweeping(int count, int length)
+        {
+            // The dead instances from the last collection are swept lazily (or by the sweeper thread)
+            // while the threads allocate.
+            var targets = new ConcurrentSweepClosure[count];
+            var threads = new Thread[count];
+            for (var index = 0; index < count; index++)
+            {
+                targets[index] = new ConcurrentSweepClosure(length);
+                threads[index] = new Thread(targets[index].Run);
+            }
+            for (var index = 0; index < count; index++)
+            {
+                threads[index].Start();
+            }
+
+            var failed = 0;
+            for (var index = 0; index < count; index++)
+            {
+                threads[index].Join();
+                failed += targets[index].Failed;
+            }
+
+            return failed;
+        }
+
+        private static DelegateMarkHandlerForObjRefTestDelegate MakeCompactionTarget(string a)
+        {
+            // Most instances in the heap block are garbage, so the compaction evacuates the target.
+            DelegateMarkHandlerForObjRefTestDelegate d = null;
+            for (var index = 0; index < 1000; index++)
+            {
+                var target = new CompactionTarget(a);
+                if (index == 500)
+                {
+                    d = new DelegateMarkHandlerForObjRefTestDelegate(target.CollectAndCombine);
+                }
+            }
+            return d;
+        }
+
+        public static string CompactionWithThisReference(string a, string b)
+        {
+            // The target is referred only from the delegate,
+            // the delegate invoker passes it to the "this" argument directly.
+            var d = MakeCompactionTarget(a);
+            return d(b);
+        }
+
+        public static int WideGraphByParallelMarking(int count)
+        {
+            // Promote to the old generation.
+            var nodes = new DeepLinkedListNode[count];
+            GC.Collect();
+
+            // The minor collection traces the young instances from the old array by the mark workers.
+            for (var index = 0; index < count; index++)
+            {
+                var node = new DeepLinkedListNode();
+                node.Next = new DeepLinkedListNode();
+                nodes[index] = node;
+            }
+            GC.Collect(0);
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            var result = 0;
+            for (var index = 0; index < count; index++)
+            {
+                if ((nodes[index].Next != null) && (nodes[index].Next.Next == null))
+                {
+                    result++;
+                }
+            }
+            return result;
+        }
+
+        public static int IncrementalMarkingWhileMutating(int count, int rounds)
+        {
+            // Promote to the old generation, the array is traced by the chunks.
+            var nodes = new DeepLinkedListNode[count];
+            for (var index = 0; index < count; index++)
+            {
+                nodes[index] = new DeepLinkedListNode();
+            }
+            GC.Collect();
+
+            // Every collection is the incremental full marking, the old nodes are mutated between the increments.
+            for (var round = 0; round < rounds; round++)
+            {
+                for (var index = 0; index < count; index++)
+                {
+                    var node = new DeepLinkedListNode();
+                    node.Next = nodes[index].Next;
+                    nodes[index].Next = node;
+                }
+                for (var index = 0; index < count; index++)
+                {
+                    new DeepLinkedListNode();
+                }
+            }
+
+            var result = 0;
+            for (var index = 0; index < count; index++)
+            {
+                var length = 0;
+                var current = nodes[index].Next;
+                while (current != null)
+                {
+                    length++;
+                    current = current.Next;
+                }
+                if (length == rounds)
+                {
+                    result++;
+                }
+            }
+            return result;
+        }
+
+        public static bool CollectionCount()
+        {
+            var minor = GC.CollectionCount(0);
+            var full = GC.CollectionCount(1);
+
+            GC.Collect();
+
+            // The full collection is counted by both generations.
+            return (GC.CollectionCount(0) > minor) && (GC.CollectionCount(1) > full);
+        }
+
+        public static bool GetTotalMemory(int length)
+        {
+            var before = GC.GetTotalMemory(true);
+            var array = new int[length];
+            var after = GC.GetTotalMemory(true);
+
+            return ((after - before) >= (length * sizeof(int))) && (array.Length == length);
+        }
     }
 }